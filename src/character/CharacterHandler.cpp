@@ -64,9 +64,19 @@ void CharacterHandler::enumerate(std::uint32_t account_id, std::uint32_t realm_i
                                  EnumResultCB callback) const {
 	LOG_TRACE(logger_) << __func__ << LOG_ASYNC;
 
-	pool_.run([=] {
-		do_enumerate(account_id, realm_id, callback);
+	auto queued = dao_.characters_async(account_id, realm_id, [this, callback](auto result) {
+		try {
+			callback(result.get());
+		} catch(std::exception& e) { // pool checkout failures aren't translated by the DAO
+			LOG_ERROR(logger_) << e.what() << LOG_ASYNC;
+			callback(boost::optional<std::vector<Character>>());
+		}
 	});
+
+	if(!queued) {
+		LOG_WARN(logger_) << "Database queue full, refusing character enumeration" << LOG_ASYNC;
+		callback(boost::optional<std::vector<Character>>());
+	}
 }
 
 void CharacterHandler::rename(std::uint32_t account_id, std::uint64_t character_id,
@@ -223,17 +233,6 @@ void CharacterHandler::do_erase(std::uint32_t account_id, std::uint32_t realm_id
 	callback(protocol::Result::CHAR_DELETE_FAILED);
 }
 
-void CharacterHandler::do_enumerate(std::uint32_t account_id, std::uint32_t realm_id,
-                                    const EnumResultCB& callback) const try {
-	LOG_TRACE(logger_) << __func__ << LOG_ASYNC;
-
-	auto characters = dao_.characters(account_id, realm_id);
-	callback(std::move(characters));
-} catch(dal::exception& e) {
-	LOG_ERROR(logger_) << e.what() << LOG_ASYNC;
-	callback(boost::optional<std::vector<Character>>());
-}
-
 void CharacterHandler::do_rename(std::uint32_t account_id, std::uint64_t character_id,
                                  const std::string& name, const RenameCB& callback) const try {
 	LOG_TRACE(logger_) << __func__ << LOG_ASYNC;
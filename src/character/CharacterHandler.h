@@ -61,9 +61,6 @@ class CharacterHandler {
 	void do_erase(std::uint32_t account_id, std::uint32_t realm_id,
 	              std::uint64_t character_id, const ResultCB& callback) const;
 
-	void do_enumerate(std::uint32_t account_id, std::uint32_t realm_id,
-	                  const EnumResultCB& callback) const;
-
 	void do_rename(std::uint32_t account_id, std::uint64_t character_id,
 	               const std::string& name, const RenameCB& callback) const;
 
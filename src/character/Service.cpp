@@ -8,6 +8,7 @@
 
 #include "Service.h"
 #include <game_protocol/ResultCodes.h>
+#include <algorithm>
 
  /* TODO, TEMPORARY CODE FOR EXPERIMENTATION */
 
@@ -30,12 +31,18 @@ Service::~Service() {
 
 void Service::handle_link_event(const spark::Link& link, spark::LinkState event) {
 	switch(event) {
-		case spark::LinkState::LINK_UP:
+		case spark::LinkState::LINK_UP: {
 			LOG_DEBUG(logger_) << "Link up: " << link.description << LOG_ASYNC;
+			std::lock_guard<std::mutex> guard(links_lock_);
+			links_.emplace_back(link);
 			break;
-		case spark::LinkState::LINK_DOWN:
+		}
+		case spark::LinkState::LINK_DOWN: {
 			LOG_DEBUG(logger_) << "Link down: " << link.description << LOG_ASYNC;
+			std::lock_guard<std::mutex> guard(links_lock_);
+			links_.erase(std::remove(links_.begin(), links_.end(), link), links_.end());
 			break;
+		}
 	}
 }
 
@@ -85,9 +92,16 @@ void Service::create_character(const spark::Link& link, const em::MessageRoot* r
 		return;
 	}
 
-	handler_.create(msg->account_id(), msg->realm_id(), *msg->character(), [&, link, tracking](auto res) {
+	const auto account_id = msg->account_id();
+	const auto realm_id = msg->realm_id();
+
+	handler_.create(account_id, realm_id, *msg->character(), [&, link, tracking, account_id, realm_id](auto res) {
 		LOG_DEBUG(logger_) << "Create response code: " << protocol::to_string(res) << LOG_ASYNC;
 		send_response(link, tracking, messaging::character::Status::OK, res);
+
+		if(res == protocol::Result::CHAR_CREATE_SUCCESS) {
+			send_count_update(account_id, realm_id, 1);
+		}
 	});
 }
 
@@ -211,15 +225,48 @@ void Service::send_response(const spark::Link& link, const std::vector<std::uint
 	spark_.send(link, fbb);
 }
 
+// lets the login servers keep their cached character counts current
+void Service::send_count_update(std::uint32_t account_id, std::uint32_t realm_id, std::int32_t delta) {
+	LOG_TRACE(logger_) << __func__ << LOG_ASYNC;
+
+	auto fbb = std::make_shared<flatbuffers::FlatBufferBuilder>();
+	em::character::CountUpdateBuilder cub(*fbb);
+	cub.add_account_id(account_id);
+	cub.add_realm_id(realm_id);
+	cub.add_delta(delta);
+	auto data_offset = cub.Finish();
+
+	em::MessageRootBuilder mrb(*fbb);
+	mrb.add_service(em::Service::Character);
+	mrb.add_data_type(em::Data::CountUpdate);
+	mrb.add_data(data_offset.Union());
+
+	auto mloc = mrb.Finish();
+	fbb->Finish(mloc);
+
+	std::lock_guard<std::mutex> guard(links_lock_);
+
+	for(const auto& link : links_) {
+		spark_.send(link, fbb);
+	}
+}
+
 void Service::delete_character(const spark::Link& link, const em::MessageRoot* root) {
 	LOG_TRACE(logger_) << __func__ << LOG_ASYNC;
 
 	auto msg = static_cast<const em::character::Delete*>(root->data());
 	std::vector<std::uint8_t> tracking(root->tracking_id()->begin(), root->tracking_id()->end());
 
-	handler_.erase(msg->account_id(), msg->realm_id(), msg->character_id(), [&, link, tracking](auto res) {
+	const auto account_id = msg->account_id();
+	const auto realm_id = msg->realm_id();
+
+	handler_.erase(account_id, realm_id, msg->character_id(), [&, link, tracking, account_id, realm_id](auto res) {
 		LOG_DEBUG(logger_) << "Deletion response code: " << protocol::to_string(res) << LOG_ASYNC;
 		send_response(link, tracking, messaging::character::Status::OK, res);
+
+		if(res == protocol::Result::CHAR_DELETE_SUCCESS) {
+			send_count_update(account_id, realm_id, -1);
+		}
 	});
 }
 
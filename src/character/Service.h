@@ -14,7 +14,9 @@
 #include <spark/temp/Character_generated.h>
 #include <spark/temp/MessageRoot_generated.h>
 #include <logger/Logging.h>
+#include <mutex>
 #include <string>
+#include <vector>
 #include <cstdint>
 
 namespace ember {
@@ -25,6 +27,8 @@ class Service final : public spark::EventHandler {
 	spark::Service& spark_;
 	spark::ServiceDiscovery& discovery_;
 	log::Logger* logger_;
+	std::vector<spark::Link> links_;
+	std::mutex links_lock_;
 
 	void retrieve_characters(const spark::Link& link, const messaging::MessageRoot* root);
 	void create_character(const spark::Link& link, const messaging::MessageRoot* root);
@@ -37,6 +41,8 @@ class Service final : public spark::EventHandler {
 	void send_response(const spark::Link& link, const std::vector<std::uint8_t>& tracking,
 	                   messaging::character::Status status, protocol::Result result);
 
+	void send_count_update(std::uint32_t account_id, std::uint32_t realm_id, std::int32_t delta);
+
 	void send_rename_response(const spark::Link& link, const std::vector<std::uint8_t>& tracking,
 	                          messaging::character::Status status, protocol::Result result,
 	                          boost::optional<Character> character);
@@ -12,11 +12,15 @@
 #include <dbcreader/DBCReader.h>
 #include <spark/Spark.h>
 #include <conpool/ConnectionPool.h>
+#include <conpool/AsyncExecutor.h>
 #include <conpool/Policies.h>
 #include <conpool/drivers/AutoSelect.h>
 #include <logger/Logging.h>
 #include <shared/Banner.h>
 #include <shared/database/daos/CharacterDAO.h>
+#include <shared/metrics/MetricsImpl.h>
+#include <shared/metrics/MetricsPoll.h>
+#include <shared/metrics/PoolMetrics.h>
 #include <shared/threading/ThreadPool.h>
 #include <shared/Version.h>
 #include <shared/util/LogConfig.h>
@@ -27,6 +31,7 @@
 #include <chrono>
 #include <iostream>
 #include <fstream>
+#include <memory>
 #include <string>
 #include <vector>
 #include <stdexcept>
@@ -130,8 +135,13 @@ void launch(const po::variables_map& args, log::Logger* logger) try {
 		pool_log_callback(severity, message, logger);
 	});
 
+	LOG_INFO(logger) << "Starting database threads..." << LOG_SYNC;
+	auto db_threads = args["database.async_threads"].as<unsigned short>();
+	auto db_backlog = args["database.async_backlog"].as<std::size_t>();
+	ep::AsyncExecutor<decltype(pool)> db_executor(pool, db_threads, db_backlog);
+
 	LOG_INFO(logger) << "Initialising DAOs..." << LOG_SYNC;
-	auto character_dao = ember::dal::character_dao(pool);
+	auto character_dao = ember::dal::character_dao(pool, &db_executor);
 
 	std::locale temp;
 
@@ -146,6 +156,28 @@ void launch(const po::variables_map& args, log::Logger* logger) try {
 	boost::asio::io_service service;
 	boost::asio::signal_set signals(service, SIGINT, SIGTERM);
 
+	// Start metrics service
+	auto metrics = std::make_unique<ember::Metrics>();
+
+	if(args["metrics.enabled"].as<bool>()) {
+		LOG_INFO(logger) << "Starting metrics service..." << LOG_SYNC;
+		metrics = std::make_unique<ember::MetricsImpl>(
+			service, args["metrics.statsd_host"].as<std::string>(),
+			args["metrics.statsd_port"].as<std::uint16_t>()
+		);
+	}
+
+	ember::MetricsPoll poller(service, *metrics);
+
+	poller.add_source([&pool](ember::Metrics& metrics) {
+		metrics.gauge("db_connections", pool.size());
+		ember::report_pool_stats(metrics, pool.reset_stats());
+	}, 5s);
+
+	poller.add_source([&db_executor](ember::Metrics& metrics) {
+		metrics.gauge("db_queue_depth", db_executor.queue_depth());
+	}, 5s);
+
 	ThreadPool thread_pool(concurrency);
 	ember::CharacterHandler handler(std::move(profanity), std::move(reserved), std::move(spam),
 	                                dbc_store, *character_dao, thread_pool, temp, logger);
@@ -158,9 +190,11 @@ void launch(const po::variables_map& args, log::Logger* logger) try {
 	
 	signals.async_wait([&](const boost::system::error_code& error, int signal) {
 		LOG_INFO(logger) << APP_NAME << " shutting down..." << LOG_SYNC;
+		poller.shutdown();
 		discovery.shutdown();
 		spark.shutdown();
 		thread_pool.shutdown();
+		db_executor.shutdown();
 		pool.close();
 	});
 
@@ -213,6 +247,8 @@ po::variables_map parse_arguments(int argc, const char* argv[]) {
 		("database.config_path", po::value<std::string>()->required())
 		("database.min_connections", po::value<unsigned short>()->required())
 		("database.max_connections", po::value<unsigned short>()->required())
+		("database.async_threads", po::value<unsigned short>()->default_value(4))
+		("database.async_backlog", po::value<std::size_t>()->default_value(1024))
 		("metrics.enabled", po::value<bool>()->required())
 		("metrics.statsd_host", po::value<std::string>()->required())
 		("metrics.statsd_port", po::value<std::uint16_t>()->required())
@@ -10,8 +10,8 @@
 
 #include "Event.h"
 #include "ClientHandler.h"
-#include "ServicePool.h"
 #include <shared/ClientUUID.h>
+#include <shared/threading/ServicePool.h>
 #include <memory>
 #include <unordered_map>
 
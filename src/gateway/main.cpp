@@ -10,7 +10,6 @@
 #include "Locator.h"
 #include "FilterTypes.h"
 #include "RealmQueue.h"
-#include "ServicePool.h"
 #include "AccountService.h"
 #include "EventDispatcher.h"
 #include "CharacterService.h"
@@ -26,6 +25,7 @@
 #include <shared/Version.h>
 #include <shared/util/Utility.h>
 #include <shared/util/LogConfig.h>
+#include <shared/threading/ServicePool.h>
 #include <dbcreader/DBCReader.h>
 #include <shared/database/daos/RealmDAO.h>
 #include <shared/database/daos/UserDAO.h>
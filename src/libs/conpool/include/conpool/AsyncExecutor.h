@@ -0,0 +1,283 @@
+/*
+ * Copyright (c) 2016 Ember
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include "Exception.h"
+#include <boost/optional.hpp>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <cstddef>
+
+namespace ember { namespace connection_pool {
+
+using namespace std::chrono_literals;
+
+// runs a completion wherever the caller wants it, such as its own io_service or thread pool
+typedef std::function<void(std::function<void()>)> Dispatcher;
+
+/*
+ * Runs queries on a dedicated set of database threads, so callers don't
+ * have to block their own threads waiting on checkouts and round trips.
+ * Each database thread holds on to a connection for as long as it has work,
+ * handing it back to the pool once the queue runs dry so the pool's manager
+ * can keep it alive.
+ *
+ * Work is a callable taking the driver's connection type. Its result, or
+ * the exception it threw, is delivered through a future or to a callback
+ * that's given the completed future. Callbacks run on the database thread
+ * unless a dispatcher is supplied to move them elsewhere.
+ *
+ * The queue is bounded - submit blocks while it's full, pushing back on the
+ * caller, whereas try_submit refuses the work so the caller can shed load.
+ */
+template<typename PoolType>
+class AsyncExecutor final {
+	using Conn = decltype(std::declval<PoolType&>().wait_connection());
+	using ConType = decltype(*std::declval<Conn&>());
+
+	template<typename Func>
+	using Result = decltype(std::declval<Func&>()(std::declval<ConType>()));
+
+	struct Job {
+		std::function<bool(ConType)> run; // returns false if the work threw
+		std::function<void(std::exception_ptr)> fail;
+	};
+
+	PoolType& pool_;
+	const std::size_t max_queued_;
+	const std::chrono::milliseconds checkout_timeout_;
+	std::deque<Job> queue_;
+	std::mutex lock_;
+	std::condition_variable work_cond_, space_cond_;
+	std::vector<std::thread> workers_;
+	bool stopped_;
+
+	template<typename R, typename Func>
+	static void fulfil(std::promise<R>& promise, Func& work, ConType conn) {
+		promise.set_value(work(conn));
+	}
+
+	template<typename Func>
+	static void fulfil(std::promise<void>& promise, Func& work, ConType conn) {
+		work(conn);
+		promise.set_value();
+	}
+
+	template<typename Func>
+	static Job make_job(std::shared_ptr<std::promise<Result<Func>>> promise, Func work,
+	                    std::function<void()> complete) {
+		return {
+			[promise, work, complete](ConType conn) mutable {
+				bool success = true;
+
+				try {
+					fulfil(*promise, work, conn);
+				} catch(...) {
+					promise->set_exception(std::current_exception());
+					success = false;
+				}
+
+				if(complete) {
+					complete();
+				}
+
+				return success;
+			},
+			[promise, complete](std::exception_ptr error) {
+				promise->set_exception(error);
+
+				if(complete) {
+					complete();
+				}
+			}
+		};
+	}
+
+	template<typename R, typename Callback>
+	static std::function<void()> completion(std::shared_ptr<std::promise<R>> promise,
+	                                        Callback callback, Dispatcher dispatcher) {
+		return [promise, callback, dispatcher]() {
+			if(dispatcher) {
+				dispatcher([promise, callback]() {
+					callback(promise->get_future());
+				});
+			} else {
+				callback(promise->get_future());
+			}
+		};
+	}
+
+	bool enqueue(Job job, bool block) {
+		std::unique_lock<std::mutex> guard(lock_);
+
+		while(!stopped_ && max_queued_ && queue_.size() >= max_queued_) {
+			if(!block) {
+				return false;
+			}
+
+			space_cond_.wait(guard);
+		}
+
+		if(stopped_) {
+			throw exception("Submitted database work after shutdown");
+		}
+
+		queue_.emplace_back(std::move(job));
+		guard.unlock();
+		work_cond_.notify_one();
+		return true;
+	}
+
+	/*
+	 * Work that fails drops the connection in case it was the cause, so the
+	 * pool gets a chance to check it before anything else runs on it
+	 */
+	void worker() {
+		boost::optional<Conn> conn;
+		std::unique_lock<std::mutex> guard(lock_);
+
+		while(true) {
+			if(queue_.empty()) {
+				if(stopped_) {
+					break;
+				}
+
+				if(conn) {
+					guard.unlock();
+					conn = boost::none;
+					guard.lock();
+					continue;
+				}
+
+				work_cond_.wait(guard);
+				continue;
+			}
+
+			auto job = std::move(queue_.front());
+			queue_.pop_front();
+			guard.unlock();
+			space_cond_.notify_one();
+
+			std::exception_ptr checkout_error;
+
+			try {
+				if(!conn) {
+					conn = pool_.wait_connection(checkout_timeout_);
+				}
+			} catch(...) {
+				checkout_error = std::current_exception();
+			}
+
+			try {
+				if(checkout_error) {
+					job.fail(checkout_error);
+				} else if(!job.run(**conn)) {
+					conn = boost::none;
+				}
+			} catch(...) {
+				// a throwing callback mustn't take a database thread down with it
+				conn = boost::none;
+			}
+
+			guard.lock();
+		}
+	}
+
+public:
+	/*
+	 * max_queued bounds the work waiting for a database thread - zero means
+	 * unbounded. The thread count shouldn't exceed the pool's maximum size.
+	 */
+	AsyncExecutor(PoolType& pool, std::size_t threads, std::size_t max_queued,
+	              std::chrono::milliseconds checkout_timeout = 5s)
+	              : pool_(pool), max_queued_(max_queued), checkout_timeout_(checkout_timeout),
+	                stopped_(false) {
+		if(!threads) {
+			throw exception("Asynchronous executor needs at least one thread");
+		}
+
+		for(std::size_t i = 0; i < threads; ++i) {
+			workers_.emplace_back(&AsyncExecutor::worker, this);
+		}
+	}
+
+	~AsyncExecutor() {
+		shutdown();
+	}
+
+	template<typename Func>
+	std::future<Result<Func>> submit(Func work) {
+		auto promise = std::make_shared<std::promise<Result<Func>>>();
+		auto future = promise->get_future();
+		enqueue(make_job(promise, std::move(work), nullptr), true);
+		return future;
+	}
+
+	template<typename Func, typename Callback>
+	void submit(Func work, Callback callback, Dispatcher dispatcher = nullptr) {
+		auto promise = std::make_shared<std::promise<Result<Func>>>();
+		auto complete = completion(promise, std::move(callback), std::move(dispatcher));
+		enqueue(make_job(promise, std::move(work), std::move(complete)), true);
+	}
+
+	template<typename Func>
+	boost::optional<std::future<Result<Func>>> try_submit(Func work) {
+		auto promise = std::make_shared<std::promise<Result<Func>>>();
+		auto future = promise->get_future();
+
+		if(!enqueue(make_job(promise, std::move(work), nullptr), false)) {
+			return boost::none;
+		}
+
+		return std::move(future);
+	}
+
+	template<typename Func, typename Callback>
+	bool try_submit(Func work, Callback callback, Dispatcher dispatcher = nullptr) {
+		auto promise = std::make_shared<std::promise<Result<Func>>>();
+		auto complete = completion(promise, std::move(callback), std::move(dispatcher));
+		return enqueue(make_job(promise, std::move(work), std::move(complete)), false);
+	}
+
+	std::size_t queue_depth() {
+		std::lock_guard<std::mutex> guard(lock_);
+		return queue_.size();
+	}
+
+	// finishes the work that's already queued before returning
+	void shutdown() {
+		{
+			std::lock_guard<std::mutex> guard(lock_);
+
+			if(stopped_) {
+				return;
+			}
+
+			stopped_ = true;
+		}
+
+		work_cond_.notify_all();
+		space_cond_.notify_all();
+
+		for(auto& worker : workers_) {
+			worker.join();
+		}
+	}
+};
+
+}} // connection_pool, ember
\ No newline at end of file
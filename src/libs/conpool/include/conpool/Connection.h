@@ -32,6 +32,7 @@ struct alignas(CACHELINE_SIZE) ConnDetail {
 	bool sweep = false;
 	bool refresh = false;
 	sc::seconds idle = 0s;
+	sc::steady_clock::time_point checkout_time;
 
 	ConnDetail(const ConType& connection, unsigned int id) : conn(connection), id(id), empty_slot(false) {}
 	ConnDetail() = default;
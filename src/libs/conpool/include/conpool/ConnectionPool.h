@@ -9,12 +9,13 @@
 #pragma once
 
 #include "Connection.h"
+#include "FreeList.h"
 #include "PoolManager.h"
 #include "Policies.h"
 #include "Exception.h"
 #include "LogSeverity.h"
+#include <shared/metrics/Histogram.h>
 #include <shared/threading/Spinlock.h>
-#include <shared/threading/Semaphore.h>
 #include <boost/optional.hpp>
 #include <boost/assert.hpp>
 #include <utility>
@@ -24,10 +25,12 @@
 #include <exception>
 #include <string>
 #include <mutex>
+#include <condition_variable>
 #include <chrono>
 #include <atomic>
 #include <vector>
 #include <cstddef>
+#include <cstdint>
 
 namespace ember { namespace connection_pool {
 
@@ -37,6 +40,31 @@ using namespace std::string_literals;
 
 template<typename ConType, typename Driver, typename ReusePolicy, typename GrowthPolicy> class PoolManager;
 
+struct Contention {
+	std::uint64_t cas_retries;     // free-list pushes and pops that lost a race for the head
+	std::uint64_t stale_pops;      // popped slots that had already been claimed elsewhere
+	std::uint64_t affinity_misses; // thread's last connection was unavailable
+	std::uint64_t exhausted;       // checkouts that found nothing idle and fell back to growing
+};
+
+struct WaitStats {
+	std::size_t waiting;          // callers queued for a connection right now
+	std::size_t peak_waiting;     // longest the queue has been since the last call
+	std::uint64_t timeouts;       // waits that reached their deadline empty-handed
+	Histogram::Snapshot waits;    // time taken to get a connection from wait_connection
+};
+
+struct PoolStats {
+	std::size_t size;
+	WaitStats wait;
+	Histogram::Snapshot holds;         // time between checkout and return
+	Histogram::Snapshot opens;         // time taken by the driver to open a connection
+	Histogram::Snapshot refreshes;     // time taken by keep-alives on idle connections
+	std::uint64_t growth_events;       // times a checkout found the pool exhausted and grew it
+	std::uint64_t sweeps;              // connections closed for being idle or failing to clean
+	std::uint64_t keep_alive_failures; // idle connections found dead by a keep-alive
+};
+
 template<typename Driver, typename ReusePolicy, typename GrowthPolicy>
 class Pool : private ReusePolicy, private GrowthPolicy {
 	template<typename, typename, typename, typename>
@@ -53,11 +81,38 @@ class Pool : private ReusePolicy, private GrowthPolicy {
 	Spinlock lock_;
 	std::vector<ConnDetail<ConType>> pool_;
 	std::vector<std::atomic<bool>> pool_guards_;
+	FreeList free_;
+	std::atomic_bool affinity_;
+	std::atomic<std::uint64_t> stale_pops_, affinity_misses_, exhausted_;
+
+	struct Waiter {
+		std::condition_variable cond;
+		ConnDetail<ConType>* detail = nullptr;
+	};
+
+	std::mutex waiters_lock_;
+	std::list<Waiter*> waiters_;
+	std::atomic<std::size_t> waiting_, peak_waiting_;
+	std::atomic<std::uint64_t> timeouts_;
+	Histogram wait_times_;
+
+	Histogram hold_times_, open_times_, refresh_times_;
+	std::atomic<std::uint64_t> growth_events_, sweeps_, keep_alive_failures_;
 
-	Semaphore<std::mutex> semaphore_;
 	std::function<void(Severity, std::string)> log_cb_;
 	std::atomic_bool closed_;
 
+	struct Affinity {
+		const void* pool;
+		unsigned int slot;
+	};
+
+	// the slot each thread last checked out, shared by every pool of this type
+	static Affinity& last_slot() {
+		thread_local Affinity affinity { nullptr, 0 };
+		return affinity;
+	}
+
 	void set_connection_ids() {
 		unsigned int connection_id = 0;
 
@@ -71,9 +126,12 @@ class Pool : private ReusePolicy, private GrowthPolicy {
 		std::vector<std::future<ConType>> futures;
 
 		for(std::size_t i = 0; i < num; ++i) {
-			auto f = std::async([](Driver* driver) {
-				return driver->open();
-			}, &driver_);
+			auto f = std::async([this]() {
+				const auto start = sc::steady_clock::now();
+				auto conn = driver_.open();
+				open_times_.record(sc::steady_clock::now() - start);
+				return conn;
+			});
 
 			futures.emplace_back(std::move(f));
 		}
@@ -88,43 +146,183 @@ class Pool : private ReusePolicy, private GrowthPolicy {
 
 			*pool_it = std::move(ConnDetail<ConType>(f.get(), pool_it->id));
 			++size_;
-			semaphore_.signal();
+			make_available(*pool_it);
 		}
 	}
 
-	bool find_free_connection(ConnDetail<ConType>& cd) {
-		bool checked_out = pool_guards_[cd.id].load(std::memory_order_relaxed);
+	/*
+	 * Hands the connection straight to the longest waiting caller if there is
+	 * one, otherwise releases the slot's guard and lists it so the next checkout
+	 * can find it. The guard has to be dropped first - a checkout that pops the
+	 * index while the guard is still held will discard it, relying on this to
+	 * list it again.
+	 *
+	 * The waiter count is checked again after listing because a caller may have
+	 * queued after the first check but before the push, having found the list
+	 * empty. Queuing and pushing are each followed by a full fence, so at least
+	 * one side is guaranteed to see the other.
+	 */
+	void make_available(ConnDetail<ConType>& cd) {
+		if(waiting_.load(std::memory_order_relaxed) && hand_off(cd)) {
+			return;
+		}
 
-		if(checked_out) {
+		// the slot may belong to somebody else as soon as its guard is released
+		const auto id = cd.id;
+		pool_guards_[id].store(false, std::memory_order_release);
+		free_.push(id);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+
+		if(waiting_.load(std::memory_order_relaxed)) {
+			dispatch();
+		}
+	}
+
+	// passes a claimed connection to the front of the queue, which must be locked
+	void hand_to_front(ConnDetail<ConType>& cd) {
+		auto waiter = waiters_.front();
+		waiters_.pop_front();
+		--waiting_;
+		waiter->detail = &cd;
+		waiter->cond.notify_one();
+	}
+
+	bool hand_off(ConnDetail<ConType>& cd) {
+		std::lock_guard<std::mutex> guard(waiters_lock_);
+
+		if(waiters_.empty()) {
 			return false;
 		}
 
-		std::atomic_thread_fence(std::memory_order_acquire);
-
-		if(!cd.error && !cd.sweep && !cd.empty_slot) {
-			if(cd.dirty && !return_clean()) {
-				try {
-					if(driver_.clean(cd.conn)) {
-						cd.dirty = false;
-					} else {
-						cd.sweep = true;
-						return false;
-					}
-				} catch(std::exception& e) {
-					if(log_cb_) {
-						log_cb_(Severity::DEBUG, "On connection clean: "s + e.what());
-					}
+		hand_to_front(cd);
+		return true;
+	}
+
+	// moves any listed connections to queued callers, oldest first
+	void dispatch() {
+		std::lock_guard<std::mutex> guard(waiters_lock_);
+		std::uint32_t slot;
+
+		while(!waiters_.empty() && free_.pop(slot)) {
+			if(claim(pool_[slot])) {
+				hand_to_front(pool_[slot]);
+			} else {
+				stale_pops_.fetch_add(1, std::memory_order_relaxed);
+			}
+		}
+	}
+
+	/*
+	 * A slot belongs to whoever flips its guard from false to true, whether
+	 * that's a checkout, a waiter being handed a connection or the manager.
+	 */
+	bool claim(ConnDetail<ConType>& cd) {
+		bool available = false;
+
+		return pool_guards_[cd.id].compare_exchange_strong(available, true, std::memory_order_acquire,
+		                                                   std::memory_order_relaxed);
+	}
+
+	/*
+	 * Readies a claimed connection for use. A connection that turns out to be
+	 * unusable is left claimed and flagged for the manager to close, rather
+	 * than listed again.
+	 */
+	bool prepare(ConnDetail<ConType>& cd) {
+		if(cd.error || cd.sweep || cd.empty_slot) {
+			return false;
+		}
+
+		if(cd.dirty && !return_clean()) {
+			try {
+				if(driver_.clean(cd.conn)) {
+					cd.dirty = false;
+				} else {
+					cd.sweep = true;
 					return false;
 				}
+			} catch(std::exception& e) {
+				cd.sweep = true;
+
+				if(log_cb_) {
+					log_cb_(Severity::DEBUG, "On connection clean: "s + e.what());
+				}
+
+				return false;
 			}
+		}
+
+		cd.checked_out = true;
+		cd.idle = 0s;
+		return true;
+	}
 
-			cd.checked_out = true;
-			cd.idle = 0s;
-			pool_guards_[cd.id].store(true, std::memory_order_relaxed);
-			return true;
+	ConnDetail<ConType>* checkout_affine() {
+		auto& affinity = last_slot();
+
+		if(affinity.pool != this) {
+			return nullptr;
+		}
+
+		auto& cd = pool_[affinity.slot];
+
+		if(claim(cd)) {
+			return prepare(cd)? &cd : nullptr;
+		}
+
+		affinity_misses_.fetch_add(1, std::memory_order_relaxed);
+		return nullptr;
+	}
+
+	ConnDetail<ConType>* checkout_free() {
+		std::uint32_t slot;
+
+		while(free_.pop(slot)) {
+			if(!claim(pool_[slot])) {
+				stale_pops_.fetch_add(1, std::memory_order_relaxed);
+			} else if(prepare(pool_[slot])) {
+				return &pool_[slot];
+			}
 		}
 
-		return false;
+		return nullptr;
+	}
+
+	void grow_pool() {
+		std::lock_guard<Spinlock> guard(lock_);
+		const auto count = grow(size(), max_);
+
+		if(count) {
+			open_connections(count);
+			growth_events_.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+
+	Connection<ConType> wrap(ConnDetail<ConType>& detail) {
+		if(affinity_.load(std::memory_order_relaxed)) {
+			last_slot() = { this, detail.id };
+		}
+
+		driver_.thread_enter();
+		detail.checkout_time = sc::steady_clock::now();
+
+		return Connection<ConType>([this](Connection<ConType>& arg) {
+			this->return_connection(arg);
+		}, detail);
+	}
+
+	ConnDetail<ConType>* checkout() {
+		ConnDetail<ConType>* detail = nullptr;
+
+		if(affinity_.load(std::memory_order_relaxed)) {
+			detail = checkout_affine();
+		}
+
+		if(!detail) {
+			detail = checkout_free();
+		}
+
+		return detail;
 	}
 	
 	boost::optional<Connection<ConType>> get_connection_attempt() {
@@ -133,37 +331,97 @@ class Pool : private ReusePolicy, private GrowthPolicy {
 #endif
 		manager_.check_exceptions();
 
-		std::unique_lock<Spinlock> guard(lock_);
-
-		auto res = std::find_if(pool_.begin(), pool_.end(), [&](auto& arg) {
-			return this->find_free_connection(arg); // this-> is a GCC bug workaround
-		});
+		auto detail = checkout();
 
-		if(res == pool_.end()) {
-			open_connections(grow(size(), max_));
+		if(!detail) {
+			exhausted_.fetch_add(1, std::memory_order_relaxed);
+			grow_pool();
 
-			res = std::find_if(pool_.begin(), pool_.end(), [&](auto& arg) {
-				return this->find_free_connection(arg);
-			});
-			
-			if(res == pool_.end()) {
+			if(!(detail = checkout_free())) {
 				return boost::none;
 			}
 		}
 
-		guard.unlock();
-		driver_.thread_enter();
+		return wrap(*detail);
+	}
 
-		return Connection<ConType>([this](Connection<ConType>& arg) {
-			this->return_connection(arg);
-		}, *res);
+	/*
+	 * Queues the caller behind anybody already waiting. Released connections
+	 * are handed to the front of the queue rather than listed, so a caller
+	 * arriving later can't take one first and wakeups go to one thread
+	 * instead of every waiter. A connection that's unusable by the time it's
+	 * handed over puts the caller back at the front of the queue.
+	 */
+	Connection<ConType> queue_for_connection(sc::steady_clock::time_point deadline) {
+		Waiter waiter;
+		std::unique_lock<std::mutex> guard(waiters_lock_);
+		waiters_.push_back(&waiter);
+
+		while(true) {
+			const auto queued = ++waiting_;
+			auto peak = peak_waiting_.load(std::memory_order_relaxed);
+
+			while(queued > peak && !peak_waiting_.compare_exchange_weak(peak, queued,
+			                                                            std::memory_order_relaxed)) { }
+
+			guard.unlock();
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+
+			// connections listed before the caller was queued or that growth opens go to the queue
+			dispatch();
+			grow_pool();
+			guard.lock();
+
+			while(!waiter.detail) {
+				if(deadline == sc::steady_clock::time_point::max()) {
+					waiter.cond.wait(guard);
+				} else if(waiter.cond.wait_until(guard, deadline) == std::cv_status::timeout
+				          && !waiter.detail) {
+					waiters_.remove(&waiter);
+					--waiting_;
+					timeouts_.fetch_add(1, std::memory_order_relaxed);
+					throw no_free_connections();
+				}
+			}
+
+			guard.unlock();
+			auto& detail = *waiter.detail;
+
+			if(prepare(detail)) {
+				return wrap(detail);
+			}
+
+			waiter.detail = nullptr;
+			guard.lock();
+			waiters_.push_front(&waiter);
+		}
+	}
+
+	Connection<ConType> wait_connection_until(sc::steady_clock::time_point deadline) {
+		const auto start = sc::steady_clock::now();
+
+		// only take the short route if it won't mean jumping the queue
+		if(!waiting_.load(std::memory_order_relaxed)) {
+			if(auto conn = get_connection_attempt()) {
+				wait_times_.record(sc::steady_clock::now() - start);
+				return std::move(conn.get());
+			}
+		}
+
+		manager_.check_exceptions();
+
+		auto conn = queue_for_connection(deadline);
+		wait_times_.record(sc::steady_clock::now() - start);
+		return conn;
 	}
 	
 public:
 	Pool(Driver& driver, std::size_t min_size, std::size_t max_size,
 	     sc::seconds max_idle, sc::seconds interval = 15s)
 	     : driver_(driver), min_(min_size), max_(max_size), manager_(this), pool_(max_size),
-		   pool_guards_(max_size), size_(0), closed_(false) {
+		   pool_guards_(max_size), free_(max_size), affinity_(false), stale_pops_(0),
+		   affinity_misses_(0), exhausted_(0), waiting_(0), peak_waiting_(0), timeouts_(0),
+		   growth_events_(0), sweeps_(0), keep_alive_failures_(0), size_(0), closed_(false) {
 
 		if(!max_size) {
 			throw exception("Max. database connections cannot be zero");
@@ -173,6 +431,11 @@ public:
 			throw exception("Min. database connections must be <= max.");
 		}
 
+		// empty slots stay claimed until a connection is opened in them
+		for(auto& guard : pool_guards_) {
+			guard.store(true, std::memory_order_relaxed);
+		}
+
 		set_connection_ids();
 		open_connections(min_);
 		manager_.start(interval, max_idle);
@@ -241,49 +504,27 @@ public:
 	}
 
 	/*
-	 * This function checks for a connection in a loop because being woken up
-	 * from wait_for doesn't guarantee that a connection will be available for the
-	 * thread, only that a connection has been added to the pool/made available
-	 * for reuse.
+	 * The waiting variants queue callers in arrival order when the pool is
+	 * exhausted, each released connection going to the caller that has
+	 * waited longest. get_connection doesn't queue and may still take a
+	 * connection ahead of waiters that haven't been woken yet.
 	 */
 	Connection<ConType> wait_connection() {
-		boost::optional<Connection<ConType>> conn;
-		
-		while(!(conn = get_connection_attempt())) {
-			semaphore_.wait();
-		}
-
-		return std::move(conn.get());
+		return wait_connection_until(sc::steady_clock::time_point::max());
 	}
 
-	/*
-	 * This function handles its own timing because being woken up from wait_for
-	 * doesn't guarantee that a connection will be available for the thread,
-	 * only that a connection has been added to the pool/made available for reuse.
-	 * Therefore, if the thread is woken up, it will check for a connection. If none
-	 * are available, it will wait for the next notification and keep trying until
-	 * either the time has elapsed or it manages to get a connection.
-	 */
 	Connection<ConType> wait_connection(std::chrono::milliseconds duration) {
-		auto start = sc::high_resolution_clock::now();
-		boost::optional<Connection<ConType>> conn;
-
-		while(!(conn = get_connection_attempt())) {
-			sc::milliseconds elapsed = sc::duration_cast<sc::milliseconds>
-				(sc::high_resolution_clock::now() - start);
-			
-			if(elapsed >= duration) {
-				throw no_free_connections();
-			}
-
-			semaphore_.wait_for(duration - elapsed);
-		}
+		return wait_connection_until(sc::steady_clock::now() + duration);
+	}
 
-		return std::move(conn.get());
+	// gives up once the deadline passes, for callers with a budget for the whole request
+	Connection<ConType> wait_connection(sc::steady_clock::time_point deadline) {
+		return wait_connection_until(deadline);
 	}
 
 	void return_connection(Connection<ConType>& connection) {
 		auto& detail = connection.detail_.get();
+		hold_times_.record(sc::steady_clock::now() - detail.checkout_time);
 
 		if(return_clean()) {
 			if(!driver_.clean(detail.conn)) {
@@ -296,12 +537,14 @@ public:
 
 		connection.released_ = true;
 		detail.checked_out = false;
-		std::atomic_thread_fence(std::memory_order_release);
-		pool_guards_[detail.id].store(false, std::memory_order_relaxed);
+
+		// connections that failed to clean stay claimed until the manager closes them
+		if(!detail.sweep) {
+			make_available(detail);
+		}
 
 		driver_.thread_exit();
 		manager_.check_exceptions();
-		semaphore_.signal();
 	}
 
 	std::size_t size() const {
@@ -312,6 +555,55 @@ public:
 		log_cb_ = callback;
 	}
 
+	/*
+	 * Has each thread try the connection it last used before going to the free
+	 * list. Worth enabling when threads make many short checkouts, as it keeps
+	 * the connection's state warm in that thread's cache and avoids the list
+	 * head entirely while the connection isn't wanted elsewhere.
+	 */
+	void thread_affinity(bool enable) {
+		affinity_ = enable;
+	}
+
+	std::size_t waiting() const {
+		return waiting_;
+	}
+
+	WaitStats reset_wait_stats() {
+		return {
+			waiting_.load(std::memory_order_relaxed),
+			peak_waiting_.exchange(waiting_.load(std::memory_order_relaxed), std::memory_order_relaxed),
+			timeouts_.exchange(0, std::memory_order_relaxed),
+			wait_times_.reset()
+		};
+	}
+
+	/*
+	 * Returns what's been recorded since the last call, including the wait
+	 * stats. Safe to call from any thread, such as a metrics poller's.
+	 */
+	PoolStats reset_stats() {
+		return {
+			size(),
+			reset_wait_stats(),
+			hold_times_.reset(),
+			open_times_.reset(),
+			refresh_times_.reset(),
+			growth_events_.exchange(0, std::memory_order_relaxed),
+			sweeps_.exchange(0, std::memory_order_relaxed),
+			keep_alive_failures_.exchange(0, std::memory_order_relaxed)
+		};
+	}
+
+	Contention contention() const {
+		return {
+			free_.retries(),
+			stale_pops_.load(std::memory_order_relaxed),
+			affinity_misses_.load(std::memory_order_relaxed),
+			exhausted_.load(std::memory_order_relaxed)
+		};
+	}
+
 	bool dirty() const {
 		return std::count_if(pool_.begin(), pool_.end(),
 			[](const ConnDetail<ConType>& c) { return c.dirty; });
@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2016 Ember
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include "Connection.h"
+#include <atomic>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+
+namespace ember { namespace connection_pool {
+
+/*
+ * Lock-free LIFO stack of connection slot indices. The head packs the top
+ * index with a counter that's bumped on every change, so a pop that races
+ * with another thread popping and pushing the same index back can't succeed
+ * with a stale next link (ABA).
+ *
+ * An index can only be listed once at a time - pushing an index that's
+ * already on the stack is a no-op. Being listed doesn't guarantee that the
+ * slot is still available, so whoever pops an index has to claim the slot
+ * before using it.
+ */
+class FreeList {
+	static const std::uint32_t NIL = 0xFFFFFFFF;
+
+	alignas(CACHELINE_SIZE) std::atomic<std::uint64_t> head_;
+	alignas(CACHELINE_SIZE) std::atomic<std::uint64_t> retries_;
+	std::unique_ptr<std::atomic<std::uint32_t>[]> next_;
+	std::unique_ptr<std::atomic<bool>[]> listed_;
+
+	static std::uint64_t make_head(std::uint64_t tag, std::uint32_t index) {
+		return (tag << 32) | index;
+	}
+
+	static std::uint32_t index(std::uint64_t head) {
+		return static_cast<std::uint32_t>(head);
+	}
+
+	static std::uint64_t tag(std::uint64_t head) {
+		return head >> 32;
+	}
+
+public:
+	explicit FreeList(std::size_t capacity)
+	                  : head_(make_head(0, NIL)), retries_(0),
+	                    next_(new std::atomic<std::uint32_t>[capacity]),
+	                    listed_(new std::atomic<bool>[capacity]) {
+		for(std::size_t i = 0; i < capacity; ++i) {
+			next_[i].store(NIL, std::memory_order_relaxed);
+			listed_[i].store(false, std::memory_order_relaxed);
+		}
+	}
+
+	bool push(std::uint32_t slot) {
+		if(listed_[slot].exchange(true, std::memory_order_acq_rel)) {
+			return false;
+		}
+
+		auto head = head_.load(std::memory_order_relaxed);
+		next_[slot].store(index(head), std::memory_order_relaxed);
+
+		while(!head_.compare_exchange_weak(head, make_head(tag(head) + 1, slot),
+		                                   std::memory_order_release, std::memory_order_relaxed)) {
+			retries_.fetch_add(1, std::memory_order_relaxed);
+			next_[slot].store(index(head), std::memory_order_relaxed);
+		}
+
+		return true;
+	}
+
+	bool pop(std::uint32_t& slot) {
+		auto head = head_.load(std::memory_order_acquire);
+
+		while(true) {
+			if(index(head) == NIL) {
+				return false;
+			}
+
+			const auto next = next_[index(head)].load(std::memory_order_relaxed);
+
+			if(head_.compare_exchange_weak(head, make_head(tag(head) + 1, next),
+			                               std::memory_order_acquire, std::memory_order_acquire)) {
+				break;
+			}
+
+			retries_.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		slot = index(head);
+		listed_[slot].store(false, std::memory_order_release);
+		return true;
+	}
+
+	// number of times a push or pop lost a race for the head and had to go around again
+	std::uint64_t retries() const {
+		return retries_.load(std::memory_order_relaxed);
+	}
+};
+
+}} // connection_pool, ember
\ No newline at end of file
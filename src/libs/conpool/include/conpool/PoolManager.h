@@ -53,13 +53,18 @@ class PoolManager {
 			}
 		}
 			
+		if(conn.sweep) {
+			pool_->sweeps_.fetch_add(1, std::memory_order_relaxed);
+		}
+
 		conn.reset();
-		std::atomic_thread_fence(std::memory_order_release);
-		pool_->pool_guards_[conn.id].store(true, std::memory_order_relaxed);
+		pool_->pool_guards_[conn.id].store(true, std::memory_order_release);
 		--pool_->size_;
 	}
 
 	void refresh(ConnDetail<ConType>& conn) {
+		const auto start = sc::steady_clock::now();
+
 		try {
 			conn.error = !pool_->driver_.keep_alive(conn.conn);
 			conn.idle = 0s;
@@ -71,13 +76,18 @@ class PoolManager {
 			}
 		}
 
+		pool_->refresh_times_.record(sc::steady_clock::now() - start);
+
+		if(conn.error) {
+			pool_->keep_alive_failures_.fetch_add(1, std::memory_order_relaxed);
+		}
+
 		conn.refresh = false;
 		conn.checked_out = false;
-		std::atomic_thread_fence(std::memory_order_release);
-		pool_->pool_guards_[conn.id].store(false, std::memory_order_relaxed);
 
+		// failed connections stay claimed until the next pass closes them
 		if(!conn.error) {
-			pool_->semaphore_.signal();
+			pool_->make_available(conn);
 		}
 	}
 
@@ -112,6 +122,11 @@ class PoolManager {
 		refill();
 	}
 
+	/*
+	 * Idle connections are claimed in the same way as a checkout would, so
+	 * the manager never touches a connection while somebody else has it.
+	 * Connections that are still fresh enough are handed straight back.
+	 */
 	void set_connection_flags() {
 		std::lock_guard<Spinlock> guard(pool_->lock_);
 		std::size_t excess_connections = 0;
@@ -121,12 +136,17 @@ class PoolManager {
 		}
 
 		for(auto& conn : pool_->pool_) {
-			if(conn.checked_out || conn.empty_slot) {
+			bool available = false;
+
+			if(!pool_->pool_guards_[conn.id].compare_exchange_strong(available, true,
+			                                                         std::memory_order_acquire,
+			                                                         std::memory_order_relaxed)) {
 				continue;
 			}
 
 			if(conn.idle < max_idle_) {
 				conn.idle += interval_;
+				pool_->make_available(conn);
 			} else if(excess_connections > 0) {
 				--excess_connections;
 				conn.checked_out = true;
@@ -135,9 +155,6 @@ class PoolManager {
 				conn.checked_out = true;
 				conn.refresh = true;
 			}
-
-			std::atomic_thread_fence(std::memory_order_release);
-			pool_->pool_guards_[conn.id].store(conn.checked_out, std::memory_order_relaxed);
 		}
 	}
 
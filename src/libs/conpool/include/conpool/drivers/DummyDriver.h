@@ -16,15 +16,19 @@ class DummyConnection;
 
 namespace drivers {
 
+/*
+ * Does nothing, as cheaply as possible - for exercising and benchmarking
+ * the pool itself without a database
+ */
 class DummyDriver {
 	
 public:
 	DummyDriver();
 	DummyConnection open() const;
-	DummyConnection clean(DummyConnection conn) const;
+	bool clean(DummyConnection conn) const;
 	void close(DummyConnection conn) const;
 	void clear_state(DummyConnection conn) const;
-	DummyConnection keep_alive(DummyConnection conn) const;
+	bool keep_alive(DummyConnection conn) const;
 	void thread_enter() const;
 	void thread_exit() const;
 	std::string name() const;
@@ -8,11 +8,14 @@
 
 #pragma once
 
-#include <algorithm>
+#include <array>
+#include <atomic>
+#include <memory>
 #include <string>
 #include <mutex>
 #include <unordered_map>
 #include <utility>
+#include <cstddef>
 
 namespace sql {
 
@@ -24,16 +27,48 @@ class PreparedStatement;
 
 namespace ember { namespace drivers {
 
-class MySQL {
-	typedef std::unordered_map<std::string, sql::PreparedStatement*> QueryCache;
+typedef std::size_t StatementID;
+
+/*
+ * Handle to an open connection and the statements prepared on it. Statements
+ * registered with the driver sit in a fixed array indexed by their ID, so
+ * fetching one is a single load - no locking or hashing. Only whoever has
+ * the connection checked out touches its statements, so they need no locks
+ * of their own. The handle is cheap to copy - the driver owns what it points to.
+ */
+class MySQLConnection {
+	friend class MySQL;
+
+public:
+	static const std::size_t MAX_STATEMENTS = 64;
+
+private:
+	struct State {
+		sql::Connection* handle = nullptr;
+		std::array<sql::PreparedStatement*, MAX_STATEMENTS> statements {};
+		std::unordered_map<std::string, sql::PreparedStatement*> adhoc; // unregistered SQL
+	};
+
+	State* state_ = nullptr;
+
+	explicit MySQLConnection(State* state) : state_(state) { }
 
+public:
+	MySQLConnection() = default;
+
+	sql::Connection* get() const { return state_->handle; }
+	sql::Connection* operator->() const { return state_->handle; }
+};
+
+class MySQL {
 	const std::string dsn, username, password, database;
 	sql::Driver* driver;
-	mutable std::unordered_map<const sql::Connection*, QueryCache> cache_;
-	mutable std::mutex cache_lock_;
 
-	QueryCache* locate_cache(const sql::Connection* conn) const;
-	void close_cache(const sql::Connection* conn) const;
+	std::unique_ptr<std::string[]> statements_;
+	std::atomic<std::size_t> registered_;
+	std::mutex registry_lock_;
+
+	void prepare_registered(MySQLConnection conn) const;
 
 public:
 	MySQL(std::string user, std::string password, const std::string& host,
@@ -41,21 +76,31 @@ public:
 
 	MySQL(MySQL&& rhs) : dsn(std::move(rhs.dsn)), username(std::move(rhs.username)),
 	                     password(std::move(rhs.password)), database(std::move(rhs.database)),
-	                     cache_(std::move(rhs.cache_)), driver(rhs.driver) { }
+	                     driver(rhs.driver), statements_(std::move(rhs.statements_)),
+	                     registered_(rhs.registered_.load()) { }
 
 	static std::string name();
 	static std::string version();
 
-	sql::Connection* open() const;
-	bool clean(sql::Connection* conn) const;
-	void close(sql::Connection* conn) const;
-	bool keep_alive(sql::Connection* conn) const;
+	MySQLConnection open() const;
+	bool clean(MySQLConnection conn) const;
+	void close(MySQLConnection conn) const;
+	bool keep_alive(MySQLConnection conn) const;
 	void thread_enter() const;
 	void thread_exit() const;
-	sql::PreparedStatement* prepare_cached(sql::Connection* conn, const std::string& key);
-	sql::PreparedStatement* lookup_statement(const sql::Connection* conn, const std::string& key);
-	void cache_statement(const sql::Connection* conn, const std::string& key,
-	                     sql::PreparedStatement* value);
+
+	/*
+	 * Registers a query to be prepared on every connection, returning the ID
+	 * used to fetch it. Registering the same query twice returns the same ID.
+	 * Meant to be done once at startup - connections opened afterwards are
+	 * prepared up front and existing connections catch up when they're next
+	 * refreshed or used.
+	 */
+	StatementID register_statement(const std::string& query);
+	sql::PreparedStatement* prepare(MySQLConnection conn, StatementID id) const;
+
+	// for SQL that can't be registered up front, such as variable length batches
+	sql::PreparedStatement* prepare_cached(MySQLConnection conn, const std::string& query) const;
 };
 
 }} //drivers, ember
\ No newline at end of file
@@ -16,52 +16,70 @@
 #include <cppconn/prepared_statement.h>
 #include <memory>
 #include <sstream>
+#include <stdexcept>
 
 namespace ember { namespace drivers {
 
 MySQL::MySQL(std::string user, std::string pass, const std::string& host, unsigned short port,
              std::string db) : database(db), username(std::move(user)), password(std::move(pass)),
-             dsn(std::string("tcp://" + host + ":" + std::to_string(port))) {
+             dsn(std::string("tcp://" + host + ":" + std::to_string(port))),
+             statements_(std::make_unique<std::string[]>(MySQLConnection::MAX_STATEMENTS)),
+             registered_(0) {
 	driver = get_driver_instance();
 }
 
-sql::Connection* MySQL::open() const {
-	sql::Connection* conn = driver->connect(dsn, username, password);
-	conn->setSchema(database);
-	conn->setAutoCommit(true);
-	bool opt = true;
-	conn->setClientOption("MYSQL_OPT_RECONNECT", &opt);
+MySQLConnection MySQL::open() const {
+	auto state = std::make_unique<MySQLConnection::State>();
+	state->handle = driver->connect(dsn, username, password);
+	MySQLConnection conn(state.release());
+
+	try {
+		conn->setSchema(database);
+		conn->setAutoCommit(true);
+		bool opt = true;
+		conn->setClientOption("MYSQL_OPT_RECONNECT", &opt);
+		prepare_registered(conn);
+	} catch(...) {
+		close(conn);
+		throw;
+	}
+
 	return conn;
 }
 
-void MySQL::close(sql::Connection* conn) const {
-	if(!conn->isClosed()) {
-		conn->close();
-	}
-
-	auto conn_cache = locate_cache(conn);
+void MySQL::close(MySQLConnection conn) const {
+	std::unique_ptr<MySQLConnection::State> state(conn.state_);
 
-	if(conn_cache) {
-		for(auto stmt : *conn_cache) {
-			stmt.second->close();
-			delete stmt.second;
+	for(auto stmt : state->statements) {
+		if(stmt) {
+			stmt->close();
+			delete stmt;
 		}
+	}
 
-		close_cache(conn);
+	for(auto& stmt : state->adhoc) {
+		stmt.second->close();
+		delete stmt.second;
 	}
 
-	delete conn;
+	if(!conn->isClosed()) {
+		conn->close();
+	}
+
+	delete state->handle;
 }
 
-bool MySQL::keep_alive(sql::Connection* conn) const try {
+// also prepares anything registered since the connection was opened
+bool MySQL::keep_alive(MySQLConnection conn) const try {
 	std::unique_ptr<sql::Statement> stmt(conn->createStatement());
 	stmt->execute("/* ping */");
+	prepare_registered(conn);
 	return true;
 } catch(sql::SQLException&) {
 	return false;
 }
 
-bool MySQL::clean(sql::Connection* conn) const try {
+bool MySQL::clean(MySQLConnection conn) const try {
 	return conn->isValid();
 } catch(sql::SQLException&) {
 	return false;
@@ -88,54 +106,51 @@ std::string MySQL::version() {
 	return ver.str();
 }
 
-sql::PreparedStatement* MySQL::prepare_cached(sql::Connection* conn, const std::string& key) {
-	auto stmt = lookup_statement(conn, key);
-	
-	if(!stmt) {
-		stmt = conn->prepareStatement(key);
-		cache_statement(conn, key, stmt);
-	}
+StatementID MySQL::register_statement(const std::string& query) {
+	std::lock_guard<std::mutex> guard(registry_lock_);
+	const auto registered = registered_.load(std::memory_order_relaxed);
 
-	return stmt;
-}
-
-sql::PreparedStatement* MySQL::lookup_statement(const sql::Connection* conn, const std::string& key) {
-	auto conn_cache = locate_cache(conn);
-
-	if(!conn_cache) {
-		return nullptr;
+	for(StatementID id = 0; id < registered; ++id) {
+		if(statements_[id] == query) {
+			return id;
+		}
 	}
 
-	auto conn_cache_it = conn_cache->find(key);
-	
-	if(conn_cache_it == conn_cache->end()) {
-		return nullptr;
+	if(registered == MySQLConnection::MAX_STATEMENTS) {
+		throw std::length_error("Prepared statement limit reached, raise MAX_STATEMENTS");
 	}
 
-	return conn_cache_it->second;
+	statements_[registered] = query;
+	registered_.store(registered + 1, std::memory_order_release);
+	return registered;
 }
 
-void MySQL::cache_statement(const sql::Connection* conn, const std::string& key,
-                            sql::PreparedStatement* value) {
-	std::lock_guard<std::mutex> lock(cache_lock_);
-	cache_[conn][key] = value;
+void MySQL::prepare_registered(MySQLConnection conn) const {
+	const auto registered = registered_.load(std::memory_order_acquire);
+
+	for(StatementID id = 0; id < registered; ++id) {
+		prepare(conn, id);
+	}
 }
 
-MySQL::QueryCache* MySQL::locate_cache(const sql::Connection* conn) const {
-	std::lock_guard<std::mutex> lock(cache_lock_);
-	auto cache_it = cache_.find(conn);
+sql::PreparedStatement* MySQL::prepare(MySQLConnection conn, StatementID id) const {
+	auto& stmt = conn.state_->statements[id];
 
-	if(cache_it == cache_.end()) {
-		return nullptr;
+	if(!stmt) {
+		stmt = conn->prepareStatement(statements_[id]);
 	}
 
-	return &cache_it->second;
+	return stmt;
 }
 
-void MySQL::close_cache(const sql::Connection* conn) const {
-	std::lock_guard<std::mutex> lock(cache_lock_);
-	auto cache_it = cache_.find(conn);
-	cache_.erase(conn);
+sql::PreparedStatement* MySQL::prepare_cached(MySQLConnection conn, const std::string& query) const {
+	auto& stmt = conn.state_->adhoc[query];
+
+	if(!stmt) {
+		stmt = conn->prepareStatement(query);
+	}
+
+	return stmt;
 }
 
 }} // drivers, ember
\ No newline at end of file
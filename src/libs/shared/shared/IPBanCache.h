@@ -9,74 +9,80 @@
 #pragma once
 
 #include <shared/database/daos/shared_base/IPBanBase.h>
+#include <shared/util/PrefixTrie.h>
 #include <boost/asio/ip/address.hpp>
-#include <stdexcept>
+#include <memory>
+#include <mutex>
+#include <string>
 #include <vector>
-#include <cstdint>
+#include <cstddef>
 
 namespace ember {
 
+/*
+ * Bans are held in a prefix trie per address family, so a check costs the
+ * same whether there are ten banned ranges or ten thousand. Reloading builds
+ * a fresh set of tries and swaps them in, so checks never see a partial list.
+ */
 class IPBanCache {
-	struct IPv4Entry {
-		std::uint32_t range;
-		std::uint32_t mask;
+	struct Bans {
+		PrefixTrie<4> v4;
+		PrefixTrie<16> v6;
 	};
 
-	std::vector<IPv4Entry> entries_;
+	std::shared_ptr<const Bans> bans_;
+	mutable std::mutex lock_;
 
-	bool check_ban(const boost::asio::ip::address_v6&& ip) {
-		//implement
-		return false;
-	}
+	static std::shared_ptr<const Bans> load_bans(const std::vector<IPEntry>& entries) {
+		auto bans = std::make_shared<Bans>();
+
+		for(auto& entry : entries) {
+			auto address = boost::asio::ip::address::from_string(entry.first);
 
-	bool check_ban(const boost::asio::ip::address_v4&& ip) {
-		unsigned long ip_long = ip.to_ulong();
-		
-		for(auto& e : entries_) {
-			if((ip_long & e.mask) == (e.range & e.mask)) {
-				return true;
+			if(address.is_v6()) {
+				bans->v6.insert(address.to_v6().to_bytes(), entry.second);
+			} else {
+				bans->v4.insert(address.to_v4().to_bytes(), entry.second);
 			}
 		}
 
-		return false;
+		return bans;
 	}
 
-	void load_bans(const std::vector<IPEntry>& bans) {
-		for(auto& ban : bans) {
-			auto address = boost::asio::ip::address::from_string(ban.first);
-
-			if(address.is_v6()) {
-				throw std::runtime_error("IPv6 bans are not supported but the ban cache encountered one!");
-			}
-
-			std::uint32_t mask = (~0U) << (32 - ban.second);
-			entries_.emplace_back(IPv4Entry{static_cast<std::uint32_t>(address.to_v4().to_ulong()), mask});
-		}
+	std::shared_ptr<const Bans> bans() const {
+		std::lock_guard<std::mutex> guard(lock_);
+		return bans_;
 	}
 
 public:
-	IPBanCache(const std::vector<IPEntry>& bans) {
-		load_bans(bans);
+	IPBanCache(const std::vector<IPEntry>& bans) : bans_(load_bans(bans)) { }
+
+	// builds the new ban list before swapping it in, so a bad entry leaves the old list in place
+	void reload(const std::vector<IPEntry>& bans) {
+		auto loaded = load_bans(bans);
+		std::lock_guard<std::mutex> guard(lock_);
+		bans_ = std::move(loaded);
 	}
 
 	bool is_banned(const std::string& ip) {
-		if(entries_.empty()) {
-			return false;
-		}
-
 		return is_banned(boost::asio::ip::address::from_string(ip));
 	}
 
 	bool is_banned(const boost::asio::ip::address& ip) {
-		if(entries_.empty()) {
-			return false;
+		const auto bans = this->bans();
+
+		if(ip.is_v4()) {
+			return !bans->v4.empty() && bans->v4.match(ip.to_v4().to_bytes());
 		}
 
-		if(ip.is_v6()) {
-			return check_ban(ip.to_v6());
-		} else {
-			return check_ban(ip.to_v4());
+		const auto v6 = ip.to_v6();
+
+		// dual-stack sockets report IPv4 clients as mapped addresses
+		if(v6.is_v4_mapped()) {
+			return !bans->v4.empty() && bans->v4.match(v6.to_v4().to_bytes());
 		}
+
+		return !bans->v6.empty() && bans->v6.match(v6.to_bytes());
 	}
 };
 
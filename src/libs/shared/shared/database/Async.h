@@ -0,0 +1,23 @@
+/*
+ * Copyright (c) 2016 Ember
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include <functional>
+#include <future>
+
+namespace ember { namespace dal {
+
+// runs a completion wherever the caller wants it, such as its own io_service or thread pool
+typedef std::function<void(std::function<void()>)> Dispatcher;
+
+// receives the completed query - get() rethrows if it failed
+template<typename T>
+using Callback = std::function<void(std::future<T>)>;
+
+}} // dal, ember
\ No newline at end of file
@@ -10,6 +10,7 @@
 
 #include <shared/database/daos/shared_base/CharacterBase.h>
 #include <conpool/ConnectionPool.h>
+#include <conpool/AsyncExecutor.h>
 #include <mysql_connection.h>
 #include <cppconn/exception.h>
 #include <conpool/drivers/MySQL/Driver.h>
@@ -24,7 +25,18 @@ using namespace std::chrono_literals;
 template<typename T>
 class MySQLCharacterDAO final : public CharacterDAO {
 	T& pool_;
+	connection_pool::AsyncExecutor<T>* executor_;
 	drivers::MySQL* driver_;
+	drivers::StatementID select_name_, select_id_, select_account_, select_account_realm_;
+	drivers::StatementID insert_, update_, restore_, soft_delete_, delete_;
+
+	connection_pool::AsyncExecutor<T>& executor() const {
+		if(!executor_) {
+			throw exception("No executor available for asynchronous queries");
+		}
+
+		return *executor_;
+	}
 
 	Character result_to_character(sql::ResultSet* res) const {
 		Character character;
@@ -57,20 +69,9 @@ class MySQLCharacterDAO final : public CharacterDAO {
 		return character;
 	}
 
-public:
-	MySQLCharacterDAO(T& pool) : pool_(pool), driver_(pool.get_driver()) { }
-
-	boost::optional<Character> character(const std::string& name, std::uint32_t realm_id) const override try {
-		const std::string query = "SELECT c.name, c.internal_name, c.id, c.account_id, c.realm_id, c.race, c.class, "
-		                          "c.gender, c.skin, c.face, c.hairstyle, c.haircolour, c.facialhair, c.level, c.zone, "
-		                          "c.map, c.x, c.y, c.z, c.flags, c.first_login, c.pet_display, c.pet_level, "
-		                          "c.pet_family, gc.id as guild_id, gc.rank as guild_rank "
-		                          "FROM characters c "
-		                          "LEFT JOIN guild_characters gc ON c.id = gc.character_id "
-		                          "WHERE internal_name = ? AND realm_id = ? AND c.deletion_date IS NULL";
-
-		auto conn = pool_.wait_connection(5s);
-		sql::PreparedStatement* stmt = driver_->prepare_cached(*conn, query);
+	boost::optional<Character> fetch_character(drivers::MySQLConnection conn, const std::string& name,
+	                                           std::uint32_t realm_id) const try {
+		sql::PreparedStatement* stmt = driver_->prepare(conn, select_name_);
 		stmt->setString(1, name);
 		stmt->setUInt(2, realm_id);
 		std::unique_ptr<sql::ResultSet> res(stmt->executeQuery());
@@ -83,18 +84,9 @@ public:
 	} catch(std::exception& e) {
 		throw exception(e.what());
 	}
-	
-	boost::optional<Character> character(std::uint64_t id) const override try {
-		const std::string query = "SELECT c.name, c.internal_name, c.id, c.account_id, c.realm_id, c.race, c.class, "
-		                          "c.gender, c.skin, c.face, c.hairstyle, c.haircolour, c.facialhair, c.level, c.zone, "
-		                          "c.map, c.x, c.y, c.z, c.flags, c.first_login, c.pet_display, c.pet_level, "
-		                          "c.pet_family, gc.id as guild_id, gc.rank as guild_rank "
-		                          "FROM characters c "
-		                          "LEFT JOIN guild_characters gc ON c.id = gc.character_id "
-		                          "WHERE c.id = ? AND c.deletion_date IS NULL";
 
-		auto conn = pool_.wait_connection(5s);
-		sql::PreparedStatement* stmt = driver_->prepare_cached(*conn, query);
+	boost::optional<Character> fetch_character(drivers::MySQLConnection conn, std::uint64_t id) const try {
+		sql::PreparedStatement* stmt = driver_->prepare(conn, select_id_);
 		stmt->setUInt64(1, id);
 		std::unique_ptr<sql::ResultSet> res(stmt->executeQuery());
 
@@ -107,22 +99,10 @@ public:
 		throw exception(e.what());
 	}
 
-	std::vector<Character> characters(std::uint32_t account_id, std::uint32_t realm_id = 0) const override try {
-		std::string query = "SELECT c.name, c.internal_name, c.id, c.account_id, c.realm_id, c.race, c.class, "
-		                    "c.gender, c.skin, c.face, c.hairstyle, c.haircolour, c.facialhair, c.level, c.zone, "
-		                    "c.map, c.x, c.y, c.z, c.flags, c.first_login, c.pet_display, c.pet_level, "
-		                    "c.pet_family, gc.id as guild_id, gc.rank as guild_rank "
-		                    "FROM characters c "
-		                    "LEFT JOIN guild_characters gc ON c.id = gc.character_id "
-		                    "LEFT JOIN users u ON u.id = c.account_id "
-		                    "WHERE u.id = ? AND c.deletion_date IS NULL ";
-
-		if(realm_id) {
-			query.append("AND c.realm_id = ? ");
-		}
-
-		auto conn = pool_.wait_connection(5s);
-		sql::PreparedStatement* stmt = driver_->prepare_cached(*conn, query);
+	std::vector<Character> fetch_characters(drivers::MySQLConnection conn, std::uint32_t account_id,
+	                                        std::uint32_t realm_id) const try {
+		auto id = realm_id? select_account_realm_ : select_account_;
+		sql::PreparedStatement* stmt = driver_->prepare(conn, id);
 		stmt->setUInt(1, account_id);
 
 		if(realm_id) {
@@ -141,50 +121,8 @@ public:
 		throw exception(e.what());
 	}
 
-	void restore(std::uint64_t id) const override try {
-		const std::string query = "UPDATE characters SET deletion_date = NULL WHERE id = ?";
-	
-
-		auto conn = pool_.wait_connection(5s);
-		sql::PreparedStatement* stmt = driver_->prepare_cached(*conn, query);
-		stmt->setUInt64(1, id);
-
-		if(!stmt->executeUpdate()) {
-			throw exception("Unable to restore character " + std::to_string(id));
-		}
-	} catch(std::exception& e) {
-		throw exception(e.what());
-	}
-
-	void delete_character(std::uint64_t id, bool soft_delete) const override try {
-		std::string query;
-
-		if(soft_delete) {
-			query = "UPDATE characters SET deletion_date = CURTIME(), internal_name = CONCAT(name, id) WHERE id = ?";
-		} else {
-			query = "DELETE FROM characters WHERE id = ?";
-		}
-
-		auto conn = pool_.wait_connection(5s);
-		sql::PreparedStatement* stmt = driver_->prepare_cached(*conn, query);
-		stmt->setUInt64(1, id);
-		
-		if(!stmt->executeUpdate()) {
-			throw exception("Unable to delete character " + std::to_string(id));
-		}
-	} catch(std::exception& e) {
-		throw exception(e.what());
-	}
-
-	void create(const Character& character) const override try {
-		const std::string query = "INSERT INTO characters (name, account_id, realm_id, race, class, gender, "
-		                          "skin, face, hairstyle, haircolour, facialhair, level, zone, "
-		                          "map, x, y, z, flags, first_login, pet_display, pet_level, "
-		                          "pet_family, internal_name) "
-		                          "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)";
-		
-		auto conn = pool_.wait_connection(5s);
-		sql::PreparedStatement* stmt = driver_->prepare_cached(*conn, query);
+	void insert_character(drivers::MySQLConnection conn, const Character& character) const try {
+		sql::PreparedStatement* stmt = driver_->prepare(conn, insert_);
 		stmt->setString(1, character.name);
 		stmt->setUInt(2, character.account_id);
 		stmt->setUInt(3, character.realm_id);
@@ -216,16 +154,142 @@ public:
 		throw exception(e.what());
 	}
 
-	void update(const Character& character) const override try {
-		const std::string query = "UPDATE characters SET name = ?, internal_name = ?, account_id = ?, "
-		                          "realm_id = ?, race = ?, class = ?, gender = ?, skin = ?, face = ?, "
-		                          "hairstyle = ?, haircolour = ?, facialhair = ?, level = ?, zone = ?, "
-		                          "map = ?, x = ?, y = ?, z = ?, flags = ?, first_login = ?, pet_display = ?, "
-		                          "pet_level = ?, pet_family = ? "
-		                          "WHERE id = ?";
+public:
+	MySQLCharacterDAO(T& pool, connection_pool::AsyncExecutor<T>* executor = nullptr)
+	                  : pool_(pool), executor_(executor), driver_(pool.get_driver()) {
+		const std::string select = "SELECT c.name, c.internal_name, c.id, c.account_id, c.realm_id, c.race, c.class, "
+		                           "c.gender, c.skin, c.face, c.hairstyle, c.haircolour, c.facialhair, c.level, c.zone, "
+		                           "c.map, c.x, c.y, c.z, c.flags, c.first_login, c.pet_display, c.pet_level, "
+		                           "c.pet_family, gc.id as guild_id, gc.rank as guild_rank "
+		                           "FROM characters c "
+		                           "LEFT JOIN guild_characters gc ON c.id = gc.character_id ";
+
+		select_name_ = driver_->register_statement(
+			select + "WHERE internal_name = ? AND realm_id = ? AND c.deletion_date IS NULL"
+		);
+
+		select_id_ = driver_->register_statement(
+			select + "WHERE c.id = ? AND c.deletion_date IS NULL"
+		);
+
+		const std::string by_account = select + "LEFT JOIN users u ON u.id = c.account_id "
+		                                        "WHERE u.id = ? AND c.deletion_date IS NULL ";
+
+		select_account_ = driver_->register_statement(by_account);
+		select_account_realm_ = driver_->register_statement(by_account + "AND c.realm_id = ? ");
+
+		insert_ = driver_->register_statement(
+			"INSERT INTO characters (name, account_id, realm_id, race, class, gender, "
+			"skin, face, hairstyle, haircolour, facialhair, level, zone, "
+			"map, x, y, z, flags, first_login, pet_display, pet_level, "
+			"pet_family, internal_name) "
+			"VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)"
+		);
+
+		update_ = driver_->register_statement(
+			"UPDATE characters SET name = ?, internal_name = ?, account_id = ?, "
+			"realm_id = ?, race = ?, class = ?, gender = ?, skin = ?, face = ?, "
+			"hairstyle = ?, haircolour = ?, facialhair = ?, level = ?, zone = ?, "
+			"map = ?, x = ?, y = ?, z = ?, flags = ?, first_login = ?, pet_display = ?, "
+			"pet_level = ?, pet_family = ? "
+			"WHERE id = ?"
+		);
+
+		restore_ = driver_->register_statement("UPDATE characters SET deletion_date = NULL WHERE id = ?");
+
+		soft_delete_ = driver_->register_statement(
+			"UPDATE characters SET deletion_date = CURTIME(), internal_name = CONCAT(name, id) WHERE id = ?"
+		);
+
+		delete_ = driver_->register_statement("DELETE FROM characters WHERE id = ?");
+	}
+
+	boost::optional<Character> character(const std::string& name, std::uint32_t realm_id) const override try {
+		auto conn = pool_.wait_connection(5s);
+		return fetch_character(*conn, name, realm_id);
+	} catch(std::exception& e) {
+		throw exception(e.what());
+	}
+
+	boost::optional<Character> character(std::uint64_t id) const override try {
+		auto conn = pool_.wait_connection(5s);
+		return fetch_character(*conn, id);
+	} catch(std::exception& e) {
+		throw exception(e.what());
+	}
+
+	std::vector<Character> characters(std::uint32_t account_id, std::uint32_t realm_id = 0) const override try {
+		auto conn = pool_.wait_connection(5s);
+		return fetch_characters(*conn, account_id, realm_id);
+	} catch(std::exception& e) {
+		throw exception(e.what());
+	}
+
+	void create(const Character& character) const override try {
+		auto conn = pool_.wait_connection(5s);
+		insert_character(*conn, character);
+	} catch(std::exception& e) {
+		throw exception(e.what());
+	}
+
+	bool character_async(std::uint64_t id, Callback<boost::optional<Character>> callback,
+	                     Dispatcher dispatcher = nullptr) const override {
+		return executor().try_submit([this, id](drivers::MySQLConnection conn) {
+			return fetch_character(conn, id);
+		}, std::move(callback), std::move(dispatcher));
+	}
+
+	bool character_async(const std::string& name, std::uint32_t realm_id,
+	                     Callback<boost::optional<Character>> callback,
+	                     Dispatcher dispatcher = nullptr) const override {
+		return executor().try_submit([this, name, realm_id](drivers::MySQLConnection conn) {
+			return fetch_character(conn, name, realm_id);
+		}, std::move(callback), std::move(dispatcher));
+	}
+
+	bool characters_async(std::uint32_t account_id, std::uint32_t realm_id,
+	                      Callback<std::vector<Character>> callback,
+	                      Dispatcher dispatcher = nullptr) const override {
+		return executor().try_submit([this, account_id, realm_id](drivers::MySQLConnection conn) {
+			return fetch_characters(conn, account_id, realm_id);
+		}, std::move(callback), std::move(dispatcher));
+	}
+
+	bool create_async(const Character& character, Callback<void> callback,
+	                  Dispatcher dispatcher = nullptr) const override {
+		return executor().try_submit([this, character](drivers::MySQLConnection conn) {
+			insert_character(conn, character);
+		}, std::move(callback), std::move(dispatcher));
+	}
+
+	
+	void restore(std::uint64_t id) const override try {
+		auto conn = pool_.wait_connection(5s);
+		sql::PreparedStatement* stmt = driver_->prepare(*conn, restore_);
+		stmt->setUInt64(1, id);
+
+		if(!stmt->executeUpdate()) {
+			throw exception("Unable to restore character " + std::to_string(id));
+		}
+	} catch(std::exception& e) {
+		throw exception(e.what());
+	}
+
+	void delete_character(std::uint64_t id, bool soft_delete) const override try {
+		auto conn = pool_.wait_connection(5s);
+		sql::PreparedStatement* stmt = driver_->prepare(*conn, soft_delete? soft_delete_ : delete_);
+		stmt->setUInt64(1, id);
 		
+		if(!stmt->executeUpdate()) {
+			throw exception("Unable to delete character " + std::to_string(id));
+		}
+	} catch(std::exception& e) {
+		throw exception(e.what());
+	}
+
+	void update(const Character& character) const override try {
 		auto conn = pool_.wait_connection(5s);
-		sql::PreparedStatement* stmt = driver_->prepare_cached(*conn, query);
+		sql::PreparedStatement* stmt = driver_->prepare(*conn, update_);
 		stmt->setString(1, character.name);
 		stmt->setString(2, character.internal_name);
 		stmt->setUInt(3, character.account_id);
@@ -260,8 +324,9 @@ public:
 };
 
 template<typename T>
-std::unique_ptr<MySQLCharacterDAO<T>> character_dao(T& pool) {
-	return std::make_unique<MySQLCharacterDAO<T>>(pool);
+std::unique_ptr<MySQLCharacterDAO<T>> character_dao(T& pool,
+                                                   connection_pool::AsyncExecutor<T>* executor = nullptr) {
+	return std::make_unique<MySQLCharacterDAO<T>>(pool, executor);
 }
 
 }} //dal, ember
\ No newline at end of file
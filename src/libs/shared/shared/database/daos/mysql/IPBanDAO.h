@@ -24,15 +24,18 @@ template<typename T>
 class MySQLIPBanDAO final : public IPBanDAO {
 	T& pool_;
 	drivers::MySQL* driver_;
+	drivers::StatementID select_mask_, select_bans_, insert_ban_;
 
 public:
-	MySQLIPBanDAO(T& pool) : pool_(pool), driver_(pool.get_driver()) { }
+	MySQLIPBanDAO(T& pool) : pool_(pool), driver_(pool.get_driver()) {
+		select_mask_ = driver_->register_statement("SELECT cidr FROM ip_bans WHERE ip = ?");
+		select_bans_ = driver_->register_statement("SELECT ip, cidr FROM ip_bans");
+		insert_ban_ = driver_->register_statement("INSERT INTO ip_bans (ip, cidr) VALUES (?, ?)");
+	}
 
 	boost::optional<std::uint32_t> get_mask(const std::string& ip) const override try {
-		const std::string query = "SELECT cidr FROM ip_bans WHERE ip = ?";
-
 		auto conn = pool_.wait_connection(60s);
-		sql::PreparedStatement* stmt = driver_->prepare_cached(*conn, query);
+		sql::PreparedStatement* stmt = driver_->prepare(*conn, select_mask_);
 		stmt->setString(1, ip);
 		std::unique_ptr<sql::ResultSet> res(stmt->executeQuery());
 
@@ -46,10 +49,8 @@ public:
 	}
 
 	std::vector<IPEntry> all_bans() const override try {
-		const std::string query = "SELECT ip, cidr FROM ip_bans";
-
 		auto conn = pool_.wait_connection(60s);
-		sql::PreparedStatement* stmt = driver_->prepare_cached(*conn, query);
+		sql::PreparedStatement* stmt = driver_->prepare(*conn, select_bans_);
 		std::unique_ptr<sql::ResultSet> res(stmt->executeQuery());
 		std::vector<IPEntry> entries;
 
@@ -63,10 +64,8 @@ public:
 	}
 
 	void ban(const IPEntry& ban) const override try {
-		const std::string query = "INSERT INTO ip_bans (ip, cidr) VALUES (?, ?)";
-
 		auto conn = pool_.wait_connection(60s);
-		sql::PreparedStatement* stmt = driver_->prepare_cached(*conn, query);
+		sql::PreparedStatement* stmt = driver_->prepare(*conn, insert_ban_);
 		stmt->setString(1, ban.first);
 		stmt->setUInt(2, ban.second);
 		stmt->executeQuery();
@@ -28,21 +28,31 @@ template<typename T>
 class MySQLPatchDAO final : public PatchDAO {
 	T& pool_;
 	drivers::MySQL* driver_;
+	drivers::StatementID select_patches_, update_patch_;
 
 public:
-	MySQLPatchDAO(T& pool) : pool_(pool), driver_(pool.get_driver()) { }
+	MySQLPatchDAO(T& pool) : pool_(pool), driver_(pool.get_driver()) {
+		select_patches_ = driver_->register_statement(
+			"SELECT patches.id, `from`, `to`, mpq, name, size, md5, os, rollup, "
+			"architecture, locale, os.value AS os_val, "
+			"arch.value AS architecture_val, l.value AS locale_val "
+			"FROM patches "
+			"LEFT JOIN architectures arch ON patches.architecture = arch.id "
+			"LEFT JOIN locales l ON patches.locale = l.id "
+			"LEFT JOIN operating_systems os ON patches.os = os.id"
+		);
+
+		update_patch_ = driver_->register_statement(
+			"UPDATE patches SET `from` = ?, `to` = ?, `mpq` = ?, "
+			"`name` = ?, `size` = ?, `md5` = ?, `locale` = ?, "
+			"`architecture` = ?, `os` = ?, `rollup` = ? "
+			"WHERE id = ?"
+		);
+	}
 
 	std::vector<PatchMeta> fetch_patches() const final override try {
-		const std::string query = "SELECT patches.id, `from`, `to`, mpq, name, size, md5, os, rollup, "
-		                          "architecture, locale, os.value AS os_val, "
-		                          "arch.value AS architecture_val, l.value AS locale_val "
-		                          "FROM patches "
-		                          "LEFT JOIN architectures arch ON patches.architecture = arch.id "  
-		                          "LEFT JOIN locales l ON patches.locale = l.id "
-		                          "LEFT JOIN operating_systems os ON patches.os = os.id";
-
 		auto conn = pool_.wait_connection(60s);
-		sql::PreparedStatement* stmt = driver_->prepare_cached(*conn, query);
+		sql::PreparedStatement* stmt = driver_->prepare(*conn, select_patches_);
 		std::unique_ptr<sql::ResultSet> res(stmt->executeQuery());
 		std::vector<PatchMeta> patches;
 
@@ -78,13 +88,8 @@ public:
 	}
 
 	void update(const PatchMeta& meta) const final override try {
-		const std::string query = "UPDATE patches SET `from` = ?, `to` = ?, `mpq` = ?, "
-		                          "`name` = ?, `size` = ?, `md5` = ?, `locale` = ?, "
-		                          "`architecture` = ?, `os` = ?, `rollup` = ? "
-		                          "WHERE id = ?";
-
 		auto conn = pool_.wait_connection(60s);
-		sql::PreparedStatement* stmt = driver_->prepare_cached(*conn, query);
+		sql::PreparedStatement* stmt = driver_->prepare(*conn, update_patch_);
 
 		stmt->setUInt(1, meta.build_from);
 		stmt->setUInt(2, meta.build_to);
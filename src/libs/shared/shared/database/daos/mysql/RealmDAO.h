@@ -24,16 +24,25 @@ template<typename T>
 class MySQLRealmDAO final : public RealmDAO {
 	T& pool_;
 	drivers::MySQL* driver_;
+	drivers::StatementID select_realms_, select_realm_;
 
 public:
-	MySQLRealmDAO(T& pool) : pool_(pool), driver_(pool.get_driver()) { }
+	MySQLRealmDAO(T& pool) : pool_(pool), driver_(pool.get_driver()) {
+		select_realms_ = driver_->register_statement(
+			"SELECT id, name, ip, type, flags, category, "
+			"region, creation_setting, population FROM realms"
+		);
+
+		select_realm_ = driver_->register_statement(
+			"SELECT id, name, ip, type, flags, category, "
+			"region, creation_setting, population FROM realms "
+			"WHERE id = ?"
+		);
+	}
 
 	std::vector<Realm> get_realms() const override final try {
-		const std::string query = "SELECT id, name, ip, type, flags, category, "
-		                          "region, creation_setting, population FROM realms";
-
 		auto conn = pool_.wait_connection(60s);
-		sql::PreparedStatement* stmt = driver_->prepare_cached(*conn, query);
+		sql::PreparedStatement* stmt = driver_->prepare(*conn, select_realms_);
 		std::unique_ptr<sql::ResultSet> res(stmt->executeQuery());
 		std::vector<Realm> realms;
 
@@ -55,12 +64,8 @@ public:
 	}
 
 	boost::optional<Realm> get_realm(std::uint32_t id) const override final try {
-		const std::string query = "SELECT id, name, ip, type, flags, category, "
-		                          "region, creation_setting, population FROM realms "
-		                          "WHERE id = ?";
-	
 		auto conn = pool_.wait_connection(60s);
-		sql::PreparedStatement* stmt = driver_->prepare_cached(*conn, query);
+		sql::PreparedStatement* stmt = driver_->prepare(*conn, select_realm_);
 		stmt->setInt(1, id);
 
 		std::unique_ptr<sql::ResultSet> res(stmt->executeQuery());
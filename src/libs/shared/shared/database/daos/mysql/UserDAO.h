@@ -10,12 +10,17 @@
 
 #include <shared/database/daos/shared_base/UserBase.h>
 #include <conpool/ConnectionPool.h>
+#include <conpool/AsyncExecutor.h>
 #include <mysql_connection.h>
 #include <cppconn/exception.h>
 #include <conpool/drivers/MySQL/Driver.h>
 #include <cppconn/prepared_statement.h>
+#include <algorithm>
 #include <chrono>
 #include <memory>
+#include <string>
+#include <vector>
+#include <cstddef>
 
 namespace ember { namespace dal { 
 
@@ -23,22 +28,24 @@ using namespace std::chrono_literals;
 
 template<typename T>
 class MySQLUserDAO final : public UserDAO {
+	// rows per multi-row statement - bounds the number of distinct statements cached per connection
+	static const std::size_t MAX_BATCH_ROWS = 64;
+
 	T& pool_;
+	connection_pool::AsyncExecutor<T>* executor_;
 	drivers::MySQL* driver_;
+	drivers::StatementID select_user_, insert_survey_, clear_survey_, insert_login_, select_counts_;
 
-public:
-	MySQLUserDAO(T& pool) : pool_(pool), driver_(pool.get_driver()) { }
+	connection_pool::AsyncExecutor<T>& executor() const {
+		if(!executor_) {
+			throw exception("No executor available for asynchronous queries");
+		}
 
-	boost::optional<User> user(const std::string& username) const override try {
-		const std::string query = "SELECT u.username, u.id, u.s, u.v, u.pin_method, u.pin, "
-		                          "u.totp_key, b.user_id as banned, u.survey_request, u.subscriber, "
-		                          "s.user_id as suspended FROM users u "
-		                          "LEFT JOIN bans b ON u.id = b.user_id "
-		                          "LEFT JOIN suspensions s ON u.id = s.user_id "
-		                          "WHERE username = ?";
+		return *executor_;
+	}
 
-		auto conn = pool_.wait_connection(5s);
-		sql::PreparedStatement* stmt = driver_->prepare_cached(*conn, query);
+	boost::optional<User> fetch_user(drivers::MySQLConnection conn, const std::string& username) const try {
+		sql::PreparedStatement* stmt = driver_->prepare(conn, select_user_);
 		stmt->setString(1, username);
 		std::unique_ptr<sql::ResultSet> res(stmt->executeQuery());
 
@@ -56,16 +63,77 @@ public:
 		throw exception(e.what());
 	}
 
+	// builds "prefix (?, ?), (?, ?)..." for the given number of rows - these aren't registered
+	static std::string batch_query(const std::string& prefix, const std::string& row, std::size_t rows) {
+		std::string query(prefix);
+		query.reserve(prefix.size() + (row.size() + 2) * rows);
+
+		for(std::size_t i = 0; i < rows; ++i) {
+			if(i) {
+				query += ", ";
+			}
+
+			query += row;
+		}
+
+		return query;
+	}
+
+public:
+	MySQLUserDAO(T& pool, connection_pool::AsyncExecutor<T>* executor = nullptr)
+	             : pool_(pool), executor_(executor), driver_(pool.get_driver()) {
+		select_user_ = driver_->register_statement(
+			"SELECT u.username, u.id, u.s, u.v, u.pin_method, u.pin, "
+			"u.totp_key, b.user_id as banned, u.survey_request, u.subscriber, "
+			"s.user_id as suspended FROM users u "
+			"LEFT JOIN bans b ON u.id = b.user_id "
+			"LEFT JOIN suspensions s ON u.id = s.user_id "
+			"WHERE username = ?"
+		);
+
+		// intentionally not storing the user ID with the survey data, not an oversight :)
+		insert_survey_ = driver_->register_statement(
+			"INSERT INTO survey_results (survey_id, data) VALUES (?, ?)"
+		);
+
+		clear_survey_ = driver_->register_statement(
+			"UPDATE users SET survey_request = 0 WHERE id = ?"
+		);
+
+		insert_login_ = driver_->register_statement(
+			"INSERT INTO login_history (user_id, ip) VALUES "
+			"((SELECT id AS user_id FROM users WHERE id = ?), ?)"
+		);
+
+		select_counts_ = driver_->register_statement(
+			"SELECT COUNT(c.id) AS count, c.realm_id "
+			"FROM characters c "
+			"WHERE c.account_id = ? AND c.deletion_date IS NULL "
+			"GROUP BY c.realm_id"
+		);
+	}
+
+	boost::optional<User> user(const std::string& username) const override try {
+		auto conn = pool_.wait_connection(5s);
+		return fetch_user(*conn, username);
+	} catch(std::exception& e) {
+		throw exception(e.what());
+	}
+
+	bool user_async(const std::string& username, Callback<boost::optional<User>> callback,
+	                Dispatcher dispatcher = nullptr) const override {
+		return executor().try_submit([this, username](drivers::MySQLConnection conn) {
+			return fetch_user(conn, username);
+		}, std::move(callback), std::move(dispatcher));
+	}
+
 	void save_survey(std::uint32_t account_id, std::uint32_t survey_id,
 	                 const std::string& data) const override try {
 		auto conn = pool_.wait_connection(5s);
 		conn->setAutoCommit(false);
 
 		try {
-			// intentionally not storing the user ID with the survey data, not an oversight :)
-			std::string query = "INSERT INTO survey_results (survey_id, data) VALUES (?, ?)";
-
-			sql::PreparedStatement* stmt = driver_->prepare_cached(*conn, query);
+			sql::PreparedStatement* stmt = driver_->prepare(*conn, insert_survey_);
 			stmt->setUInt(1, survey_id);
 			stmt->setString(2, data);
 	
@@ -73,9 +141,7 @@ public:
 				throw exception("Unable to save survey data for account ID " + std::to_string(account_id));
 			}
 
-			query = "UPDATE users SET survey_request = 0 WHERE id = ?";
-
-			stmt = driver_->prepare_cached(*conn, query);
+			stmt = driver_->prepare(*conn, clear_survey_);
 			stmt->setUInt(1, account_id);
 
 			if(!stmt->executeUpdate()) {
@@ -95,11 +161,8 @@ public:
 	}
 
 	void record_last_login(std::uint32_t account_id, const std::string& ip) const override try {
-		const std::string query = "INSERT INTO login_history (user_id, ip) VALUES "
-		                          "((SELECT id AS user_id FROM users WHERE id = ?), ?)";
-
 		auto conn = pool_.wait_connection(5s);
-		sql::PreparedStatement* stmt = driver_->prepare_cached(*conn, query);
+		sql::PreparedStatement* stmt = driver_->prepare(*conn, insert_login_);
 		stmt->setUInt(1, account_id);
 		stmt->setString(2, ip);
 		
@@ -110,20 +173,77 @@ public:
 		throw exception(e.what());
 	}
 
+	void record_logins(const std::vector<LoginRecord>& logins) const override try {
+		auto conn = pool_.wait_connection(5s);
+
+		for(std::size_t offset = 0; offset < logins.size(); offset += MAX_BATCH_ROWS) {
+			const auto rows = std::min<std::size_t>(logins.size() - offset, std::size_t{MAX_BATCH_ROWS});
+			const auto query = batch_query("INSERT INTO login_history (user_id, ip) VALUES ", "(?, ?)", rows);
+			sql::PreparedStatement* stmt = driver_->prepare_cached(*conn, query);
+
+			for(std::size_t i = 0; i < rows; ++i) {
+				const auto& login = logins[offset + i];
+				stmt->setUInt(i * 2 + 1, login.account_id);
+				stmt->setString(i * 2 + 2, login.ip);
+			}
+
+			stmt->executeUpdate();
+		}
+	} catch(std::exception& e) {
+		throw exception(e.what());
+	}
+
+	void save_surveys(const std::vector<SurveyResult>& surveys) const override try {
+		auto conn = pool_.wait_connection(5s);
+		conn->setAutoCommit(false);
+
+		try {
+			for(std::size_t offset = 0; offset < surveys.size(); offset += MAX_BATCH_ROWS) {
+				const auto rows = std::min<std::size_t>(surveys.size() - offset, std::size_t{MAX_BATCH_ROWS});
+
+				// intentionally not storing the user ID with the survey data, not an oversight :)
+				auto query = batch_query("INSERT INTO survey_results (survey_id, data) VALUES ", "(?, ?)", rows);
+				sql::PreparedStatement* stmt = driver_->prepare_cached(*conn, query);
+
+				for(std::size_t i = 0; i < rows; ++i) {
+					const auto& survey = surveys[offset + i];
+					stmt->setUInt(i * 2 + 1, survey.survey_id);
+					stmt->setString(i * 2 + 2, survey.data);
+				}
+
+				stmt->executeUpdate();
+
+				query = batch_query("UPDATE users SET survey_request = 0 WHERE id IN (", "?", rows) + ")";
+				stmt = driver_->prepare_cached(*conn, query);
+
+				for(std::size_t i = 0; i < rows; ++i) {
+					stmt->setUInt(i + 1, surveys[offset + i].account_id);
+				}
+
+				stmt->executeUpdate();
+			}
+
+			conn->commit();
+		} catch(std::exception& e) {
+			conn->rollback();
+			conn->setAutoCommit(true);
+			throw exception(e.what());
+		}
+
+		conn->setAutoCommit(true);
+	} catch(std::exception& e) {
+		throw exception(e.what());
+	}
+
 	std::unordered_map<std::uint32_t, std::uint32_t> character_counts(std::uint32_t account_id) const override try {
-		const std::string query = "SELECT COUNT(c.id) AS count, c.realm_id "
-		                          "FROM users u, characters c "
-		                          "WHERE u.id = ? AND c.deletion_date IS NULL "
-		                          "GROUP BY c.realm_id";
-		
 		auto conn = pool_.wait_connection(5s);
-		sql::PreparedStatement* stmt = driver_->prepare_cached(*conn, query);
+		sql::PreparedStatement* stmt = driver_->prepare(*conn, select_counts_);
 		stmt->setUInt(1, account_id);
 		std::unique_ptr<sql::ResultSet> res(stmt->executeQuery());
 
 		std::unordered_map<std::uint32_t, std::uint32_t> counts;
 
-		if(res->next()) {
+		while(res->next()) {
 			counts.emplace(res->getUInt("realm_id"), res->getUInt("count"));
 		}
 
@@ -134,8 +254,8 @@ public:
 };
 
 template<typename T>
-std::unique_ptr<MySQLUserDAO<T>> user_dao(T& pool) {
-	return std::make_unique<MySQLUserDAO<T>>(pool);
+std::unique_ptr<MySQLUserDAO<T>> user_dao(T& pool, connection_pool::AsyncExecutor<T>* executor = nullptr) {
+	return std::make_unique<MySQLUserDAO<T>>(pool, executor);
 }
 
 }} // dal, ember
\ No newline at end of file
@@ -8,6 +8,7 @@
 
 #pragma once
 
+#include <shared/database/Async.h>
 #include <shared/database/Exception.h>
 #include <shared/database/objects/Character.h>
 #include <boost/optional.hpp>
@@ -26,6 +27,19 @@ public:
 	virtual void restore(std::uint64_t id) const = 0;
 	virtual void create(const Character& character) const = 0;
 	virtual void update(const Character& character) const = 0;
+
+	// queued for a database thread, returning false if its queue is full
+	virtual bool character_async(std::uint64_t id, Callback<boost::optional<Character>> callback,
+	                             Dispatcher dispatcher = nullptr) const = 0;
+	virtual bool character_async(const std::string& name, std::uint32_t realm_id,
+	                             Callback<boost::optional<Character>> callback,
+	                             Dispatcher dispatcher = nullptr) const = 0;
+	virtual bool characters_async(std::uint32_t account_id, std::uint32_t realm_id,
+	                              Callback<std::vector<Character>> callback,
+	                              Dispatcher dispatcher = nullptr) const = 0;
+	virtual bool create_async(const Character& character, Callback<void> callback,
+	                          Dispatcher dispatcher = nullptr) const = 0;
+
 	virtual ~CharacterDAO() = default;
 };
 
@@ -8,11 +8,15 @@
 
 #pragma once
 
+#include <shared/database/Async.h>
 #include <shared/database/Exception.h>
 #include <shared/database/objects/User.h>
+#include <shared/database/objects/LoginRecord.h>
+#include <shared/database/objects/SurveyResult.h>
 #include <boost/optional.hpp>
 #include <unordered_map>
 #include <string>
+#include <vector>
 #include <cstdint>
 
 namespace ember { namespace dal {
@@ -23,6 +27,13 @@ public:
 	virtual void record_last_login(std::uint32_t account_id, const std::string& ip) const = 0;
 	virtual std::unordered_map<std::uint32_t, std::uint32_t> character_counts(std::uint32_t account_id) const = 0;
 	virtual void save_survey(std::uint32_t account_id, std::uint32_t survey_id, const std::string& data) const = 0;
+	virtual void record_logins(const std::vector<LoginRecord>& logins) const = 0;
+	virtual void save_surveys(const std::vector<SurveyResult>& surveys) const = 0;
+
+	// queued for a database thread, returning false if its queue is full
+	virtual bool user_async(const std::string& username, Callback<boost::optional<User>> callback,
+	                        Dispatcher dispatcher = nullptr) const = 0;
+
 	virtual ~UserDAO() = default;
 };
 
@@ -0,0 +1,22 @@
+/*
+ * Copyright (c) 2016 Ember
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include <string>
+#include <cstdint>
+
+namespace ember {
+
+struct SurveyResult {
+	std::uint32_t account_id;
+	std::uint32_t survey_id;
+	std::string data;
+};
+
+} // ember
\ No newline at end of file
@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) 2016 Ember
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace ember {
+
+/*
+ * Fixed-size histogram of durations that can be recorded to from any thread
+ * without locking. Buckets are log-linear - each power of two microseconds is
+ * split into four - so percentiles are accurate to within 25% from a single
+ * microsecond up to over an hour, in a kilobyte of counters.
+ *
+ * Intended to be drained periodically by the metrics poller, with the
+ * percentiles sent as gauges rather than a datagram per recorded value.
+ */
+class Histogram final {
+	static const std::size_t SUB_BITS = 2;
+	static const std::size_t SUB_BUCKETS = 1 << SUB_BITS;
+	static const std::size_t MAX_EXPONENT = 32;
+
+public:
+	static const std::size_t BUCKETS = SUB_BUCKETS + (MAX_EXPONENT - SUB_BITS) * SUB_BUCKETS;
+
+	struct Snapshot {
+		std::array<std::uint64_t, BUCKETS> buckets;
+		std::uint64_t count;
+		std::uint64_t max;
+
+		// returns the upper bound of the bucket holding the given percentile (0 - 100)
+		std::chrono::microseconds percentile(double pct) const {
+			if(!count) {
+				return std::chrono::microseconds(0);
+			}
+
+			const auto rank = static_cast<std::uint64_t>(pct / 100.0 * (count - 1)) + 1;
+			std::uint64_t seen = 0;
+
+			for(std::size_t i = 0; i < BUCKETS; ++i) {
+				seen += buckets[i];
+
+				if(seen >= rank) {
+					const auto bound = upper_bound(i);
+					return std::chrono::microseconds(bound < max? bound : max);
+				}
+			}
+
+			return std::chrono::microseconds(max);
+		}
+	};
+
+private:
+	std::array<std::atomic<std::uint64_t>, BUCKETS> buckets_;
+	std::atomic<std::uint64_t> max_;
+
+	static std::size_t index(std::uint64_t value) {
+		if(value < SUB_BUCKETS) {
+			return static_cast<std::size_t>(value);
+		}
+
+		std::size_t exponent = 0;
+
+		for(auto shifted = value; shifted > 1; shifted >>= 1) {
+			++exponent;
+		}
+
+		if(exponent >= MAX_EXPONENT) {
+			return BUCKETS - 1;
+		}
+
+		const auto sub = (value >> (exponent - SUB_BITS)) & (SUB_BUCKETS - 1);
+		return SUB_BUCKETS + (exponent - SUB_BITS) * SUB_BUCKETS + static_cast<std::size_t>(sub);
+	}
+
+	static std::uint64_t upper_bound(std::size_t index) {
+		if(index < SUB_BUCKETS) {
+			return index;
+		}
+
+		const auto exponent = (index - SUB_BUCKETS) / SUB_BUCKETS + SUB_BITS;
+		const auto sub = (index - SUB_BUCKETS) % SUB_BUCKETS;
+		return ((SUB_BUCKETS + sub + 1) << (exponent - SUB_BITS)) - 1;
+	}
+
+public:
+	Histogram() : max_(0) {
+		for(auto& bucket : buckets_) {
+			bucket = 0;
+		}
+	}
+
+	template<typename Duration>
+	void record(Duration duration) {
+		const auto us = std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+		const auto value = us > 0? static_cast<std::uint64_t>(us) : 0;
+
+		buckets_[index(value)].fetch_add(1, std::memory_order_relaxed);
+
+		auto max = max_.load(std::memory_order_relaxed);
+
+		while(value > max && !max_.compare_exchange_weak(max, value, std::memory_order_relaxed)) { }
+	}
+
+	// returns the values recorded since the last call, for periodic metrics reporting
+	Snapshot reset() {
+		Snapshot snapshot;
+		snapshot.count = 0;
+
+		for(std::size_t i = 0; i < BUCKETS; ++i) {
+			snapshot.buckets[i] = buckets_[i].exchange(0, std::memory_order_relaxed);
+			snapshot.count += snapshot.buckets[i];
+		}
+
+		snapshot.max = max_.exchange(0, std::memory_order_relaxed);
+		return snapshot;
+	}
+};
+
+} // ember
\ No newline at end of file
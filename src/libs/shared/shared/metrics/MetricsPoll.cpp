@@ -49,6 +49,10 @@ void MetricsPoll::timeout(const boost::system::error_code& ec) {
 	}
 
 	timer_.expires_from_now(FREQUENCY);
+
+	timer_.async_wait([this](const boost::system::error_code& ec) {
+		timeout(ec);
+	});
 }
 
 } // ember
\ No newline at end of file
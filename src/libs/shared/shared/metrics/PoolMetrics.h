@@ -0,0 +1,48 @@
+/*
+ * Copyright (c) 2016 Ember
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include <shared/metrics/Metrics.h>
+#include <shared/metrics/Histogram.h>
+#include <conpool/ConnectionPool.h>
+#include <string>
+
+namespace ember {
+
+/*
+ * Forwards a connection pool's stats under db_pool.*, for registering as a
+ * metrics poller source - pool.reset_stats() can be called from the poller's
+ * thread. Timings are in microseconds.
+ */
+inline void report_pool_stats(Metrics& metrics, const connection_pool::PoolStats& stats) {
+	auto histogram = [&metrics](const std::string& prefix, const Histogram::Snapshot& snapshot) {
+		if(!snapshot.count) {
+			return;
+		}
+
+		metrics.increment((prefix + ".count").c_str(), snapshot.count);
+		metrics.gauge((prefix + ".p50_us").c_str(), snapshot.percentile(50).count());
+		metrics.gauge((prefix + ".p99_us").c_str(), snapshot.percentile(99).count());
+		metrics.gauge((prefix + ".max_us").c_str(), snapshot.max);
+	};
+
+	metrics.gauge("db_pool.size", stats.size);
+	metrics.gauge("db_pool.waiting", stats.wait.waiting);
+	metrics.gauge("db_pool.peak_waiting", stats.wait.peak_waiting);
+	metrics.increment("db_pool.timeouts", stats.wait.timeouts);
+	metrics.increment("db_pool.growth_events", stats.growth_events);
+	metrics.increment("db_pool.sweeps", stats.sweeps);
+	metrics.increment("db_pool.keep_alive_failures", stats.keep_alive_failures);
+	histogram("db_pool.checkout_wait", stats.wait.waits);
+	histogram("db_pool.hold", stats.holds);
+	histogram("db_pool.open", stats.opens);
+	histogram("db_pool.refresh", stats.refreshes);
+}
+
+} // ember
\ No newline at end of file
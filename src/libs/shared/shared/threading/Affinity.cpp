@@ -44,4 +44,27 @@ void set_affinity(std::thread& thread, unsigned int core) {
 #endif
 }
 
+/*
+ * Only schedules the thread when nothing else wants the core, which is
+ * intended for background work that mustn't compete with request handling
+ */
+void set_idle_priority(std::thread& thread) {
+#ifdef _WIN32
+	if(SetThreadPriority(thread.native_handle(), THREAD_PRIORITY_IDLE) == 0) {
+		throw std::runtime_error("Unable to set thread priority, error code " + std::to_string(GetLastError()));
+	}
+#elif defined TARGET_OS_MAC
+	// todo
+#elif defined __linux__
+	sched_param param {};
+	auto ret = pthread_setschedparam(thread.native_handle(), SCHED_IDLE, &param);
+
+	if(ret) {
+		throw std::runtime_error("Unable to set thread priority, error code " + std::to_string(ret));
+	}
+#else
+	#pragma message WARN("Setting thread priority is not implemented for this platform. Implement it, please!");
+#endif
+}
+
 } // ember
\ No newline at end of file
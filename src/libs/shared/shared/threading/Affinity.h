@@ -13,5 +13,6 @@
 namespace ember {
 
 void set_affinity(std::thread& thread, unsigned int core);
+void set_idle_priority(std::thread& thread);
 
 } // ember
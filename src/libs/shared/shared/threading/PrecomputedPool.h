@@ -0,0 +1,137 @@
+/*
+ * Copyright (c) 2016 Ember
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include <shared/threading/Affinity.h>
+#include <boost/optional.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace ember {
+
+/*
+ * Holds a bounded stock of values that are expensive to generate but don't
+ * depend on the request that uses them. A background thread tops the pool up
+ * whenever it drops below half capacity and each value is handed out once.
+ *
+ * take() never blocks on generation - if the pool has run dry, the caller
+ * receives nothing and is expected to generate the value itself.
+ */
+template<typename T>
+class PrecomputedPool final {
+public:
+	typedef std::function<T()> Generator;
+
+	struct Counters {
+		std::uint64_t generated;
+		std::uint64_t exhausted;
+	};
+
+private:
+	const Generator generate_;
+	const std::size_t capacity_;
+	const std::size_t low_watermark_;
+	std::vector<T> items_;
+	std::mutex lock_;
+	std::condition_variable refill_cond_;
+	std::atomic<std::uint64_t> generated_;
+	std::atomic<std::uint64_t> exhausted_;
+	bool failed_;
+	bool stop_;
+	std::thread worker_;
+
+	void refill() {
+		std::unique_lock<std::mutex> guard(lock_);
+
+		while(!stop_) {
+			refill_cond_.wait(guard, [&] { return stop_ || (!failed_ && items_.size() < low_watermark_); });
+
+			while(!stop_ && items_.size() < capacity_) {
+				guard.unlock();
+
+				try {
+					T item = generate_();
+					guard.lock();
+					items_.emplace_back(std::move(item));
+					++generated_;
+				} catch(const std::exception&) {
+					// give up until the next take(), callers will generate their own values
+					guard.lock();
+					failed_ = true;
+					break;
+				}
+			}
+		}
+	}
+
+public:
+	PrecomputedPool(std::size_t capacity, Generator generate)
+	                : generate_(std::move(generate)), capacity_(capacity),
+	                  low_watermark_((capacity + 1) / 2), generated_(0), exhausted_(0),
+	                  failed_(false), stop_(false) {
+		items_.reserve(capacity_);
+		worker_ = std::thread(&PrecomputedPool::refill, this);
+
+		try {
+			set_idle_priority(worker_);
+		} catch(const std::exception&) {
+			// not fatal, the pool will just compete with other threads for time
+		}
+	}
+
+	~PrecomputedPool() {
+		{
+			std::lock_guard<std::mutex> guard(lock_);
+			stop_ = true;
+		}
+
+		refill_cond_.notify_one();
+		worker_.join();
+	}
+
+	boost::optional<T> take() {
+		std::lock_guard<std::mutex> guard(lock_);
+		failed_ = false;
+
+		if(items_.empty()) {
+			++exhausted_;
+			refill_cond_.notify_one();
+			return boost::none;
+		}
+
+		T item = std::move(items_.back());
+		items_.pop_back();
+
+		if(items_.size() < low_watermark_) {
+			refill_cond_.notify_one();
+		}
+
+		return std::move(item);
+	}
+
+	std::size_t size() {
+		std::lock_guard<std::mutex> guard(lock_);
+		return items_.size();
+	}
+
+	// returns the counters accumulated since the last call, for periodic metrics reporting
+	Counters reset_counters() {
+		return { generated_.exchange(0), exhausted_.exchange(0) };
+	}
+};
+
+} // ember
\ No newline at end of file
@@ -9,6 +9,7 @@
 #include "ServicePool.h"
 #include <shared/threading/Affinity.h>
 #include <stdexcept>
+#include <thread>
 
 namespace ember {
 
@@ -18,7 +19,8 @@ ServicePool::ServicePool(std::size_t pool_size) : pool_size_(pool_size), next_se
 	}
 
 	for(std::size_t i = 0; i < pool_size; ++i) {
-		auto io_service = std::make_shared<boost::asio::io_service>();
+		// each service is only ever run by a single thread, so let ASIO take its single-threaded paths
+		auto io_service = std::make_shared<boost::asio::io_service>(1);
 		auto work = std::make_shared<boost::asio::io_service::work>(*io_service);
 		services_.emplace_back(io_service);
 		work_.emplace_back(work);
@@ -13,7 +13,8 @@ namespace ember {
 
 using namespace std::string_literals;
 
-ThreadPool::ThreadPool(std::size_t initial_count) : work_(service_), stopped_(false) {
+ThreadPool::ThreadPool(std::size_t initial_count, std::size_t max_queued)
+                       : work_(service_), queued_(0), max_queued_(max_queued), stopped_(false) {
 	for(std::size_t i = 0; i < initial_count; ++i) {
 		workers_.emplace_back(static_cast<std::size_t(boost::asio::io_service::*)()>
 			(&boost::asio::io_service::run), &service_); 
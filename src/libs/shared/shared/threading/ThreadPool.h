@@ -9,6 +9,7 @@
 #pragma once
 
 #include <boost/asio/io_service.hpp>
+#include <atomic>
 #include <functional>
 #include <memory>
 #include <mutex>
@@ -32,10 +33,25 @@ private:
 	std::vector<std::thread> workers_;
 	LogCallback log_cb_;
 	std::mutex log_cb_lock_;
+	std::atomic<std::size_t> queued_;
+	const std::size_t max_queued_;
 	bool stopped_;
 
+	// callers count the work in queued_ before posting it
+	template<typename T>
+	void post(T work) {
+		service_.post([this, work] {
+			--queued_;
+			work();
+		});
+	}
+
 public:
-	explicit ThreadPool(std::size_t initial_count);
+	/*
+	 * max_queued bounds the number of jobs that may be waiting for a worker
+	 * when submitted through try_run - zero means unbounded
+	 */
+	explicit ThreadPool(std::size_t initial_count, std::size_t max_queued = 0);
 	~ThreadPool();
 
 	template<typename T>
@@ -43,8 +59,36 @@ public:
 #ifdef DEBUG_NO_THREADS
 		work();
 #else
-		service_.post(work);
+		++queued_;
+		post(work);
+#endif
+	}
+
+	/*
+	 * Submits the work unless the pool's backlog has hit its limit, allowing
+	 * callers to shed load rather than queueing work that'll likely time out
+	 */
+	template<typename T>
+	bool try_run(T work) {
+		// reserve a slot before checking the limit, so concurrent callers can't overshoot it
+		const std::size_t queued = queued_++;
+
+		if(max_queued_ && queued >= max_queued_) {
+			--queued_;
+			return false;
+		}
+
+#ifdef DEBUG_NO_THREADS
+		--queued_;
+		work();
+#else
+		post(work);
 #endif
+		return true;
+	}
+
+	std::size_t queue_depth() const {
+		return queued_;
 	}
 
 	void shutdown();
@@ -29,8 +29,9 @@ Botan::secure_vector<Botan::byte> generate_md5(const std::string& file) {
 	auto remaining = static_cast<std::size_t>(stream.tellg());
 	stream.seekg(0, std::ios::beg);
 
+	// read in large blocks, hashing a block at a time is dominated by call overhead
 	Botan::MD5 hasher;
-	std::size_t block_size = hasher.hash_block_size();
+	const std::size_t block_size = 64 * 1024;
 	std::vector<char> buffer(block_size);
 
 	while(remaining) {
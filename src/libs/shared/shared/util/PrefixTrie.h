@@ -0,0 +1,201 @@
+/*
+ * Copyright (c) 2016 Ember
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include <boost/optional.hpp>
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace ember {
+
+/*
+ * Path-compressed binary trie over fixed-width keys (IPv4/IPv6 addresses in
+ * network byte order) supporting longest-prefix matching.
+ *
+ * Each node stores its complete prefix, so runs of single-child nodes are
+ * collapsed and a lookup visits at most one node per stored prefix along
+ * the key's path rather than one per bit. Nodes live in a single vector and
+ * reference each other by index to keep them close together in memory.
+ */
+template<std::size_t Bytes>
+class PrefixTrie final {
+public:
+	typedef std::array<std::uint8_t, Bytes> Key;
+	static const std::size_t BITS = Bytes * 8;
+
+private:
+	static const std::uint32_t NONE = std::numeric_limits<std::uint32_t>::max();
+
+	struct Node {
+		Key prefix;
+		std::uint8_t length;
+		bool terminal;
+		std::uint32_t children[2];
+	};
+
+	std::vector<Node> nodes_;
+	std::uint32_t root_ = NONE;
+
+	static int bit(const Key& key, std::size_t index) {
+		return (key[index / 8] >> (7 - (index % 8))) & 1;
+	}
+
+	static Key mask(Key key, std::size_t length) {
+		for(std::size_t i = 0; i < Bytes; ++i) {
+			if(length >= (i + 1) * 8) {
+				continue;
+			}
+
+			const std::size_t keep = length > i * 8? length - i * 8 : 0;
+			key[i] &= static_cast<std::uint8_t>(0xFF << (8 - keep));
+		}
+
+		return key;
+	}
+
+	static std::size_t common_length(const Key& lhs, const Key& rhs, std::size_t max) {
+		std::size_t length = 0;
+
+		for(std::size_t i = 0; i < Bytes && length < max; ++i) {
+			const std::uint8_t diff = lhs[i] ^ rhs[i];
+
+			if(!diff) {
+				length += 8;
+				continue;
+			}
+
+			for(std::uint8_t probe = 0x80; !(diff & probe); probe >>= 1) {
+				++length;
+			}
+
+			break;
+		}
+
+		return length < max? length : max;
+	}
+
+	static bool matches(const Node& node, const Key& key) {
+		const std::size_t bytes = node.length / 8;
+
+		for(std::size_t i = 0; i < bytes; ++i) {
+			if(node.prefix[i] != key[i]) {
+				return false;
+			}
+		}
+
+		const std::size_t rem = node.length % 8;
+
+		if(!rem) {
+			return true;
+		}
+
+		const auto partial = static_cast<std::uint8_t>(0xFF << (8 - rem));
+		return (key[bytes] & partial) == node.prefix[bytes];
+	}
+
+	std::uint32_t add_node(const Key& prefix, std::size_t length, bool terminal) {
+		nodes_.push_back({ prefix, static_cast<std::uint8_t>(length), terminal, { NONE, NONE } });
+		return static_cast<std::uint32_t>(nodes_.size() - 1);
+	}
+
+	void link(std::uint32_t parent, int branch, std::uint32_t child) {
+		if(parent == NONE) {
+			root_ = child;
+		} else {
+			nodes_[parent].children[branch] = child;
+		}
+	}
+
+public:
+	void insert(const Key& key, std::size_t length) {
+		if(length > BITS) {
+			throw std::invalid_argument("Prefix length exceeds key width");
+		}
+
+		const Key prefix = mask(key, length);
+		std::uint32_t parent = NONE;
+		int branch = 0;
+		std::uint32_t index = root_;
+
+		while(index != NONE) {
+			const Node node = nodes_[index]; // copied, add_node may reallocate
+			const auto max = std::min<std::size_t>(length, node.length);
+			const auto common = common_length(prefix, node.prefix, max);
+
+			// the new prefix diverges from or is shorter than this node's, so split here
+			if(common < node.length) {
+				std::uint32_t split;
+
+				if(common == length) {
+					split = add_node(prefix, length, true);
+				} else {
+					split = add_node(mask(prefix, common), common, false);
+					const auto leaf = add_node(prefix, length, true);
+					nodes_[split].children[bit(prefix, common)] = leaf;
+				}
+
+				nodes_[split].children[bit(node.prefix, common)] = index;
+				link(parent, branch, split);
+				return;
+			}
+
+			if(length == node.length) {
+				nodes_[index].terminal = true;
+				return;
+			}
+
+			parent = index;
+			branch = bit(prefix, node.length);
+			index = node.children[branch];
+		}
+
+		link(parent, branch, add_node(prefix, length, true));
+	}
+
+	// returns the length of the longest stored prefix containing the key
+	boost::optional<std::size_t> match(const Key& key) const {
+		boost::optional<std::size_t> longest;
+		std::uint32_t index = root_;
+
+		while(index != NONE) {
+			const Node& node = nodes_[index];
+
+			if(!matches(node, key)) {
+				break;
+			}
+
+			if(node.terminal) {
+				longest = node.length;
+			}
+
+			if(node.length == BITS) {
+				break;
+			}
+
+			index = node.children[bit(key, node.length)];
+		}
+
+		return longest;
+	}
+
+	bool empty() const {
+		return root_ == NONE;
+	}
+
+	std::size_t node_count() const {
+		return nodes_.size();
+	}
+};
+
+} // ember
\ No newline at end of file
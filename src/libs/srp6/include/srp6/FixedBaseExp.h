@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) 2016 Ember
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include <botan/bigint.h>
+#include <botan/reducer.h>
+#include <array>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace ember { namespace srp6 {
+
+/*
+ * Fixed-base exponentiation for a generator that never changes.
+ *
+ * The exponent is split into WINDOW_BITS-sized digits and g^(digit * 2^(w * i))
+ * is precomputed for every window position, so evaluating g^x costs one modular
+ * multiplication per window and no squarings at all. Every table entry in a row
+ * is read on each lookup and every window is evaluated regardless of the
+ * exponent's length, so neither the memory access pattern nor the number of
+ * multiplications depends on the exponent.
+ *
+ * Exponents must be non-negative and no wider than MAX_EXPONENT_BITS -
+ * anything else throws std::invalid_argument. Generator routes wider
+ * exponents to Botan::power_mod instead.
+ */
+class FixedBaseExp final {
+public:
+	static const std::size_t WINDOW_BITS = 4;
+	static const std::size_t MAX_EXPONENT_BITS = 256;
+
+private:
+	static const std::size_t ROW_SIZE = 1 << WINDOW_BITS;
+	static const std::size_t WINDOWS = MAX_EXPONENT_BITS / WINDOW_BITS;
+	static const std::size_t EXPONENT_BYTES = MAX_EXPONENT_BITS / 8;
+
+	static_assert(8 % WINDOW_BITS == 0, "Windows must not straddle exponent bytes");
+	static_assert(MAX_EXPONENT_BITS % 8 == 0, "Exponent width must be a whole number of bytes");
+
+	typedef std::array<Botan::BigInt, ROW_SIZE> Row;
+
+	const Botan::BigInt g_;
+	const Botan::Modular_Reducer reducer_;
+	const std::size_t words_;
+	std::vector<Row> table_;
+
+public:
+	FixedBaseExp(const Botan::BigInt& g, const Botan::BigInt& N);
+
+	Botan::BigInt operator()(const Botan::BigInt& x) const;
+	const Botan::Modular_Reducer& reducer() const { return reducer_; }
+};
+
+}} //srp6, ember
\ No newline at end of file
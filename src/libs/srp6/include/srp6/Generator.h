@@ -8,8 +8,10 @@
 
 #pragma once
 
+#include <srp6/FixedBaseExp.h>
 #include <botan/bigint.h>
 #include <botan/numthry.h>
+#include <memory>
 
 namespace ember { namespace srp6 {
 
@@ -21,17 +23,29 @@ struct Generator {
 		_6144_BIT, _8192_BIT
 	};
 
-	Generator(const Botan::BigInt& g, const Botan::BigInt& N) : g_(g), N_(N) {}
+	Generator(const Botan::BigInt& g, const Botan::BigInt& N)
+	          : g_(g), N_(N), reducer_(std::make_shared<const Botan::Modular_Reducer>(N)) {}
 	explicit Generator(Group group);
 
 	inline Botan::BigInt prime() const { return N_; }
 	inline Botan::BigInt generator() const { return g_; }
+	inline std::shared_ptr<const Botan::Modular_Reducer> reducer() const { return reducer_; }
+	inline bool known_prime() const { return prime_; } // only the built-in groups are vetted
+	// exponents the fixed-base table can't cover take the generic (variable time) path
 	inline Botan::BigInt operator()(const Botan::BigInt& x) const {
+		if(fixed_ && !x.is_negative() && x.bits() <= FixedBaseExp::MAX_EXPONENT_BITS) {
+			return (*fixed_)(x);
+		}
+
 		return Botan::power_mod(g_, x, N_);
 	}
 
 private:
 	Botan::BigInt g_, N_;
+	std::shared_ptr<const FixedBaseExp> fixed_; // shared between all generators for a group
+	std::shared_ptr<const Botan::Modular_Reducer> reducer_;
+	bool prime_ = false;
+
 };
 
 }} //srp6, ember
\ No newline at end of file
@@ -12,17 +12,34 @@
 #include <srp6/Generator.h>
 #include <srp6/Exception.h>
 #include <botan/bigint.h>
+#include <botan/reducer.h>
+#include <memory>
 #include <cstddef>
 
 namespace ember { namespace srp6 {
 
+/*
+ * The server's ephemeral key pair doesn't depend on the user, so it can be
+ * generated ahead of time - each pair must only ever be used for one session
+ */
+struct PrecomputedEphemeral {
+	Botan::BigInt b;
+	Botan::BigInt g_b;
+};
+
+PrecomputedEphemeral precompute_ephemeral(const Generator& gen, std::size_t key_size = 32);
+
 class Server final {
 	const Botan::BigInt v_, N_, b_;
+	const std::shared_ptr<const Botan::Modular_Reducer> reducer_;
+	const bool prime_modulus_;
 	Botan::BigInt B_, A_, k_{ 3 };
 
 public:
 	Server(const Generator& gen, const Botan::BigInt& v, const Botan::BigInt& b, bool srp6a = false);
 	Server(const Generator& gen, const Botan::BigInt& v, std::size_t key_size = 32, bool srp6a = false);
+	Server(const Generator& gen, const Botan::BigInt& v, const PrecomputedEphemeral& ephemeral,
+	       bool srp6a = false);
 	inline const Botan::BigInt& public_ephemeral() const { return B_; }
 	SessionKey session_key(const Botan::BigInt& A, Compliance mode = Compliance::GAME,
 	                       bool interleave_override = false);
@@ -11,9 +11,11 @@
 #include <srp6/Generator.h>
 #include <botan/bigint.h>
 #include <botan/auto_rng.h>
+#include <botan/reducer.h>
 #include <botan/secmem.h>
 #include <boost/serialization/strong_typedef.hpp>
 #include <cstddef>
+#include <cstdint>
  
 namespace ember { namespace srp6 {
 	
@@ -31,6 +33,16 @@ Botan::BigInt decode_flip(Botan::secure_vector<Botan::byte> val);
 Botan::BigInt scrambler(const Botan::BigInt& A, const Botan::BigInt& B, std::size_t padding,
                         Compliance mode);
 Botan::BigInt compute_k(const Botan::BigInt& g, const Botan::BigInt& N);
+
+// reads every table entry regardless of the index to avoid leaking it through the cache,
+// reusing out's storage so repeated selections don't allocate
+void ct_select(const Botan::BigInt* table, std::size_t entries, std::uint32_t index,
+               std::size_t words, Botan::BigInt& out);
+
+// x^e1 * y^e2 mod N, sharing the squarings between both exponentiations
+Botan::BigInt multi_exponentiate(const Botan::BigInt& x, const Botan::BigInt& e1,
+                                 const Botan::BigInt& y, const Botan::BigInt& e2,
+                                 const Botan::Modular_Reducer& reducer);
 Botan::BigInt compute_x(const std::string& identifier, const std::string& password,
                         const Botan::BigInt& salt, Compliance mode);
 
@@ -0,0 +1,57 @@
+/*
+ * Copyright (c) 2016 Ember
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <srp6/FixedBaseExp.h>
+#include <srp6/Util.h>
+#include <stdexcept>
+
+using Botan::BigInt;
+
+namespace ember { namespace srp6 {
+
+FixedBaseExp::FixedBaseExp(const BigInt& g, const BigInt& N)
+                           : g_(g), reducer_(N), words_(N.sig_words()), table_(WINDOWS) {
+	BigInt base = reducer_.reduce(g_);
+
+	// table_[i][j] = g^(j * 2^(WINDOW_BITS * i)) mod N
+	for(auto& row : table_) {
+		row[0] = 1;
+		row[1] = base;
+
+		for(std::size_t j = 2; j < ROW_SIZE; ++j) {
+			row[j] = reducer_.multiply(row[j - 1], base);
+		}
+
+		base = reducer_.multiply(row[ROW_SIZE - 1], base);
+	}
+}
+
+BigInt FixedBaseExp::operator()(const BigInt& x) const {
+	if(x.is_negative()) {
+		throw std::invalid_argument("Fixed-base exponentiation requires a non-negative exponent");
+	}
+
+	// fixed width, so every window is evaluated however short the exponent is - throws if it's too wide
+	const auto exponent = BigInt::encode_1363(x, EXPONENT_BYTES);
+	const std::size_t DIGITS_PER_BYTE = 8 / WINDOW_BITS;
+	const std::uint32_t DIGIT_MASK = ROW_SIZE - 1;
+
+	BigInt result = 1, selected;
+
+	for(std::size_t i = 0; i < WINDOWS; ++i) {
+		const std::uint8_t packed = exponent[EXPONENT_BYTES - 1 - (i / DIGITS_PER_BYTE)];
+		const std::uint32_t digit = (packed >> ((i % DIGITS_PER_BYTE) * WINDOW_BITS)) & DIGIT_MASK;
+		const auto& row = table_[i];
+		detail::ct_select(row.data(), row.size(), digit, words_, selected);
+		result = reducer_.multiply(result, selected);
+	}
+
+	return result;
+}
+
+}} //srp6, ember
\ No newline at end of file
@@ -8,10 +8,36 @@
 
 #include <srp6/Generator.h>
 #include <boost/assert.hpp>
+#include <array>
+#include <mutex>
 #include <utility>
 
 namespace ember { namespace srp6 {
 
+namespace {
+
+/*
+ * The tables are expensive to build, so each group's is built the first time
+ * it's needed and then reused for the lifetime of the process
+ */
+std::shared_ptr<const FixedBaseExp> fixed_base_table(Generator::Group group,
+                                                     const Botan::BigInt& g,
+                                                     const Botan::BigInt& N) {
+	static std::mutex lock;
+	static std::array<std::shared_ptr<const FixedBaseExp>, 8> tables;
+
+	std::lock_guard<std::mutex> guard(lock);
+	auto& table = tables[static_cast<std::size_t>(group)];
+
+	if(!table) {
+		table = std::make_shared<const FixedBaseExp>(g, N);
+	}
+
+	return table;
+}
+
+} // unnamed
+
 Generator::Generator(Group group) {
 	switch(group) {
 		case Group::_256_BIT:
@@ -161,7 +187,12 @@ Generator::Generator(Group group) {
 			break;
 		default:
 			BOOST_ASSERT_MSG(0, "Unhandled enum constant - this is an SRP6 library error!");
+			return;
 	}
+
+	prime_ = true;
+	fixed_ = fixed_base_table(group, g_, N_);
+	reducer_ = std::shared_ptr<const Botan::Modular_Reducer>(fixed_, &fixed_->reducer());
 }
 
 }} //srp6, ember
\ No newline at end of file
@@ -14,23 +14,31 @@
 #include <utility>
 
 using Botan::BigInt;
-using Botan::power_mod;
 using Botan::AutoSeeded_RNG;
 
 namespace ember { namespace srp6 {
 
-Server::Server(const Generator& gen, const BigInt& v, const BigInt& b, bool srp6a)
-              : v_(v), N_(gen.prime()), b_(b) {
+PrecomputedEphemeral precompute_ephemeral(const Generator& gen, std::size_t key_size) {
+	BigInt b = BigInt::decode((AutoSeeded_RNG()).random_vec(key_size)) % gen.prime();
+	BigInt g_b = gen(b);
+	return { std::move(b), std::move(g_b) };
+}
+
+Server::Server(const Generator& gen, const BigInt& v, const PrecomputedEphemeral& ephemeral, bool srp6a)
+              : v_(v), N_(gen.prime()), b_(ephemeral.b), reducer_(gen.reducer()),
+                prime_modulus_(gen.known_prime()) {
 	if(srp6a) {
 		k_ = std::move(detail::compute_k(gen.generator(), N_));
 	}
 
-	B_ = (k_ * v_ + gen(b_)) % N_;
+	B_ = (k_ * v_ + ephemeral.g_b) % N_;
 }
 
+Server::Server(const Generator& gen, const BigInt& v, const BigInt& b, bool srp6a)
+               : Server(gen, v, PrecomputedEphemeral{ b, gen(b) }, srp6a) { }
+
 Server::Server(const Generator& gen, const BigInt& v, std::size_t key_size, bool srp6a)
-               : Server(gen, v, BigInt::decode((AutoSeeded_RNG()).random_vec(key_size)) % gen.prime(),
-                 srp6a) { }
+               : Server(gen, v, precompute_ephemeral(gen, key_size), srp6a) { }
 
 SessionKey Server::session_key(const BigInt& A, Compliance mode, bool interleave_override) {
 	bool interleave = (mode == Compliance::GAME);
@@ -45,7 +53,20 @@ SessionKey Server::session_key(const BigInt& A, Compliance mode, bool interleave
 
 	A_ = A;
 	BigInt u = detail::scrambler(A, B_, N_.bytes(), mode);
-	BigInt S = power_mod(A * power_mod(v_, u, N_), b_, N_);
+
+	/*
+	 * S = (A * v^u)^b = A^b * v^(ub), which allows both exponentiations to be
+	 * done simultaneously. When N is known to be prime, v^(ub) = v^(ub mod (N - 1))
+	 * as long as v isn't a multiple of N, which keeps the combined exponent short.
+	 * That doesn't hold for an arbitrary modulus, so those use the full exponent.
+	 */
+	BigInt vu_exp = u * b_;
+
+	if(prime_modulus_ && v_ % N_ != 0) {
+		vu_exp %= (N_ - 1);
+	}
+
+	BigInt S = detail::multi_exponentiate(A, b_, v_, vu_exp, *reducer_);
 	return interleave? SessionKey(detail::interleaved_hash(detail::encode_flip(S)))
 	                   : SessionKey(Botan::BigInt::encode(S));
 }
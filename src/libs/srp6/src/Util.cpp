@@ -11,8 +11,11 @@
 #include <botan/numthry.h>
 #include <botan/secmem.h>
 #include <algorithm>
+#include <array>
+#include <limits>
 
 using Botan::byte;
+using Botan::word;
 using Botan::secure_vector;
 
 namespace ember { namespace srp6 {
@@ -86,6 +89,79 @@ Botan::BigInt compute_k(const Botan::BigInt& g, const Botan::BigInt& N) {
 	return Botan::BigInt::decode(hasher.final());
 }
 
+namespace {
+
+// all bits set if a == b, otherwise zero - avoids branching on secret values
+word ct_equal_mask(word a, word b) {
+	const word diff = a ^ b;
+	const word zero = ~diff & (diff - 1);
+	return 0 - (zero >> (std::numeric_limits<word>::digits - 1));
+}
+
+} // unnamed
+
+void ct_select(const Botan::BigInt* table, std::size_t entries, std::uint32_t index,
+               std::size_t words, Botan::BigInt& out) {
+	out.grow_to(words);
+	word* out_words = out.mutable_data();
+
+	for(std::size_t k = 0; k < out.size(); ++k) {
+		out_words[k] = 0;
+	}
+
+	for(std::size_t i = 0; i < entries; ++i) {
+		const word mask = ct_equal_mask(i, index);
+
+		for(std::size_t k = 0; k < words; ++k) {
+			out_words[k] |= table[i].word_at(k) & mask;
+		}
+	}
+}
+
+/*
+ * Straus' method with two-bit windows - a table of x^i * y^j for every pair
+ * of digits means each window costs two squarings and a single multiplication
+ * for both exponents combined
+ */
+Botan::BigInt multi_exponentiate(const Botan::BigInt& x, const Botan::BigInt& e1,
+                                 const Botan::BigInt& y, const Botan::BigInt& e2,
+                                 const Botan::Modular_Reducer& reducer) {
+	const std::size_t WINDOW_BITS = 2;
+	const std::size_t DIGITS = 1 << WINDOW_BITS;
+	const std::size_t words = reducer.get_modulus().sig_words();
+
+	std::array<Botan::BigInt, DIGITS * DIGITS> table;
+	const Botan::BigInt x_red = reducer.reduce(x);
+	const Botan::BigInt y_red = reducer.reduce(y);
+
+	// table[i * DIGITS + j] = x^i * y^j
+	for(std::size_t i = 0; i < DIGITS; ++i) {
+		table[i * DIGITS] = i? reducer.multiply(table[(i - 1) * DIGITS], x_red) : 1;
+
+		for(std::size_t j = 1; j < DIGITS; ++j) {
+			table[i * DIGITS + j] = reducer.multiply(table[i * DIGITS + j - 1], y_red);
+		}
+	}
+
+	const std::size_t bits = std::max(e1.bits(), e2.bits());
+	const std::size_t windows = (bits + WINDOW_BITS - 1) / WINDOW_BITS;
+	Botan::BigInt result = 1, selected;
+
+	for(std::size_t w = windows; w > 0; --w) {
+		for(std::size_t i = 0; i < WINDOW_BITS; ++i) {
+			result = reducer.square(result);
+		}
+
+		const std::size_t offset = (w - 1) * WINDOW_BITS;
+		const std::uint32_t index = e1.get_substring(offset, WINDOW_BITS) * DIGITS
+		                            + e2.get_substring(offset, WINDOW_BITS);
+		ct_select(table.data(), table.size(), index, words, selected);
+		result = reducer.multiply(result, selected);
+	}
+
+	return result;
+}
+
 Botan::BigInt compute_x(const std::string& identifier, const std::string& password,
                         const Botan::BigInt& salt, Compliance mode) {
 	//RFC2945 defines x = H(s | H ( I | ":" | p) )
@@ -8,13 +8,16 @@
 
 #include "AccountService.h"
 #include <boost/uuid/uuid.hpp>
+#include <utility>
 
 namespace em = ember::messaging;
 
 namespace ember {
 
-AccountService::AccountService(spark::Service& spark, spark::ServiceDiscovery& s_disc, log::Logger* logger)
-                               : spark_(spark), s_disc_(s_disc), logger_(logger) {
+AccountService::AccountService(spark::Service& spark, spark::ServiceDiscovery& s_disc, log::Logger* logger,
+                               DisconnectCB on_disconnect)
+                               : spark_(spark), s_disc_(s_disc), logger_(logger),
+                                 on_disconnect_(std::move(on_disconnect)) {
 	spark_.dispatcher()->register_handler(this, em::Service::Account, spark::EventDispatcher::Mode::CLIENT);
 	listener_ = std::move(s_disc_.listener(messaging::Service::Account,
 	                      std::bind(&AccountService::service_located, this, std::placeholders::_1)));
@@ -26,8 +29,19 @@ AccountService::~AccountService() {
 }
 
 void AccountService::handle_message(const spark::Link& link, const em::MessageRoot* root) {
-	// we only care about tracked messages at the moment
-	LOG_DEBUG(logger_) << "Session service received unhandled message" << LOG_ASYNC;
+	LOG_TRACE(logger_) << __func__ << LOG_ASYNC;
+
+	// account state changes (bans, suspensions) are the only untracked messages we act on
+	if(root->data_type() != em::Data::Disconnect) {
+		LOG_DEBUG(logger_) << "Session service received unhandled message" << LOG_ASYNC;
+		return;
+	}
+
+	auto message = static_cast<const em::account::Disconnect*>(root->data());
+
+	if(on_disconnect_) {
+		on_disconnect_(message->account_id(), message->reason());
+	}
 }
 
 void AccountService::handle_link_event(const spark::Link& link, spark::LinkState event) {
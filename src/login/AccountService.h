@@ -25,6 +25,7 @@ class AccountService final : public spark::EventHandler {
 public:
 	typedef std::function<void(messaging::account::Status)> RegisterCB;
 	typedef std::function<void(messaging::account::Status, Botan::BigInt)> LocateCB;
+	typedef std::function<void(std::uint32_t, messaging::account::DisconnectReason)> DisconnectCB;
 
 private:
 	spark::Service& spark_;
@@ -33,6 +34,7 @@ private:
 	std::unique_ptr<spark::ServiceListener> listener_;
 	mutable boost::uuids::random_generator generate_uuid; // functor
 	spark::Link link_;
+	const DisconnectCB on_disconnect_;
 	
 	void service_located(const messaging::multicast::LocateAnswer* message);
 	void handle_register_reply(const spark::Link& link, const boost::uuids::uuid& uuid,
@@ -41,7 +43,8 @@ private:
 	                         boost::optional<const messaging::MessageRoot*> root, const LocateCB& cb) const;
 
 public:
-	AccountService(spark::Service& spark, spark::ServiceDiscovery& s_disc, log::Logger* logger);
+	AccountService(spark::Service& spark, spark::ServiceDiscovery& s_disc, log::Logger* logger,
+	               DisconnectCB on_disconnect = nullptr);
 	~AccountService();
 
 	void handle_message(const spark::Link& link, const messaging::MessageRoot* root) override;
@@ -9,49 +9,158 @@
 #pragma once
 
 #include "AccountService.h"
+#include "Authenticator.h"
+#include "CharacterCountCache.h"
+#include "UserCache.h"
 #include "grunt/Packet.h"
+#include "grunt/client/LoginProof.h"
 #include <shared/database/objects/User.h>
 #include <shared/database/daos/UserDAO.h>
 #include <boost/optional.hpp>
+#include <chrono>
 #include <exception>
+#include <functional>
 #include <future>
+#include <memory>
 #include <string>
 #include <utility>
 #include <cstdint>
 
 namespace ember {
 
+/*
+ * Actions are units of work that the login handler can't complete on the
+ * session's strand, either because they'd block (DAO calls) or because they
+ * wait on a reply from another service. Once finished, an action invokes the
+ * completion handler it was given, which resumes the handler on its strand.
+ */
 class Action {
 public:
-	virtual void execute() = 0;
+	typedef std::function<void()> Completion;
+	typedef std::chrono::steady_clock Clock;
+
+	// stamped by the session as the action is queued, picked up and finished
+	struct Timestamps {
+		Clock::time_point submitted;
+		Clock::time_point started;
+		Clock::time_point completed;
+	} timestamps;
+
+	enum class Dispatch {
+		THREAD_POOL, // blocks the calling thread, run on a worker
+		CRYPTO,      // CPU-bound SRP6 work, run on the bounded crypto pool
+		ASYNC        // completes via callback, never ties up a thread
+	};
+
+	virtual Dispatch dispatch() const = 0;
+	virtual void execute(Completion complete) = 0;
 	virtual ~Action() = default;
 };
 
+class BlockingAction : public Action {
+	virtual void run() = 0;
+
+public:
+	Dispatch dispatch() const override final {
+		return Dispatch::THREAD_POOL;
+	}
+
+	void execute(Completion complete) override final {
+		run();
+		complete();
+	}
+};
+
+/*
+ * The crypto pool is bounded, so these may be shed without ever being run
+ * if the server is saturated - check ran() before fetching the result
+ */
+class CryptoAction : public Action {
+	bool ran_ = false;
+
+	virtual void run() = 0;
+
+public:
+	Dispatch dispatch() const override final {
+		return Dispatch::CRYPTO;
+	}
+
+	void execute(Completion complete) override final {
+		run();
+		ran_ = true;
+		complete();
+	}
+
+	bool ran() const {
+		return ran_;
+	}
+};
+
+class LoginChallengeAction final : public CryptoAction {
+	const UserCache::Record user_;
+	std::unique_ptr<LoginAuthenticator> authenticator_;
+	std::exception_ptr exception_;
+
+public:
+	explicit LoginChallengeAction(UserCache::Record user) : user_(std::move(user)) { }
+
+	void run() override try {
+		authenticator_ = std::make_unique<LoginAuthenticator>(user_);
+	} catch(const std::exception&) {
+		exception_ = std::current_exception();
+	}
+
+	std::unique_ptr<LoginAuthenticator> get_result() {
+		if(exception_) {
+			std::rethrow_exception(exception_);
+		}
+
+		return std::move(authenticator_);
+	}
+};
+
+class LoginProofAction final : public CryptoAction {
+	LoginAuthenticator& authenticator_;
+	const grunt::client::LoginProof proof_;
+	LoginAuthenticator::ProofResult result_;
+
+public:
+	LoginProofAction(LoginAuthenticator& authenticator, grunt::client::LoginProof proof)
+	                 : authenticator_(authenticator), proof_(std::move(proof)), result_{} { }
+
+	void run() override {
+		result_ = authenticator_.proof_check(&proof_);
+	}
+
+	LoginAuthenticator::ProofResult get_result() {
+		return result_;
+	}
+};
+
 class RegisterSessionAction final : public Action {
 	const AccountService& account_svc_;
 	std::uint32_t account_id_;
 	srp6::SessionKey key_;
 
-	std::promise<messaging::account::Status> promise_;
 	messaging::account::Status res_;
 	std::exception_ptr exception_;
 
-	std::future<messaging::account::Status> do_register() {
-		account_svc_.register_session(account_id_, key_, [&](messaging::account::Status res) {
-			promise_.set_value(res);
-		});
-
-		return promise_.get_future();
-	}
-
 public:
 	RegisterSessionAction(const AccountService& account_svc, std::uint32_t account_id, srp6::SessionKey key)
 	                      : account_svc_(account_svc), account_id_(account_id), key_(key) { }
 
-	virtual void execute() override try {
-		res_ = do_register().get();
+	Dispatch dispatch() const override {
+		return Dispatch::ASYNC;
+	}
+
+	void execute(Completion complete) override try {
+		account_svc_.register_session(account_id_, key_, [this, complete](messaging::account::Status res) {
+			res_ = res;
+			complete();
+		});
 	} catch(const std::exception&) {
 		exception_ = std::current_exception();
+		complete();
 	}
 
 	messaging::account::Status get_result() {
@@ -66,29 +175,26 @@ public:
 class FetchSessionKeyAction final : public Action {
 	const AccountService& account_svc_;
 	std::uint32_t account_id_;
-	Botan::BigInt key_;
 	std::exception_ptr exception_;
-
-	std::promise<std::pair<messaging::account::Status, Botan::BigInt>> promise_;
 	std::pair<messaging::account::Status, Botan::BigInt> res_;
 
-	auto do_fetch() {
-		account_svc_.locate_session(account_id_, [&](messaging::account::Status res,
-		                            Botan::BigInt key) {
-			promise_.set_value({res, key});
-		});
-
-		return promise_.get_future();
-	}
-
 public:
 	FetchSessionKeyAction(const AccountService& account_svc, std::uint32_t account_id)
 	                      : account_svc_(account_svc), account_id_(account_id) {}
 
-	virtual void execute() override try {
-		res_ = do_fetch().get();
+	Dispatch dispatch() const override {
+		return Dispatch::ASYNC;
+	}
+
+	void execute(Completion complete) override try {
+		account_svc_.locate_session(account_id_, [this, complete](messaging::account::Status res,
+		                            Botan::BigInt key) {
+			res_ = { res, key };
+			complete();
+		});
 	} catch(const std::exception&) {
 		exception_ = std::current_exception();
+		complete();
 	}
 
 	auto get_result() {
@@ -103,20 +209,51 @@ public:
 class FetchUserAction final : public Action {
 	const std::string username_;
 	const dal::UserDAO& user_src_;
-	boost::optional<User> user_;
+	UserCache* cache_;
+	UserCache::Record user_;
 	std::exception_ptr exception_;
 
+	// runs on the database thread, so the SRP6 values are decoded there rather than on the network thread
+	void store(std::future<boost::optional<User>> result) try {
+		if(auto user = result.get()) {
+			user_ = std::make_shared<const CachedUser>(std::move(*user));
+		}
+
+		if(cache_) {
+			cache_->store(username_, user_);
+		}
+	} catch(const std::exception&) {
+		exception_ = std::current_exception();
+	}
+
 public:
-	FetchUserAction(std::string username, const dal::UserDAO& user_src)
-	                : username_(std::move(username)), user_src_(user_src) {}
+	FetchUserAction(std::string username, const dal::UserDAO& user_src, UserCache* cache)
+	                : username_(std::move(username)), user_src_(user_src), cache_(cache) {}
 
-	virtual void execute() override try {
-		user_ = user_src_.user(username_);
-	} catch(const dal::exception&) {
+	Dispatch dispatch() const override {
+		return Dispatch::ASYNC;
+	}
+
+	void execute(Completion complete) override try {
+		if(cache_ && cache_->find(username_, user_)) {
+			complete();
+			return;
+		}
+
+		const bool queued = user_src_.user_async(username_, [this, complete](auto result) {
+			store(std::move(result));
+			complete();
+		});
+
+		if(!queued) {
+			throw dal::exception("Database queue full, refusing user lookup");
+		}
+	} catch(const std::exception&) {
 		exception_ = std::current_exception();
+		complete();
 	}
 
-	boost::optional<User> get_result() {
+	UserCache::Record get_result() {
 		if(exception_) {
 			std::rethrow_exception(exception_);
 		}
@@ -129,24 +266,30 @@ public:
 	}
 };
 
-class FetchCharacterCounts final : public Action {
+class FetchCharacterCounts final : public BlockingAction {
 	const std::uint32_t user_id_;
 	const dal::UserDAO& user_src_;
-	std::unordered_map<std::uint32_t, std::uint32_t> counts_;
+	CharacterCountCache* cache_;
+	CharacterCountCache::Counts counts_;
 	bool reconnect_;
 	std::exception_ptr exception_;
 
 public:
-	FetchCharacterCounts(std::uint32_t user_id, const dal::UserDAO& user_src, bool reconnect = false)
-	                     : user_id_(user_id), user_src_(user_src), reconnect_(reconnect) {}
+	FetchCharacterCounts(std::uint32_t user_id, const dal::UserDAO& user_src, CharacterCountCache* cache,
+	                     bool reconnect = false)
+	                     : user_id_(user_id), user_src_(user_src), cache_(cache), reconnect_(reconnect) {}
 
-	virtual void execute() override try {
+	void run() override try {
 		counts_ = user_src_.character_counts(user_id_);
+
+		if(cache_) {
+			cache_->store(user_id_, counts_);
+		}
 	} catch(const dal::exception&) {
 		exception_ = std::current_exception();
 	}
 
-	std::unordered_map<std::uint32_t, std::uint32_t> get_result() {
+	CharacterCountCache::Counts get_result() {
 		if(exception_) {
 			std::rethrow_exception(exception_);
 		}
@@ -159,33 +302,4 @@ public:
 	}
 };
 
-class SaveSurveyAction final : public Action {
-	const dal::UserDAO& user_src_;
-	std::uint32_t user_id_;
-	std::uint32_t survey_id_;
-	std::string data_;
-	dal::exception exception_;
-	bool error_;
-
-public:
-	SaveSurveyAction(std::uint32_t user_id, const dal::UserDAO& user_src, std::uint32_t survey_id,
-	                 std::string data) : user_src_(user_src), user_id_(user_id), survey_id_(survey_id),
-	                                     data_(std::move(data)), error_(false) { }
-
-	virtual void execute() override try {
-		user_src_.save_survey(user_id_, survey_id_, data_);
-	} catch(const dal::exception& e) {
-		exception_ = e;
-		error_ = true;
-	}
-
-	bool error() {
-		return error_;
-	}
-
-	dal::exception exception() {
-		return exception_;
-	}
-};
-
 } // ember
\ No newline at end of file
@@ -20,24 +20,29 @@
 
 namespace ember {
 
-LoginAuthenticator::LoginAuthenticator(User user) : user_(std::move(user)) {
-	srp_ = std::make_unique<srp6::Server>(gen_, user_.verifier());
+LoginAuthenticator::LoginAuthenticator(UserCache::Record user) : user_(std::move(user)) {
+	srp_ = std::make_unique<srp6::Server>(gen_, user_->verifier);
+}
+
+LoginAuthenticator::LoginAuthenticator(UserCache::Record user, const srp6::PrecomputedEphemeral& ephemeral)
+                                       : user_(std::move(user)) {
+	srp_ = std::make_unique<srp6::Server>(gen_, user_->verifier, ephemeral);
 }
 
 auto LoginAuthenticator::challenge_reply() -> ChallengeResponse {
-	return {srp_->public_ephemeral(), Botan::BigInt(user_.salt()), gen_};
+	return {srp_->public_ephemeral(), user_->salt, gen_};
 }
 
 auto LoginAuthenticator::proof_check(const grunt::client::LoginProof* proof) -> ProofResult  try {
 	// Usernames aren't required to be uppercase in the DB but the client requires it for calculations
-	std::string user_upper(user_.username());
+	std::string user_upper(user_->user.username());
 	std::transform(user_upper.begin(), user_upper.end(), user_upper.begin(), ::toupper);
 
 	srp6::SessionKey key(srp_->session_key(proof->A));
 
 	Botan::BigInt B = srp_->public_ephemeral();
 	Botan::BigInt M1_S = srp6::generate_client_proof(user_upper, key, gen_.prime(), gen_.generator(),
-	                                                 proof->A, B, Botan::BigInt(user_.salt()));
+	                                                 proof->A, B, user_->salt);
 	sess_key_ = key;
 	return { proof->M1 == M1_S, srp_->generate_proof(key, proof->M1) };
 } catch(srp6::exception& e) {
@@ -8,6 +8,7 @@
 
 #pragma once
 
+#include "UserCache.h"
 #include "grunt/Packets.h"
 #include <srp6/Server.h>
 #include <shared/database/objects/User.h>
@@ -29,6 +30,7 @@ public:
 };
 
 class LoginAuthenticator {
+public:
 	struct ChallengeResponse {
 		Botan::BigInt B;
 		Botan::BigInt salt;
@@ -40,13 +42,18 @@ class LoginAuthenticator {
 		Botan::BigInt server_proof;
 	};
 
+	// the client only supports a 256-bit prime
+	static const srp6::Generator::Group GROUP = srp6::Generator::Group::_256_BIT;
+
+private:
 	std::unique_ptr<srp6::Server> srp_;
-	srp6::Generator gen_ { srp6::Generator::Group::_256_BIT };
+	srp6::Generator gen_ { GROUP };
 	srp6::SessionKey sess_key_;
-	User user_;
+	UserCache::Record user_;
 
 public:
-	explicit LoginAuthenticator(User user);
+	explicit LoginAuthenticator(UserCache::Record user);
+	LoginAuthenticator(UserCache::Record user, const srp6::PrecomputedEphemeral& ephemeral);
 	ChallengeResponse challenge_reply();
 	ProofResult proof_check(const grunt::client::LoginProof* proof);
 	srp6::SessionKey session_key();
@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) 2016 Ember
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "BatchWriter.h"
+#include <algorithm>
+#include <utility>
+
+namespace ember {
+
+BatchWriter::BatchWriter(const dal::UserDAO& user_dao, log::Logger* logger, std::size_t capacity,
+                         std::size_t batch_size, std::chrono::milliseconds interval)
+                         : user_dao_(user_dao), logger_(logger), capacity_(capacity),
+                           batch_size_(std::max<std::size_t>(batch_size, 1)), interval_(interval),
+                           written_(0), dropped_(0), failed_(0), stop_(false) {
+	worker_ = std::thread(&BatchWriter::run, this);
+}
+
+BatchWriter::~BatchWriter() {
+	{
+		std::lock_guard<std::mutex> guard(lock_);
+		stop_ = true;
+	}
+
+	flush_cond_.notify_one();
+	worker_.join();
+}
+
+std::size_t BatchWriter::pending() const {
+	return logins_.size() + surveys_.size();
+}
+
+// must be called with the lock held
+bool BatchWriter::reserve() {
+	if(pending() >= capacity_) {
+		++dropped_;
+		return false;
+	}
+
+	return true;
+}
+
+bool BatchWriter::record_login(std::uint32_t account_id, std::string ip) {
+	std::lock_guard<std::mutex> guard(lock_);
+
+	if(!reserve()) {
+		return false;
+	}
+
+	logins_.push_back({ account_id, std::move(ip) });
+
+	if(pending() >= batch_size_) {
+		flush_cond_.notify_one();
+	}
+
+	return true;
+}
+
+bool BatchWriter::save_survey(std::uint32_t account_id, std::uint32_t survey_id, std::string data) {
+	std::lock_guard<std::mutex> guard(lock_);
+
+	if(!reserve()) {
+		return false;
+	}
+
+	surveys_.push_back({ account_id, survey_id, std::move(data) });
+
+	if(pending() >= batch_size_) {
+		flush_cond_.notify_one();
+	}
+
+	return true;
+}
+
+void BatchWriter::run() {
+	std::vector<LoginRecord> logins;
+	std::vector<SurveyResult> surveys;
+	std::unique_lock<std::mutex> guard(lock_);
+
+	while(true) {
+		flush_cond_.wait_for(guard, interval_, [&] { return stop_ || pending() >= batch_size_; });
+
+		// on shutdown, drain whatever's left before exiting
+		const bool stop = stop_;
+		logins.swap(logins_);
+		surveys.swap(surveys_);
+		guard.unlock();
+
+		write(logins, surveys);
+		logins.clear();
+		surveys.clear();
+
+		guard.lock();
+
+		if(stop && !pending()) {
+			break;
+		}
+	}
+}
+
+void BatchWriter::write(const std::vector<LoginRecord>& logins, const std::vector<SurveyResult>& surveys) {
+	if(!logins.empty()) {
+		try {
+			user_dao_.record_logins(logins);
+			written_ += logins.size();
+		} catch(const dal::exception& e) {
+			failed_ += logins.size();
+			LOG_ERROR(logger_) << "Unable to write " << logins.size() << " login records: "
+			                   << e.what() << LOG_ASYNC;
+		}
+	}
+
+	if(!surveys.empty()) {
+		try {
+			user_dao_.save_surveys(surveys);
+			written_ += surveys.size();
+		} catch(const dal::exception& e) {
+			failed_ += surveys.size();
+			LOG_ERROR(logger_) << "Unable to write " << surveys.size() << " survey results: "
+			                   << e.what() << LOG_ASYNC;
+		}
+	}
+}
+
+std::size_t BatchWriter::size() {
+	std::lock_guard<std::mutex> guard(lock_);
+	return pending();
+}
+
+auto BatchWriter::reset_counters() -> Counters {
+	return { written_.exchange(0), dropped_.exchange(0), failed_.exchange(0) };
+}
+
+} // ember
\ No newline at end of file
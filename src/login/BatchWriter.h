@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2016 Ember
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include <logger/Logging.h>
+#include <shared/database/daos/UserDAO.h>
+#include <shared/database/objects/LoginRecord.h>
+#include <shared/database/objects/SurveyResult.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace ember {
+
+/*
+ * Write-behind queue for records that the login flow doesn't need to wait on
+ * (login history, survey results). Records are buffered in memory and written
+ * by a background thread as multi-row statements, either once batch_size
+ * records are waiting or every interval, whichever comes first. A batch_size
+ * of zero is treated as one.
+ *
+ * Each flush is split by the DAO into statements of at most MAX_BATCH_ROWS rows
+ * and these aren't wrapped in a transaction, so if a later statement fails, the
+ * rows from earlier ones will already have been written (but are still counted
+ * as failed).
+ *
+ * The queue is bounded - once it's full, new records are dropped and counted
+ * rather than allowed to back up into the login flow. Anything still queued
+ * is written when the writer is destroyed.
+ */
+class BatchWriter final {
+public:
+	struct Counters {
+		std::uint64_t written;
+		std::uint64_t dropped;
+		std::uint64_t failed;
+	};
+
+private:
+	const dal::UserDAO& user_dao_;
+	log::Logger* logger_;
+	const std::size_t capacity_;
+	const std::size_t batch_size_;
+	const std::chrono::milliseconds interval_;
+
+	std::vector<LoginRecord> logins_;
+	std::vector<SurveyResult> surveys_;
+	std::mutex lock_;
+	std::condition_variable flush_cond_;
+	std::atomic<std::uint64_t> written_;
+	std::atomic<std::uint64_t> dropped_;
+	std::atomic<std::uint64_t> failed_;
+	bool stop_;
+	std::thread worker_;
+
+	std::size_t pending() const;
+	bool reserve();
+	void run();
+	void write(const std::vector<LoginRecord>& logins, const std::vector<SurveyResult>& surveys);
+
+public:
+	BatchWriter(const dal::UserDAO& user_dao, log::Logger* logger, std::size_t capacity,
+	            std::size_t batch_size, std::chrono::milliseconds interval);
+	~BatchWriter();
+
+	bool record_login(std::uint32_t account_id, std::string ip);
+	bool save_survey(std::uint32_t account_id, std::uint32_t survey_id, std::string data);
+
+	std::size_t size();
+	Counters reset_counters();
+};
+
+} // ember
\ No newline at end of file
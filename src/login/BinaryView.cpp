@@ -0,0 +1,54 @@
+/*
+ * Copyright (c) 2016 Ember
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "BinaryView.h"
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/filesystem.hpp>
+#include <stdexcept>
+#include <utility>
+
+namespace bi = boost::interprocess;
+namespace bfs = boost::filesystem;
+
+namespace ember {
+
+void BinaryView::map(const std::string& path, Advice advice) {
+	boost::system::error_code ec;
+	const auto size = bfs::file_size(path, ec);
+
+	if(ec) {
+		throw std::runtime_error("Unable to open " + path);
+	}
+
+	// empty files can't be mapped but they don't contribute to the view anyway
+	if(!size) {
+		return;
+	}
+
+	try {
+		bi::file_mapping file(path.c_str(), bi::read_only);
+		bi::mapped_region region(file, bi::read_only);
+
+		// purely a hint, failure to apply it isn't an error
+		if(advice == Advice::WILL_NEED) {
+			region.advise(bi::mapped_region::advice_willneed);
+		}
+
+		regions_.emplace_back(std::move(region));
+		append(regions_.back().get_address(), regions_.back().get_size());
+	} catch(const bi::interprocess_exception& e) {
+		throw std::runtime_error("Unable to map " + path + ": " + e.what());
+	}
+}
+
+void BinaryView::append(const void* data, std::size_t size) {
+	segments_.push_back({ static_cast<const std::uint8_t*>(data), size });
+	size_ += size;
+}
+
+} // ember
\ No newline at end of file
@@ -0,0 +1,51 @@
+/*
+ * Copyright (c) 2016 Ember
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include <boost/interprocess/mapped_region.hpp>
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace ember {
+
+/*
+ * Presents a sequence of read-only files as a single logical buffer without
+ * copying them onto the heap. Each file is memory-mapped and consumers walk
+ * the segments in order, so the kernel can drop clean pages under memory
+ * pressure and fault them back in from disk when they're next hashed.
+ *
+ * Buffers passed to append() are not owned by the view and must outlive it.
+ */
+class BinaryView {
+public:
+	struct Segment {
+		const std::uint8_t* data;
+		std::size_t size;
+	};
+
+	enum class Advice {
+		NONE, WILL_NEED
+	};
+
+private:
+	std::vector<boost::interprocess::mapped_region> regions_;
+	std::vector<Segment> segments_;
+	std::size_t size_ = 0;
+
+public:
+	void map(const std::string& path, Advice advice = Advice::NONE);
+	void append(const void* data, std::size_t size);
+
+	const std::vector<Segment>& segments() const { return segments_; }
+	std::size_t size() const { return size_; }
+};
+
+} // ember
\ No newline at end of file
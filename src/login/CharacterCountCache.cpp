@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2016 Ember
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "CharacterCountCache.h"
+#include <iterator>
+
+namespace ember {
+
+CharacterCountCache::CharacterCountCache(std::size_t capacity, std::chrono::seconds ttl)
+                                         : capacity_(capacity), ttl_(ttl), hits_(0), misses_(0) { }
+
+auto CharacterCountCache::find(std::uint32_t account_id) -> boost::optional<Counts> {
+	std::lock_guard<std::mutex> guard(lock_);
+
+	auto it = entries_.find(account_id);
+
+	if(it == entries_.end()) {
+		++misses_;
+		return boost::none;
+	}
+
+	if(it->second->expiry <= Clock::now()) {
+		erase(it->second);
+		++misses_;
+		return boost::none;
+	}
+
+	lru_.splice(lru_.begin(), lru_, it->second);
+	++hits_;
+	return it->second->counts;
+}
+
+void CharacterCountCache::store(std::uint32_t account_id, Counts counts) {
+	std::lock_guard<std::mutex> guard(lock_);
+
+	auto it = entries_.find(account_id);
+
+	if(it != entries_.end()) {
+		erase(it->second);
+	}
+
+	if(!capacity_) {
+		return;
+	}
+
+	if(lru_.size() >= capacity_) {
+		erase(std::prev(lru_.end()));
+	}
+
+	lru_.push_front({ account_id, std::move(counts), Clock::now() + ttl_ });
+	entries_[account_id] = lru_.begin();
+}
+
+void CharacterCountCache::apply(std::uint32_t account_id, std::uint32_t realm_id, std::int32_t delta) {
+	std::lock_guard<std::mutex> guard(lock_);
+
+	auto it = entries_.find(account_id);
+
+	if(it == entries_.end()) {
+		return;
+	}
+
+	auto& count = it->second->counts[realm_id];
+
+	// shouldn't happen but don't let a duplicate notification wrap the count
+	if(delta < 0 && count < static_cast<std::uint32_t>(-delta)) {
+		count = 0;
+	} else {
+		count += delta;
+	}
+}
+
+void CharacterCountCache::clear() {
+	std::lock_guard<std::mutex> guard(lock_);
+	entries_.clear();
+	lru_.clear();
+}
+
+void CharacterCountCache::erase(LRUList::iterator it) {
+	entries_.erase(it->account_id);
+	lru_.erase(it);
+}
+
+std::size_t CharacterCountCache::size() {
+	std::lock_guard<std::mutex> guard(lock_);
+	return lru_.size();
+}
+
+auto CharacterCountCache::reset_counters() -> Counters {
+	return { hits_.exchange(0), misses_.exchange(0) };
+}
+
+} // ember
\ No newline at end of file
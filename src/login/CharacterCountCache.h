@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2016 Ember
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include <boost/optional.hpp>
+#include <atomic>
+#include <chrono>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <cstddef>
+#include <cstdint>
+
+namespace ember {
+
+/*
+ * Bounded LRU of per-realm character counts, keyed by account ID.
+ *
+ * Entries are loaded from the database on the first realm list request for
+ * an account and are then kept current by the character service's create and
+ * delete notifications, so later requests don't need a query. Deltas for
+ * accounts that aren't cached are dropped - the next load picks them up.
+ *
+ * The TTL bounds the damage if a notification is lost or races a load.
+ */
+class CharacterCountCache final {
+public:
+	typedef std::unordered_map<std::uint32_t, std::uint32_t> Counts; // realm ID -> count
+	typedef std::chrono::steady_clock Clock;
+
+	struct Counters {
+		std::uint64_t hits;
+		std::uint64_t misses;
+	};
+
+private:
+	struct Entry {
+		std::uint32_t account_id;
+		Counts counts;
+		Clock::time_point expiry;
+	};
+
+	typedef std::list<Entry> LRUList;
+
+	const std::size_t capacity_;
+	const std::chrono::seconds ttl_;
+
+	LRUList lru_;
+	std::unordered_map<std::uint32_t, LRUList::iterator> entries_;
+	std::atomic<std::uint64_t> hits_;
+	std::atomic<std::uint64_t> misses_;
+	std::mutex lock_;
+
+	void erase(LRUList::iterator it);
+
+public:
+	CharacterCountCache(std::size_t capacity, std::chrono::seconds ttl);
+
+	boost::optional<Counts> find(std::uint32_t account_id);
+	void store(std::uint32_t account_id, Counts counts);
+	void apply(std::uint32_t account_id, std::uint32_t realm_id, std::int32_t delta);
+	void clear();
+
+	std::size_t size();
+	Counters reset_counters();
+};
+
+} // ember
\ No newline at end of file
@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) 2016 Ember
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "CharacterService.h"
+#include "CharacterCountCache.h"
+
+namespace em = ember::messaging;
+
+namespace ember {
+
+CharacterService::CharacterService(CharacterCountCache& counts, spark::Service& spark,
+                                   spark::ServiceDiscovery& s_disc, log::Logger* logger)
+                                   : counts_(counts), spark_(spark), s_disc_(s_disc), logger_(logger) {
+	spark_.dispatcher()->register_handler(this, em::Service::Character, spark::EventDispatcher::Mode::CLIENT);
+	listener_ = std::move(s_disc_.listener(em::Service::Character,
+	                      std::bind(&CharacterService::service_located, this, std::placeholders::_1)));
+	listener_->search();
+}
+
+CharacterService::~CharacterService() {
+	spark_.dispatcher()->remove_handler(this);
+}
+
+void CharacterService::handle_message(const spark::Link& link, const em::MessageRoot* root) {
+	switch(root->data_type()) {
+		case em::Data::CountUpdate:
+			handle_count_update(link, root);
+			break;
+		default:
+			LOG_DEBUG(logger_) << "Unhandled character message from " << link.description << LOG_ASYNC;
+	}
+}
+
+void CharacterService::handle_count_update(const spark::Link& link, const em::MessageRoot* root) {
+	LOG_TRACE(logger_) << __func__ << LOG_ASYNC;
+
+	auto msg = static_cast<const em::character::CountUpdate*>(root->data());
+	counts_.apply(msg->account_id(), msg->realm_id(), msg->delta());
+}
+
+void CharacterService::handle_link_event(const spark::Link& link, spark::LinkState event) {
+	LOG_TRACE(logger_) << __func__ << LOG_ASYNC;
+
+	// we can't tell which updates were missed while the link was down, so start over
+	switch(event) {
+		case spark::LinkState::LINK_UP:
+			LOG_INFO(logger_) << "Link to character server established" << LOG_ASYNC;
+			counts_.clear();
+			break;
+		case spark::LinkState::LINK_DOWN:
+			LOG_INFO(logger_) << "Link to character server closed" << LOG_ASYNC;
+			counts_.clear();
+			break;
+	}
+}
+
+void CharacterService::service_located(const em::multicast::LocateAnswer* message) {
+	LOG_DEBUG(logger_) << "Located character service at " << message->ip()->str()
+	                   << ":" << message->port() << LOG_ASYNC;
+	spark_.connect(message->ip()->str(), message->port());
+}
+
+} // ember
\ No newline at end of file
@@ -0,0 +1,44 @@
+/*
+ * Copyright (c) 2016 Ember
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include <spark/Service.h>
+#include <spark/ServiceDiscovery.h>
+#include <spark/temp/MessageRoot_generated.h>
+#include <logger/Logging.h>
+#include <memory>
+
+namespace ember {
+
+class CharacterCountCache;
+
+/*
+ * Listens for character creations and deletions so the cached per-realm
+ * character counts can be kept up to date without querying the database
+ */
+class CharacterService final : public spark::EventHandler {
+	CharacterCountCache& counts_;
+	spark::Service& spark_;
+	spark::ServiceDiscovery& s_disc_;
+	log::Logger* logger_;
+	std::unique_ptr<spark::ServiceListener> listener_;
+
+	void service_located(const messaging::multicast::LocateAnswer* message);
+	void handle_count_update(const spark::Link& link, const messaging::MessageRoot* root);
+
+public:
+	CharacterService(CharacterCountCache& counts, spark::Service& spark, spark::ServiceDiscovery& s_disc,
+	                 log::Logger* logger);
+	~CharacterService();
+
+	void handle_message(const spark::Link& link, const messaging::MessageRoot* root) override;
+	void handle_link_event(const spark::Link& link, spark::LinkState event) override;
+};
+
+} // ember
\ No newline at end of file
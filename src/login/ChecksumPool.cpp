@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2016 Ember
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "ChecksumPool.h"
+#include "ExecutablesChecksum.h"
+#include "IntegrityData.h"
+#include <shared/util/FNVHash.h>
+#include <botan/auto_rng.h>
+#include <utility>
+
+namespace ember {
+
+ChecksumPool::ChecksumPool(const IntegrityData& data, const std::vector<GameVersion>& versions,
+                           std::size_t pool_size) {
+	const std::pair<grunt::Platform, grunt::System> targets[] = {
+		{ grunt::Platform::x86, grunt::System::Win },
+		{ grunt::Platform::x86, grunt::System::OSX },
+		{ grunt::Platform::PPC, grunt::System::OSX }
+	};
+
+	for(auto& version : versions) {
+		for(auto& target : targets) {
+			auto binaries = data.lookup(version, target.first, target.second);
+
+			if(!binaries) {
+				continue;
+			}
+
+			// only ever used by the pool's own refill thread
+			auto rng = std::make_shared<Botan::AutoSeeded_RNG>();
+			auto view = *binaries;
+
+			auto pool = std::make_unique<Pool>(pool_size, [rng, view]() -> PrecomputedChecksum {
+				auto salt = rng->random_vec(SALT_LENGTH);
+				auto checksum = client_integrity::checksum(salt, *view);
+				return { std::move(salt), std::move(checksum) };
+			});
+
+			pools_.emplace(hash(version.build, target.first, target.second), std::move(pool));
+		}
+	}
+}
+
+boost::optional<PrecomputedChecksum> ChecksumPool::take(const GameVersion& version,
+                                                        grunt::Platform platform,
+                                                        grunt::System os) {
+	auto it = pools_.find(hash(version.build, platform, os));
+
+	if(it == pools_.end()) {
+		return boost::none;
+	}
+
+	return it->second->take();
+}
+
+std::size_t ChecksumPool::size() {
+	std::size_t total = 0;
+
+	for(auto& pool : pools_) {
+		total += pool.second->size();
+	}
+
+	return total;
+}
+
+auto ChecksumPool::reset_counters() -> Pool::Counters {
+	Pool::Counters total {};
+
+	for(auto& pool : pools_) {
+		const auto counters = pool.second->reset_counters();
+		total.generated += counters.generated;
+		total.exhausted += counters.exhausted;
+	}
+
+	return total;
+}
+
+std::size_t ChecksumPool::hash(std::uint16_t build, grunt::Platform platform,
+                               grunt::System os) const {
+	FNVHash hasher;
+	hasher.update(build);
+	hasher.update(platform);
+	return hasher.update(os);
+}
+
+} // ember
\ No newline at end of file
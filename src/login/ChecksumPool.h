@@ -0,0 +1,57 @@
+/*
+ * Copyright (c) 2016 Ember
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include "GameVersion.h"
+#include "grunt/Magic.h"
+#include <shared/threading/PrecomputedPool.h>
+#include <botan/secmem.h>
+#include <boost/optional.hpp>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace ember {
+
+class IntegrityData;
+
+struct PrecomputedChecksum {
+	Botan::secure_vector<Botan::byte> salt;
+	Botan::secure_vector<Botan::byte> checksum;
+};
+
+/*
+ * The server picks the salt for the client integrity check, so the expected
+ * checksum of the client's binaries can be calculated before the client ever
+ * connects. This keeps a separate pool of salt/checksum pairs for each
+ * build, platform and OS combination that we have binaries for.
+ */
+class ChecksumPool {
+	typedef PrecomputedPool<PrecomputedChecksum> Pool;
+
+	std::unordered_map<std::size_t, std::unique_ptr<Pool>> pools_;
+
+	std::size_t hash(std::uint16_t build, grunt::Platform platform, grunt::System os) const;
+
+public:
+	static const std::size_t SALT_LENGTH = 16;
+
+	ChecksumPool(const IntegrityData& data, const std::vector<GameVersion>& versions,
+	             std::size_t pool_size);
+
+	boost::optional<PrecomputedChecksum> take(const GameVersion& version, grunt::Platform platform,
+	                                          grunt::System os);
+
+	std::size_t size();
+	Pool::Counters reset_counters();
+};
+
+} // ember
\ No newline at end of file
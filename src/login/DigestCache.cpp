@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) 2016 Ember
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "DigestCache.h"
+#include <shared/util/FileMD5.h>
+#include <boost/filesystem.hpp>
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+
+namespace bfs = boost::filesystem;
+
+namespace ember {
+
+DigestCache::DigestCache(std::string path)
+                         : path_(std::move(path)), hashed_(0), dirty_(false) {
+	load();
+}
+
+// format is one file per line - md5, size, mtime, path
+void DigestCache::load() {
+	std::ifstream file(path_);
+
+	if(!file.is_open()) {
+		return;
+	}
+
+	std::string line;
+
+	while(std::getline(file, line)) {
+		std::istringstream stream(line);
+		std::string md5, name;
+		Entry entry;
+
+		if(!(stream >> md5 >> entry.size >> entry.mtime) || md5.size() != entry.md5.size() * 2
+		   || !std::all_of(md5.begin(), md5.end(), [](unsigned char c) { return std::isxdigit(c); })) {
+			continue; // damaged entry, the file will just be hashed again
+		}
+
+		stream >> std::ws;
+		std::getline(stream, name);
+
+		for(std::size_t i = 0; i < entry.md5.size(); ++i) {
+			entry.md5[i] = static_cast<char>(std::stoul(md5.substr(i * 2, 2), nullptr, 16));
+		}
+
+		entries_[name] = entry;
+	}
+}
+
+auto DigestCache::digest(const std::string& file) -> Digest {
+	const auto size = bfs::file_size(file);
+	const auto mtime = bfs::last_write_time(file);
+
+	{
+		std::lock_guard<std::mutex> guard(lock_);
+		auto it = entries_.find(file);
+
+		if(it != entries_.end() && it->second.size == size && it->second.mtime == mtime) {
+			return it->second.md5;
+		}
+	}
+
+	// hash outside of the lock so other files can be processed in parallel
+	const auto md5 = util::generate_md5(file);
+	Entry entry { size, mtime };
+	std::copy(md5.begin(), md5.end(), entry.md5.data());
+	++hashed_;
+
+	std::lock_guard<std::mutex> guard(lock_);
+	entries_[file] = entry;
+	dirty_ = true;
+	return entry.md5;
+}
+
+// written to a temporary file first so a crash can't leave a truncated cache behind
+void DigestCache::save() {
+	std::lock_guard<std::mutex> guard(lock_);
+
+	if(!dirty_) {
+		return;
+	}
+
+	const auto temp = path_ + ".tmp";
+
+	{
+		std::ofstream file(temp, std::ios::trunc);
+
+		if(!file.is_open()) {
+			throw std::runtime_error("Unable to write digest cache, " + temp);
+		}
+
+		file << std::hex << std::setfill('0');
+
+		for(auto& entry : entries_) {
+			for(auto c : entry.second.md5) {
+				file << std::setw(2) << static_cast<unsigned int>(static_cast<unsigned char>(c));
+			}
+
+			file << std::dec << " " << entry.second.size << " " << entry.second.mtime
+			     << " " << entry.first << std::hex << "\n";
+		}
+
+		if(!file.good()) {
+			throw std::runtime_error("Unable to write digest cache, " + temp);
+		}
+	}
+
+	bfs::rename(temp, path_);
+	dirty_ = false;
+}
+
+} // ember
\ No newline at end of file
@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) 2016 Ember
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <ctime>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <cstddef>
+#include <cstdint>
+
+namespace ember {
+
+/*
+ * Persists file MD5s in a sidecar file so that unchanged files don't have to
+ * be hashed again on the next startup. Entries are keyed by path and are only
+ * trusted while the file's size and modification time match.
+ *
+ * digest() may be called from multiple threads at once.
+ */
+class DigestCache {
+public:
+	typedef std::array<char, 16> Digest;
+
+private:
+	struct Entry {
+		std::uint64_t size;
+		std::time_t mtime;
+		Digest md5;
+	};
+
+	const std::string path_;
+	std::unordered_map<std::string, Entry> entries_;
+	std::atomic<std::size_t> hashed_;
+	bool dirty_;
+	std::mutex lock_;
+
+	void load();
+
+public:
+	explicit DigestCache(std::string path);
+
+	Digest digest(const std::string& file);
+	std::size_t hashed() const { return hashed_; }
+	void save();
+};
+
+} // ember
\ No newline at end of file
@@ -14,13 +14,17 @@
 namespace ember { namespace client_integrity {
 
 Botan::secure_vector<Botan::byte> checksum(const Botan::secure_vector<Botan::byte>& seed,
-                                           const std::vector<char>* buffer) {
+                                           const BinaryView& binaries) {
 	auto sha160 = std::make_unique<Botan::SHA_160>();
 	Botan::HMAC hmac(sha160.get()); // Botan takes ownership
 	sha160.release(); // ctor didn't throw, relinquish the memory to Botan
 
 	hmac.set_key(seed);
-	hmac.update(reinterpret_cast<const Botan::byte*>(buffer->data()), buffer->size());
+
+	for(auto& segment : binaries.segments()) {
+		hmac.update(segment.data, segment.size);
+	}
+
 	return hmac.final();
 }
 
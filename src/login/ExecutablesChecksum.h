@@ -8,6 +8,7 @@
 
 #pragma once
 
+#include "BinaryView.h"
 #include <botan/secmem.h>
 #include <vector>
 #include <cstdint>
@@ -16,7 +17,7 @@
 namespace ember { namespace client_integrity {
 
 Botan::secure_vector<Botan::byte> checksum(const Botan::secure_vector<Botan::byte>& seed,
-                                           const std::vector<char>* buffer);
+                                           const BinaryView& binaries);
 
 Botan::secure_vector<Botan::byte> finalise(const Botan::secure_vector<Botan::byte>& checksum,
                                            const std::uint8_t* seed, std::size_t len);
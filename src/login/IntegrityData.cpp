@@ -9,15 +9,18 @@
 #include "IntegrityData.h"
 #include <shared/util/FNVHash.h>
 #include <boost/filesystem.hpp>
+#include <chrono>
 #include <initializer_list>
-#include <fstream>
 #include <cstddef>
 
 namespace bfs = boost::filesystem;
 
 namespace ember {
 
-IntegrityData::IntegrityData(const std::vector<GameVersion>& versions, const std::string& path) {
+IntegrityData::IntegrityData(const std::vector<GameVersion>& versions, const std::string& path,
+                             log::Logger* logger, bool prefetch)
+                             : logger_(logger),
+                               advice_(prefetch? BinaryView::Advice::WILL_NEED : BinaryView::Advice::NONE) {
 	std::initializer_list<std::string> winx86 { "WoW.exe", "fmod.dll", "ijl15.dll",
 	                                            "dbghelp.dll", "unicows.dll" };
 
@@ -41,12 +44,12 @@ IntegrityData::IntegrityData(const std::vector<GameVersion>& versions, const std
 	}
 }
 
-boost::optional<const std::vector<char>*> 
+boost::optional<const BinaryView*>
 IntegrityData::lookup(GameVersion version, grunt::Platform platform, grunt::System os) const {
 	auto it = data_.find(hash(version.build, platform, os));
 
 	if(it == data_.end()) {
-		return nullptr;
+		return boost::none;
 	}
 	
 	return &it->second;
@@ -62,33 +65,23 @@ void IntegrityData::load_binaries(const std::string& path, std::uint16_t build,
 		return;
 	}
 
-	auto fnv = hash(build, platform, system);
-	std::vector<char> buffer;
-	std::size_t write_offset = 0;
+	const auto start = std::chrono::steady_clock::now();
+	BinaryView binaries;
 
-	// write all of the binary data into a single buffer
+	// map the files in the order the client hashes them
 	for(auto& f : files) {
 		bfs::path fpath = dir;
 		fpath /= f;
+		binaries.map(fpath.string(), advice_);
+	}
 
-		std::ifstream file(fpath.string(), std::ios::binary | std::ios::ate);
-
-		if(!file.is_open()) {
-			throw std::runtime_error("Unable to open " + fpath.string());
-		}
-
-		std::streamsize size = file.tellg();
-		file.seekg(0, std::ios::beg);
-		buffer.resize(static_cast<std::size_t>(size) + buffer.size());
-
-		if(!file.read(buffer.data() + write_offset, size)) {
-			throw std::runtime_error("Unable to read " + fpath.string());
-		}
+	const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+		std::chrono::steady_clock::now() - start);
 
-		write_offset += static_cast<std::size_t>(size);
-	}
+	LOG_INFO(logger_) << "Mapped " << dir.filename().string() << " (" << binaries.size()
+	                  << " bytes) in " << elapsed.count() << "ms" << LOG_SYNC;
 
-	data_.emplace(fnv, std::move(buffer));
+	data_.emplace(hash(build, platform, system), std::move(binaries));
 }
 
 std::size_t IntegrityData::hash(std::uint16_t build, grunt::Platform platform,
@@ -10,7 +10,9 @@
 
 #include "GameVersion.h"
 #include "grunt/Magic.h"
+#include "BinaryView.h"
 #include "ExecutablesChecksum.h"
+#include <logger/Logging.h>
 #include <boost/optional.hpp>
 #include <string>
 #include <unordered_map>
@@ -20,7 +22,9 @@
 namespace ember {
 
 class IntegrityData {
-	std::unordered_map<std::size_t, std::vector<char>> data_;
+	std::unordered_map<std::size_t, BinaryView> data_;
+	log::Logger* logger_;
+	const BinaryView::Advice advice_;
 
 	std::size_t hash(std::uint16_t build, grunt::Platform platform, grunt::System os) const;
 
@@ -29,10 +33,11 @@ class IntegrityData {
 	                   grunt::System system, grunt::Platform platform);
 
 public:
-	IntegrityData(const std::vector<GameVersion>& versions, const std::string& path);
+	IntegrityData(const std::vector<GameVersion>& versions, const std::string& path,
+	              log::Logger* logger, bool prefetch = false);
 
-	boost::optional<const std::vector<char>*> lookup(GameVersion version, grunt::Platform platform,
-	                                                 grunt::System os) const;
+	boost::optional<const BinaryView*> lookup(GameVersion version, grunt::Platform platform,
+	                                          grunt::System os) const;
 };
 
 
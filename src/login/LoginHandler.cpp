@@ -12,8 +12,7 @@
 #include "grunt/Packets.h"
 #include <shared/metrics/Metrics.h>
 #include <shared/util/EnumHelper.h>
-#include <shared/util/SafeStaticCast.h>
-#include <boost/range/adaptor/map.hpp>
+#include <algorithm>
 #include <stdexcept>
  
 namespace ember {
@@ -23,8 +22,10 @@ const static int SHA1_LENGTH = 20; // should go somewhere else
 bool LoginHandler::update_state(const grunt::Packet* packet) try {
 	LOG_TRACE(logger_) << __func__ << LOG_ASYNC;
 
+	const auto now = LoginTimings::Clock::now();
 	State prev_state = state_;
 	state_ = State::CLOSED;
+	time_state(prev_state, now);
 
 	switch(prev_state) {
 		case State::INITIAL_CHALLENGE:
@@ -59,6 +60,7 @@ bool LoginHandler::update_state(const grunt::Packet* packet) try {
 			return false;
 	}
 
+	end_update(now);
 	return true;
 } catch(std::exception& e) {
 	LOG_DEBUG(logger_) << e.what() << LOG_ASYNC;
@@ -69,12 +71,21 @@ bool LoginHandler::update_state(const grunt::Packet* packet) try {
 bool LoginHandler::update_state(std::shared_ptr<Action> action) try {
 	LOG_TRACE(logger_) << __func__ << LOG_ASYNC;
 
+	const auto now = LoginTimings::Clock::now();
 	State prev_state = state_;
 	state_ = State::CLOSED;
+	time_state(prev_state, now);
+	time_action(prev_state, *action, now);
 
 	switch(prev_state) {
 		case State::FETCHING_USER_LOGIN:
-			send_login_challenge(static_cast<FetchUserAction*>(action.get()));
+			compute_login_challenge(static_cast<FetchUserAction*>(action.get()));
+			break;
+		case State::COMPUTING_CHALLENGE:
+			on_login_challenge(static_cast<LoginChallengeAction*>(action.get()));
+			break;
+		case State::COMPUTING_PROOF:
+			on_login_proof(static_cast<LoginProofAction*>(action.get()));
 			break;
 		case State::FETCHING_USER_RECONNECT:
 			fetch_session_key(static_cast<FetchUserAction*>(action.get()));
@@ -85,9 +96,6 @@ bool LoginHandler::update_state(std::shared_ptr<Action> action) try {
 		case State::WRITING_SESSION:
 			on_session_write(static_cast<RegisterSessionAction*>(action.get()));
 			break;
-		case State::REQUEST_REALMS:
-			on_survey_write(static_cast<SaveSurveyAction*>(action.get()));
-			break;
 		case State::FETCHING_CHARACTER_DATA:
 			on_character_data(static_cast<FetchCharacterCounts*>(action.get()));
 			break;
@@ -98,6 +106,7 @@ bool LoginHandler::update_state(std::shared_ptr<Action> action) try {
 			return false;
 	}
 
+	end_update(now);
 	return true;
 } catch(std::exception& e) {
 	LOG_DEBUG(logger_) << e.what() << LOG_ASYNC;
@@ -105,6 +114,108 @@ bool LoginHandler::update_state(std::shared_ptr<Action> action) try {
 	return false;
 }
 
+// packets that arrive while an action is outstanding have to wait until it completes
+bool LoginHandler::awaiting_action() const {
+	switch(state_) {
+		case State::FETCHING_USER_LOGIN:
+		case State::FETCHING_USER_RECONNECT:
+		case State::FETCHING_SESSION:
+		case State::FETCHING_CHARACTER_DATA:
+		case State::COMPUTING_CHALLENGE:
+		case State::COMPUTING_PROOF:
+		case State::WRITING_SESSION:
+			return true;
+		default:
+			return false;
+	}
+}
+
+// accumulates the time spent waiting in the state being left, for states that are part of the handshake
+void LoginHandler::time_state(State state, LoginTimings::Clock::time_point now) {
+	typedef LoginTimings::Phase Phase;
+	const auto elapsed = now - state_entered_;
+
+	switch(state) {
+		case State::INITIAL_CHALLENGE:
+			timing_.add(Phase::AWAIT_CHALLENGE, elapsed);
+			break;
+		case State::FETCHING_USER_LOGIN:
+		case State::FETCHING_USER_RECONNECT:
+			timing_.add(Phase::FETCH_USER, elapsed);
+			break;
+		case State::COMPUTING_CHALLENGE:
+			timing_.add(Phase::COMPUTE_CHALLENGE, elapsed);
+			break;
+		case State::LOGIN_PROOF:
+			timing_.add(Phase::AWAIT_PROOF, elapsed);
+			break;
+		case State::COMPUTING_PROOF:
+			timing_.add(Phase::COMPUTE_PROOF, elapsed);
+			break;
+		case State::FETCHING_SESSION:
+			timing_.add(Phase::FETCH_SESSION, elapsed);
+			break;
+		case State::RECONNECT_PROOF:
+			timing_.add(Phase::AWAIT_RECONNECT_PROOF, elapsed);
+			break;
+		case State::WRITING_SESSION:
+			timing_.add(Phase::WRITE_SESSION, elapsed);
+			break;
+		case State::FETCHING_CHARACTER_DATA:
+			timing_.add(Phase::FETCH_CHARACTERS, elapsed);
+			break;
+		default: // realm list, transfers and surveys aren't part of the handshake
+			break;
+	}
+}
+
+void LoginHandler::time_action(State state, const Action& action, LoginTimings::Clock::time_point now) {
+	typedef LoginTimings::Phase Phase;
+	const auto& times = action.timestamps;
+	const auto elapsed = times.completed - times.started;
+
+	timing_.add(Phase::QUEUED, times.started - times.submitted);
+	timing_.add(Phase::RESUME, now - times.completed);
+
+	switch(action.dispatch()) {
+		case Action::Dispatch::THREAD_POOL:
+			timing_.add(Phase::DATABASE, elapsed);
+			break;
+		case Action::Dispatch::CRYPTO:
+			timing_.add(Phase::CRYPTO, elapsed);
+			break;
+		case Action::Dispatch::ASYNC: // user lookups go through the database threads, the rest to Spark
+			if(state == State::FETCHING_USER_LOGIN || state == State::FETCHING_USER_RECONNECT) {
+				timing_.add(Phase::DATABASE, elapsed);
+			} else {
+				timing_.add(Phase::SPARK, elapsed);
+			}
+			break;
+	}
+}
+
+void LoginHandler::end_update(LoginTimings::Clock::time_point start) {
+	state_entered_ = LoginTimings::Clock::now();
+
+	if(timing_recorded_) {
+		return;
+	}
+
+	timing_.add(LoginTimings::Phase::HANDLER, state_entered_ - start);
+
+	if(!login_complete_) {
+		return;
+	}
+
+	timing_recorded_ = true;
+	timing_.add(LoginTimings::Phase::TOTAL, state_entered_ - login_start_);
+
+	if(timings_.record(timing_)) {
+		LOG_INFO(logger_) << "Slow login for " << challenge_.username << " ("
+		                  << LoginTimings::describe(timing_) << ")" << LOG_ASYNC;
+	}
+}
+
 void LoginHandler::initiate_login(const grunt::Packet* packet) {
 	LOG_TRACE(logger_) << __func__ << LOG_ASYNC;
 
@@ -169,6 +280,23 @@ bool LoginHandler::validate_protocol_version(const grunt::client::LoginChallenge
 void LoginHandler::fetch_user(grunt::Opcode opcode, const std::string& username) {
 	LOG_TRACE(logger_) << __func__ << LOG_ASYNC;
 
+	// checked before any database or crypto work is done for the attempt
+	if(!account_limiter_.admit(username)) {
+		LOG_DEBUG(logger_) << "Rate limit exceeded for " << username << LOG_ASYNC;
+
+		if(opcode == grunt::Opcode::CMD_AUTH_RECONNECT_CHALLENGE) {
+			grunt::server::ReconnectChallenge response;
+			response.result = grunt::Result::FAIL_DB_BUSY;
+			send(response);
+		} else {
+			grunt::server::LoginChallenge response;
+			response.result = grunt::Result::FAIL_DB_BUSY;
+			send(response);
+		}
+
+		return;
+	}
+
 	switch(opcode) {
 		case grunt::Opcode::CMD_AUTH_LOGON_CHALLENGE:
 			state_ = State::FETCHING_USER_LOGIN;
@@ -181,7 +309,7 @@ void LoginHandler::fetch_user(grunt::Opcode opcode, const std::string& username)
 			BOOST_ASSERT_MSG(false, "Impossible fetch_user condition");
 	}
 
-	auto action = std::make_shared<FetchUserAction>(username, user_src_);
+	auto action = std::make_shared<FetchUserAction>(username, user_src_, user_cache_);
 	execute_async(action);
 }
 
@@ -194,7 +322,7 @@ void LoginHandler::fetch_session_key(FetchUserAction* action_res) {
 	}
 
 	state_ = State::FETCHING_SESSION;
-	auto action = std::make_shared<FetchSessionKeyAction>(acct_svc_, user_->id());
+	auto action = std::make_shared<FetchSessionKeyAction>(acct_svc_, user_->user.id());
 	execute_async(action);
 }
 
@@ -219,42 +347,101 @@ void LoginHandler::build_login_challenge(grunt::server::LoginChallenge& packet)
 	packet.s = values.salt;
 	packet.two_factor_auth = false;
 
-	if(user_->pin_method() != PINMethod::NONE) {
+	if(user_->user.pin_method() != PINMethod::NONE) {
 		packet.two_factor_auth = true;
 		packet.pin_grid_seed = pin_auth_.grid_seed();
 		packet.pin_salt = pin_auth_.server_salt();
 	}
 
-	checksum_salt_ = Botan::AutoSeeded_RNG().random_vec(16);
+	boost::optional<PrecomputedChecksum> precomputed;
+
+	if(checksums_) {
+		precomputed = checksums_->take(challenge_.version, challenge_.platform, challenge_.os);
+	}
+
+	if(precomputed) {
+		checksum_salt_ = std::move(precomputed->salt);
+		expected_checksum_ = std::move(precomputed->checksum);
+	} else {
+		checksum_salt_ = Botan::AutoSeeded_RNG().random_vec(ChecksumPool::SALT_LENGTH);
+	}
+
 	std::copy(checksum_salt_.begin(), checksum_salt_.end(), packet.checksum_salt.data());
 }
 
-void LoginHandler::send_login_challenge(FetchUserAction* action) {
+void LoginHandler::compute_login_challenge(FetchUserAction* action) {
 	LOG_TRACE(logger_) << __func__ << LOG_ASYNC;
 
 	grunt::server::LoginChallenge response;
-	response.result = grunt::Result::SUCCESS;
 
 	try {
 		if((user_ = action->get_result())) {
-			state_data_ = std::make_unique<LoginAuthenticator>(*user_);
-			build_login_challenge(response);
-			state_ = State::LOGIN_PROOF;
-		} else {
-			// leaks information on whether the account exists (could send challenge anyway?)
-			response.result = grunt::Result::FAIL_UNKNOWN_ACCOUNT;
-			metrics_.increment("login_failure");
-			LOG_DEBUG(logger_) << "Account not found: " << action->username() << LOG_ASYNC;
+			boost::optional<srp6::PrecomputedEphemeral> ephemeral;
+
+			if(ephemerals_) {
+				ephemeral = ephemerals_->take();
+			}
+
+			// nothing expensive left to compute if we have a pre-generated key pair
+			if(ephemeral) {
+				send_login_challenge([&] {
+					return std::make_unique<LoginAuthenticator>(user_, *ephemeral);
+				});
+
+				return;
+			}
+
+			// generating the server's ephemeral key is expensive, keep it off the network threads
+			state_ = State::COMPUTING_CHALLENGE;
+			execute_async(std::make_shared<LoginChallengeAction>(user_));
+			return;
 		}
+
+		// leaks information on whether the account exists (could send challenge anyway?)
+		response.result = grunt::Result::FAIL_UNKNOWN_ACCOUNT;
+		metrics_.increment("login_failure");
+		LOG_DEBUG(logger_) << "Account not found: " << action->username() << LOG_ASYNC;
 	} catch(dal::exception& e) {
 		response.result = grunt::Result::FAIL_DB_BUSY;
 		metrics_.increment("login_internal_failure");
 		LOG_ERROR(logger_) << "DAL failure for " << action->username()
 		                   << ": " << e.what() << LOG_ASYNC;
+	}
+
+	send(response);
+}
+
+void LoginHandler::on_login_challenge(LoginChallengeAction* action) {
+	LOG_TRACE(logger_) << __func__ << LOG_ASYNC;
+
+	if(!action->ran()) {
+		grunt::server::LoginChallenge response;
+		response.result = grunt::Result::FAIL_DB_BUSY;
+		metrics_.increment("crypto_jobs_rejected");
+		LOG_WARN(logger_) << "Crypto pool saturated, rejecting " << user_->user.username() << LOG_ASYNC;
+		send(response);
+		return;
+	}
+
+	send_login_challenge([action] {
+		return action->get_result();
+	});
+}
+
+void LoginHandler::send_login_challenge(const AuthenticatorFactory& create_authenticator) {
+	LOG_TRACE(logger_) << __func__ << LOG_ASYNC;
+
+	grunt::server::LoginChallenge response;
+	response.result = grunt::Result::SUCCESS;
+
+	try {
+		state_data_ = create_authenticator();
+		build_login_challenge(response);
+		state_ = State::LOGIN_PROOF;
 	} catch(Botan::Exception& e) {
 		response.result = grunt::Result::FAIL_DB_BUSY;
 		metrics_.increment("login_internal_failure");
-		LOG_ERROR(logger_) << "Encoding failure for " << action->username()
+		LOG_ERROR(logger_) << "Encoding failure for " << user_->user.username()
 		                   << ": " << e.what() << LOG_ASYNC;
 	}
 	
@@ -264,7 +451,7 @@ void LoginHandler::send_login_challenge(FetchUserAction* action) {
 void LoginHandler::send_reconnect_proof(grunt::Result result) {
 	LOG_TRACE(logger_) << __func__ << LOG_ASYNC;
 
-	LOG_DEBUG(logger_) << "Reconnect result for " << user_->username() << ": "
+	LOG_DEBUG(logger_) << "Reconnect result for " << user_->user.username() << ": "
 	                   << grunt::to_string(result) << LOG_ASYNC;
 
 	if(result == grunt::Result::SUCCESS) {
@@ -291,12 +478,12 @@ void LoginHandler::send_reconnect_challenge(FetchSessionKeyAction* action) {
 
 	if(res.first == messaging::account::Status::OK) {
 		state_ = State::RECONNECT_PROOF;
-		state_data_ = std::make_unique<ReconnectAuthenticator>(user_->username(), res.second, checksum_salt_);
+		state_data_ = std::make_unique<ReconnectAuthenticator>(user_->user.username(), res.second, checksum_salt_);
 	} else if(res.first == messaging::account::Status::SESSION_NOT_FOUND) {
 		metrics_.increment("login_failure");
 		response.result = grunt::Result::FAIL_NOACCESS;
 		LOG_DEBUG(logger_) << "Reconnect failed, session not found for "
-		                   << user_->username() << LOG_ASYNC;
+		                   << user_->user.username() << LOG_ASYNC;
 	} else {
 		metrics_.increment("login_internal_failure");
 		response.result = grunt::Result::FAIL_DB_BUSY;
@@ -311,7 +498,7 @@ bool LoginHandler::validate_pin(const grunt::client::LoginProof* packet) {
 	LOG_TRACE(logger_) << __func__ << LOG_ASYNC;
 
 	// no PIN was expected, nothing to validate
-	if(user_->pin_method() == PINMethod::NONE) {
+	if(user_->user.pin_method() == PINMethod::NONE) {
 		return true;
 	}
 
@@ -325,12 +512,12 @@ bool LoginHandler::validate_pin(const grunt::client::LoginProof* packet) {
 	pin_auth_.set_client_hash(packet->pin_hash);
 	pin_auth_.set_client_salt(packet->pin_salt);
 
-	if(user_->pin_method() == PINMethod::FIXED) {
-		pin_auth_.set_pin(user_->pin());
+	if(user_->user.pin_method() == PINMethod::FIXED) {
+		pin_auth_.set_pin(user_->user.pin());
 		result = pin_auth_.validate_pin(packet->pin_hash);
-	} else if(user_->pin_method() == PINMethod::TOTP) {
+	} else if(user_->user.pin_method() == PINMethod::TOTP) {
 		for(int interval = -1; interval < 2; ++interval) { // try time intervals -1 to +1
-			pin_auth_.set_pin(PINAuthenticator::generate_totp_pin(user_->totp_token(), interval));
+			pin_auth_.set_pin(PINAuthenticator::generate_totp_pin(user_->user.totp_token(), interval));
 
 			if(pin_auth_.validate_pin(packet->pin_hash)) {
 				result = true;
@@ -339,10 +526,10 @@ bool LoginHandler::validate_pin(const grunt::client::LoginProof* packet) {
 		}
 	} else {
 		LOG_ERROR(logger_) << "Unknown TOTP method, "
-		                   << util::enum_value(user_->pin_method()) << LOG_ASYNC;
+		                   << util::enum_value(user_->user.pin_method()) << LOG_ASYNC;
 	}
 
-	LOG_DEBUG(logger_) << "PIN authentication for " << user_->username()
+	LOG_DEBUG(logger_) << "PIN authentication for " << user_->user.username()
 	                   << (result ? " OK" : " failed") << LOG_ASYNC;
 
 	return result;
@@ -378,8 +565,10 @@ bool LoginHandler::validate_client_integrity(const std::array<std::uint8_t, SHA1
 	if(reconnect) {
 		Botan::secure_vector<Botan::byte> checksum(SHA1_LENGTH); // all-zero hash
 		hash = client_integrity::finalise(checksum, salt, len);
+	} else if(expected_checksum_) {
+		hash = client_integrity::finalise(*expected_checksum_, salt, len);
 	} else {
-		auto checksum = client_integrity::checksum(checksum_salt_, *data);
+		auto checksum = client_integrity::checksum(checksum_salt_, **data);
 		hash = client_integrity::finalise(checksum, salt, len);
 	}
 
@@ -406,21 +595,39 @@ void LoginHandler::handle_login_proof(const grunt::Packet* packet) {
 	}
 
 	const auto& authenticator = boost::get<std::unique_ptr<LoginAuthenticator>>(state_data_);
-	const auto proof = authenticator->proof_check(proof_packet);
+	state_ = State::COMPUTING_PROOF;
+	execute_async(std::make_shared<LoginProofAction>(*authenticator, *proof_packet));
+}
+
+void LoginHandler::on_login_proof(LoginProofAction* action) {
+	LOG_TRACE(logger_) << __func__ << LOG_ASYNC;
+
+	if(!action->ran()) {
+		metrics_.increment("crypto_jobs_rejected");
+		LOG_WARN(logger_) << "Crypto pool saturated, rejecting " << user_->user.username() << LOG_ASYNC;
+		send_login_proof(grunt::Result::FAIL_DB_BUSY);
+		return;
+	}
+
+	const auto& authenticator = boost::get<std::unique_ptr<LoginAuthenticator>>(state_data_);
+	const auto proof = action->get_result();
 	auto result = grunt::Result::FAIL_INCORRECT_PASSWORD;
 	
 	if(proof.match) {
-		if(user_->banned()) {
+		if(user_->user.banned()) {
 			result = grunt::Result::FAIL_BANNED;
-		} else if(user_->suspended()) {
+		} else if(user_->user.suspended()) {
 			result = grunt::Result::FAIL_SUSPENDED;
-		} else if(!user_->subscriber()) {
+		} else if(!user_->user.subscriber()) {
 			result = grunt::Result::FAIL_NO_TIME;
 		/*} else if(parental_controls) {
 			result = grunt::Result::FAIL_PARENTAL_CONTROLS;*/
 		} else {
 			result = grunt::Result::SUCCESS;
 		}
+	} else if(user_cache_) {
+		// the password may have changed since the record was cached, go to the DB next time
+		user_cache_->invalidate(user_->user.id());
 	}
 
 	if(result == grunt::Result::SUCCESS) {
@@ -428,7 +635,7 @@ void LoginHandler::handle_login_proof(const grunt::Packet* packet) {
 		server_proof_ = proof.server_proof;
 
 		auto action = std::make_shared<RegisterSessionAction>(
-			acct_svc_, user_->id(),
+			acct_svc_, user_->user.id(),
 			authenticator->session_key()
 		);
 
@@ -452,12 +659,30 @@ void LoginHandler::send_login_proof(grunt::Result result, bool survey) {
 		metrics_.increment("login_failure");
 	}
 
-	LOG_DEBUG(logger_) << "Login result for " << user_->username() << ": "
+	LOG_DEBUG(logger_) << "Login result for " << user_->user.username() << ": "
 	                   << grunt::to_string(result) << LOG_ASYNC;
 
 	send(response);
 }
 
+void LoginHandler::fetch_character_counts(bool reconnect) {
+	LOG_TRACE(logger_) << __func__ << LOG_ASYNC;
+
+	state_ = State::FETCHING_CHARACTER_DATA;
+
+	// kept current by the character service, so a hit saves a DB round trip
+	if(char_counts_) {
+		if(auto counts = char_counts_->find(user_->user.id())) {
+			state_data_ = std::move(*counts);
+			complete_login(reconnect);
+			return;
+		}
+	}
+
+	execute_async(std::make_shared<FetchCharacterCounts>(user_->user.id(), user_src_,
+	                                                     char_counts_, reconnect));
+}
+
 void LoginHandler::on_character_data(FetchCharacterCounts* action) {
 	LOG_TRACE(logger_) << __func__ << LOG_ASYNC;
 
@@ -466,18 +691,35 @@ void LoginHandler::on_character_data(FetchCharacterCounts* action) {
 	} catch(dal::exception& e) { // not a fatal exception, we'll keep going without the data
 		state_data_ = CharacterCount();
 		metrics_.increment("login_internal_failure");
-		LOG_ERROR(logger_) << "DAL failure for " << user_->username()
+		LOG_ERROR(logger_) << "DAL failure for " << user_->user.username()
 		                   << ": " << e.what() << LOG_ASYNC;
 	}
 
+	complete_login(action->reconnect());
+}
+
+void LoginHandler::complete_login(bool reconnect) {
+	LOG_TRACE(logger_) << __func__ << LOG_ASYNC;
+
 	state_ = State::REQUEST_REALMS;
+	login_complete_ = true;
+
+	// source_ is the remote endpoint, only the address is recorded
+	auto ip = source_.substr(0, source_.find_last_of(':'));
+	ip.erase(std::remove(ip.begin(), ip.end(), '['), ip.end());
+	ip.erase(std::remove(ip.begin(), ip.end(), ']'), ip.end());
 
-	if(action->reconnect()) {
+	if(!writer_.record_login(user_->user.id(), std::move(ip))) {
+		LOG_WARN(logger_) << "Write queue full, dropped login record for "
+		                  << user_->user.username() << LOG_ASYNC;
+	}
+
+	if(reconnect) {
 		send_reconnect_proof(grunt::Result::SUCCESS);
 		return;
 	}
 	
-	if(user_->survey_request() && patcher_.survey_platform(challenge_.platform, challenge_.os)) {
+	if(user_->user.survey_request() && patcher_.survey_platform(challenge_.platform, challenge_.os)) {
 		state_ = State::SURVEY_INITIATE;
 	}
 
@@ -485,6 +727,7 @@ void LoginHandler::on_character_data(FetchCharacterCounts* action) {
 
 	if(state_ == State::SURVEY_INITIATE) {
 		LOG_DEBUG(logger_) << "Initiating survey transfer..." << LOG_ASYNC;
+		transfer_state_.data = patcher_.survey_data(challenge_.platform, challenge_.os);
 		initiate_file_transfer(patcher_.survey_meta());
 	}
 }
@@ -508,7 +751,7 @@ void LoginHandler::on_session_write(RegisterSessionAction* action) {
 
 	// defer sending the response until we've fetched the character data
 	if(result == messaging::account::Status::OK) {
-		execute_async(std::make_shared<FetchCharacterCounts>(user_->id(), user_src_));
+		fetch_character_counts(false);
 	} else {
 		send_login_proof(response);
 	}
@@ -532,8 +775,7 @@ void LoginHandler::handle_reconnect_proof(const grunt::Packet* packet) {
 	const auto& authenticator = boost::get<std::unique_ptr<ReconnectAuthenticator>>(state_data_);
 
 	if(authenticator->proof_check(proof)) {
-		state_ = State::FETCHING_CHARACTER_DATA;
-		execute_async(std::make_shared<FetchCharacterCounts>(user_->id(), user_src_, true));
+		fetch_character_counts(true);
 	} else {
 		send_reconnect_proof(grunt::Result::FAIL_INCORRECT_PASSWORD);
 	}
@@ -553,18 +795,18 @@ void LoginHandler::send_realm_list(const grunt::Packet* packet) {
 		return;
 	}
 
-	const std::shared_ptr<const RealmMap> realms = realm_list_.realms();
-	auto& char_count = boost::get<CharacterCount>(state_data_);
-	grunt::server::RealmList response;
+	boost::optional<dbc::Cfg_Categories::Region> filter;
 
-	for(auto& realm : *realms | boost::adaptors::map_values) {
-		if(realm.region == region->second || !locale_enforce_) {
-			response.realms.push_back({ realm, char_count[realm.id] });
-		}
+	if(locale_enforce_) {
+		filter = region->second;
 	}
 
+	// the list is serialised whenever realms change, only the character counts are filled in here
+	auto realms = realm_list_.realm_list(filter);
+	auto& char_count = boost::get<CharacterCount>(state_data_);
+
 	state_ = State::REQUEST_REALMS;
-	send(response);
+	send(grunt::server::RealmListResponse(*realms, char_count));
 }
 
 void LoginHandler::patch_client(const grunt::client::LoginChallenge* challenge) {
@@ -585,14 +827,26 @@ void LoginHandler::patch_client(const grunt::client::LoginChallenge* challenge)
 	auto fmeta = meta->file_meta;
 
 	LOG_DEBUG(logger_) << "Initiating patch transfer, " << fmeta.name << LOG_ASYNC;
-	std::ifstream patch(fmeta.path + fmeta.name, std::ios::binary | std::ios::beg);
 
-	if(!patch.is_open()) {
-		LOG_ERROR(logger_) << "Could not open patch, " << fmeta.name << LOG_ASYNC;
+	try {
+		transfer_state_.file = patcher_.patch_file(fmeta);
+	} catch(const std::exception& e) {
+		LOG_ERROR(logger_) << "Could not open patch, " << fmeta.name << ": " << e.what() << LOG_ASYNC;
+		return;
+	}
+
+	// chunks are read from a single mapping, so it has to hold the whole file the client was promised
+	auto& segments = transfer_state_.file->segments();
+	const std::uint64_t mapped = segments.empty()? 0 : segments.front().size;
+
+	if(mapped != transfer_state_.file->size() || mapped != fmeta.size) {
+		LOG_ERROR(logger_) << "Patch size mismatch, " << fmeta.name << ": expected " << fmeta.size
+		                   << " bytes, mapped " << mapped << LOG_ASYNC;
+		transfer_state_.file = nullptr;
 		return;
 	}
 
-	transfer_state_.file = std::move(patch);
+	transfer_state_.data = segments.empty()? nullptr : reinterpret_cast<const char*>(segments.front().data);
 	
 	if(meta->mpq) {
 		fmeta.name = "Patch";
@@ -629,7 +883,7 @@ void LoginHandler::handle_survey_result(const grunt::Packet* packet) {
 
 	if(survey->survey_id != patcher_.survey_id()) {
 		LOG_DEBUG(logger_) << "Received an invalid survey ID from "
-		                   << user_->username() << LOG_ASYNC;
+		                   << user_->user.username() << LOG_ASYNC;
 		return;
 	}
 
@@ -642,21 +896,12 @@ void LoginHandler::handle_survey_result(const grunt::Packet* packet) {
 		return;
 	}
 
-	auto action = std::make_shared<SaveSurveyAction>(
-		user_->id(), user_src_,
-		survey->survey_id, survey->data
-	);
-
 	metrics_.increment("surveys_received");
-	execute_async(action);
-}
 
-void LoginHandler::on_survey_write(SaveSurveyAction* action) {
-	LOG_TRACE(logger_) << __func__ << LOG_ASYNC;
-
-	if(action->error()) {
-		LOG_ERROR(logger_) << "DAL failure for " << user_->username() << ", "
-		                   << action->exception().what() << LOG_ASYNC;
+	// written in the background, the client doesn't wait on the result
+	if(!writer_.save_survey(user_->user.id(), survey->survey_id, survey->data)) {
+		LOG_WARN(logger_) << "Write queue full, dropped survey from "
+		                  << user_->user.username() << LOG_ASYNC;
 	}
 }
 
@@ -669,6 +914,10 @@ void LoginHandler::set_transfer_offset(const grunt::Packet* packet) {
 		throw std::runtime_error("Expected CMD_XFER_RESUME");
 	}
 
+	if(resume->offset > transfer_state_.size) {
+		throw std::runtime_error("Transfer resume offset is beyond the end of the file");
+	}
+
 	transfer_state_.offset = resume->offset;
 }
 
@@ -681,7 +930,9 @@ void LoginHandler::handle_transfer_ack(const grunt::Packet* packet, bool survey)
 			[[fallthrough]];
 		case grunt::Opcode::CMD_XFER_ACCEPT:
 			state_ = survey? State::SURVEY_TRANSFER : State::PATCH_TRANSFER;
-			transfer_chunk();
+			transfer_state_.start = std::chrono::steady_clock::now();
+			transfer_state_.start_offset = transfer_state_.offset;
+			transfer_chunks();
 			break;
 		case grunt::Opcode::CMD_XFER_CANCEL:
 			state_ = survey? State::SURVEY_RESULT : State::CLOSED;
@@ -697,34 +948,46 @@ void LoginHandler::handle_transfer_abort() {
 	transfer_state_.abort = true;
 }
 
-void LoginHandler::transfer_chunk() {
+/*
+ * Sends the next window of chunks straight from the shared file mapping as
+ * a single write. Each write has to complete before the next is issued, so
+ * the window controls how much data is handed to the socket at a time.
+ */
+void LoginHandler::transfer_chunks() {
 	LOG_TRACE(logger_) << __func__ << LOG_ASYNC;
 
-	auto remaining = transfer_state_.size - transfer_state_.offset;
-	std::uint16_t read_size = grunt::server::TransferData::MAX_CHUNK_SIZE;
-
-	if(read_size > remaining) {
-		read_size = static_cast<std::uint16_t>(remaining);
-	}
+	const std::uint64_t chunk_size = grunt::server::TransferData::MAX_CHUNK_SIZE;
+	std::uint64_t window = std::max<std::size_t>(transfer_config_.window, 1);
 
-	grunt::server::TransferData response;
-	response.size = read_size;
-
-	if(state_ == State::SURVEY_TRANSFER) {
-		auto survey_mpq = patcher_.survey_data(challenge_.platform, challenge_.os).begin();
-		survey_mpq += safe_static_cast<int>(transfer_state_.offset);
-		std::copy(survey_mpq, survey_mpq + read_size, response.chunk.data());
-	} else {
-		transfer_state_.file.read(response.chunk.data(), read_size);
+	// hold back until the session is within its bandwidth allowance, allowing a one chunk burst
+	if(transfer_config_.max_rate) {
+		const std::uint64_t rate = transfer_config_.max_rate;
+		const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+			std::chrono::steady_clock::now() - transfer_state_.start);
+		const std::uint64_t allowance = (rate * elapsed.count()) / 1000 + chunk_size;
+		const std::uint64_t sent = transfer_state_.offset - transfer_state_.start_offset;
 
-		if(!transfer_state_.file.good()) {
-			LOG_ERROR(logger_) << "Patch reading failed during transfer" << LOG_ASYNC;
+		if(sent >= allowance) {
+			defer_chunks(std::chrono::milliseconds(((sent - allowance + chunk_size) * 1000) / rate));
 			return;
 		}
+
+		window = std::min(window, std::max<std::uint64_t>((allowance - sent) / chunk_size, 1));
 	}
 
-	transfer_state_.offset += read_size;
-	send_chunk(response);
+	std::vector<grunt::server::TransferData> chunks;
+
+	do {
+		auto remaining = transfer_state_.size - transfer_state_.offset;
+
+		grunt::server::TransferData chunk;
+		chunk.size = static_cast<std::uint16_t>(std::min(remaining, chunk_size));
+		chunk.chunk = transfer_state_.data + transfer_state_.offset;
+		transfer_state_.offset += chunk.size;
+		chunks.emplace_back(chunk);
+	} while(chunks.size() < window && transfer_state_.offset < transfer_state_.size);
+
+	send_chunks(chunks);
 }
 
 void LoginHandler::on_chunk_complete() {
@@ -747,7 +1010,7 @@ void LoginHandler::on_chunk_complete() {
 				break;
 		}
 	} else {
-		transfer_chunk();
+		transfer_chunks();
 	}
 }
 
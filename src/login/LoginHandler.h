@@ -11,19 +11,28 @@
 #include "Actions.h"
 #include "AccountService.h"
 #include "Authenticator.h"
+#include "BatchWriter.h"
+#include "BinaryView.h"
+#include "CharacterCountCache.h"
+#include "ChecksumPool.h"
 #include "IntegrityData.h"
+#include "LoginTimings.h"
 #include "GameVersion.h"
 #include "RealmList.h"
 #include "PINAuthenticator.h"
+#include "RateLimiter.h"
+#include "UserCache.h"
 #include "grunt/Packets.h"
 #include "grunt/Handler.h"
 #include <logger/Logging.h>
 #include <shared/database/daos/UserDAO.h>
+#include <shared/threading/PrecomputedPool.h>
+#include <srp6/Server.h>
 #include <botan/bigint.h>
 #include <botan/secmem.h>
 #include <boost/optional.hpp>
 #include <boost/variant.hpp>
-#include <fstream>
+#include <chrono>
 #include <functional>
 #include <memory>
 #include <string>
@@ -37,15 +46,26 @@ struct FileMeta;
 class Patcher;
 class Metrics;
 
+typedef PrecomputedPool<srp6::PrecomputedEphemeral> EphemeralPool;
+
+struct TransferConfig {
+	std::size_t window;   // chunks coalesced into each socket write
+	std::size_t max_rate; // bytes per second, zero for no limit
+};
+
 struct TransferState {
-	std::ifstream file;
+	std::shared_ptr<const BinaryView> file; // keeps the shared patch mapping alive
+	const char* data;
 	std::uint64_t offset;
 	std::uint64_t size;
+	std::uint64_t start_offset;
+	std::chrono::steady_clock::time_point start;
 	bool abort;
 };
 
 class LoginHandler {
-	typedef std::unordered_map<std::uint32_t, std::uint32_t> CharacterCount;
+	typedef CharacterCountCache::Counts CharacterCount;
+	typedef std::function<std::unique_ptr<LoginAuthenticator>()> AuthenticatorFactory;
 
 	typedef boost::variant<
 		std::unique_ptr<LoginAuthenticator>,
@@ -59,7 +79,8 @@ class LoginHandler {
 		PATCH_INITIATE, PATCH_TRANSFER, 
 		FETCHING_USER_LOGIN, FETCHING_USER_RECONNECT, FETCHING_SESSION,
 		FETCHING_CHARACTER_DATA,
-		WRITING_SESSION, WRITING_SURVEY,
+		COMPUTING_CHALLENGE, COMPUTING_PROOF,
+		WRITING_SESSION,
 		CLOSED
 	} state_ = State::INITIAL_CHALLENGE;
 
@@ -68,39 +89,57 @@ class LoginHandler {
 	const Patcher& patcher_;
 	const RealmList& realm_list_;
 	const dal::UserDAO& user_src_;
-	boost::optional<User> user_;
+	UserCache* user_cache_;
+	UserCache::Record user_;
+	CharacterCountCache* char_counts_;
+	BatchWriter& writer_;
+	RateLimiter& account_limiter_;
+	LoginTimings& timings_;
+	LoginTimings::Sample timing_;
+	const LoginTimings::Clock::time_point login_start_;
+	LoginTimings::Clock::time_point state_entered_;
+	bool login_complete_ = false;
+	bool timing_recorded_ = false;
 	Botan::BigInt server_proof_;
 	const std::string source_;
 	const AccountService& acct_svc_;
 	const IntegrityData* exe_data_;
+	EphemeralPool* ephemerals_;
+	ChecksumPool* checksums_;
 	PINAuthenticator pin_auth_;
 	StateContainer state_data_;
 	Botan::secure_vector<Botan::byte> checksum_salt_;
+	boost::optional<Botan::secure_vector<Botan::byte>> expected_checksum_;
 	grunt::client::LoginChallenge challenge_;
 	TransferState transfer_state_;
+	const TransferConfig transfer_config_;
 	const bool locale_enforce_;
 
 	void initiate_login(const grunt::Packet* packet);
 	void initiate_file_transfer(const FileMeta& meta);
 
 	void handle_login_proof(const grunt::Packet* packet);
+	void on_login_proof(LoginProofAction* action);
 	void handle_reconnect_proof(const grunt::Packet* packet);
 	void handle_survey_result(const grunt::Packet* packet);
 	void handle_transfer_ack(const grunt::Packet* packet, bool survey);
 	void handle_transfer_abort();
 
-	void send_login_challenge(FetchUserAction* action);
+	void compute_login_challenge(FetchUserAction* action);
+	void on_login_challenge(LoginChallengeAction* action);
+	void send_login_challenge(const AuthenticatorFactory& create_authenticator);
 	void send_login_proof(grunt::Result result, bool survey = false);
 	void send_reconnect_challenge(FetchSessionKeyAction* action);
 	void send_reconnect_proof(grunt::Result result);
 	void send_realm_list(const grunt::Packet* packet);
 	void build_login_challenge(grunt::server::LoginChallenge& packet);
 
+	void fetch_character_counts(bool reconnect);
 	void on_character_data(FetchCharacterCounts* action);
+	void complete_login(bool reconnect);
 	void on_session_write(RegisterSessionAction* action);
-	void on_survey_write(SaveSurveyAction* action);
 
-	void transfer_chunk();
+	void transfer_chunks();
 	void set_transfer_offset(const grunt::Packet* packet);
 
 	bool validate_pin(const grunt::client::LoginProof* packet);
@@ -116,24 +155,37 @@ class LoginHandler {
 	void fetch_user(grunt::Opcode opcode, const std::string& username);
 	void fetch_session_key(FetchUserAction* action);
 
+	void time_state(State state, LoginTimings::Clock::time_point now);
+	void time_action(State state, const Action& action, LoginTimings::Clock::time_point now);
+	void end_update(LoginTimings::Clock::time_point start);
+
 	void reject_client(const GameVersion& version);
 	void patch_client(const grunt::client::LoginChallenge* version);
 
 public:
 	std::function<void(std::shared_ptr<Action> action)> execute_async;
 	std::function<void(const grunt::Packet&)> send;
-	std::function<void(const grunt::Packet&)> send_chunk;
+	std::function<void(const std::vector<grunt::server::TransferData>&)> send_chunks;
+	std::function<void(std::chrono::milliseconds)> defer_chunks;
 
 	bool update_state(std::shared_ptr<Action> action);
 	bool update_state(const grunt::Packet* packet);
+	bool awaiting_action() const;
 	void on_chunk_complete();
 
-	LoginHandler(const dal::UserDAO& users, const AccountService& acct_svc, const Patcher& patcher,
-	             const IntegrityData* exe_data, log::Logger* logger, const RealmList& realm_list,
-	             std::string source, Metrics& metrics, bool locale_enforce)
-	             : user_src_(users), patcher_(patcher), logger_(logger), acct_svc_(acct_svc),
-	               realm_list_(realm_list), source_(std::move(source)), metrics_(metrics),
-	               pin_auth_(logger), exe_data_(exe_data), transfer_state_{},
+	LoginHandler(const dal::UserDAO& users, UserCache* user_cache, CharacterCountCache* char_counts,
+	             BatchWriter& writer, RateLimiter& account_limiter, LoginTimings& timings,
+	             const AccountService& acct_svc, const Patcher& patcher, const IntegrityData* exe_data,
+	             ChecksumPool* checksums, EphemeralPool* ephemerals, log::Logger* logger,
+	             const RealmList& realm_list, std::string source, Metrics& metrics,
+	             const TransferConfig& transfer_config, bool locale_enforce)
+	             : user_src_(users), user_cache_(user_cache), char_counts_(char_counts),
+	               writer_(writer), account_limiter_(account_limiter), timings_(timings),
+	               login_start_(LoginTimings::Clock::now()), state_entered_(login_start_),
+	               patcher_(patcher), logger_(logger), acct_svc_(acct_svc), realm_list_(realm_list),
+	               source_(std::move(source)), metrics_(metrics),
+	               pin_auth_(logger), exe_data_(exe_data), checksums_(checksums),
+	               ephemerals_(ephemerals), transfer_state_{}, transfer_config_(transfer_config),
 	               locale_enforce_(locale_enforce) { }
 };
 
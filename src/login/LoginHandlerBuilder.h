@@ -27,22 +27,38 @@ class LoginHandlerBuilder {
 	const Patcher& patcher_;
 	const RealmList& realm_list_;
 	const dal::UserDAO& user_dao_;
+	UserCache* user_cache_;
+	CharacterCountCache* char_counts_;
+	BatchWriter& writer_;
+	RateLimiter& account_limiter_;
+	LoginTimings& timings_;
 	const AccountService& acct_svc_;
 	const IntegrityData* exe_data_;
+	ChecksumPool* checksums_;
+	EphemeralPool* ephemerals_;
 	Metrics& metrics_;
+	const TransferConfig transfer_config_;
 	bool locale_enforce_;
 
 public:
 	LoginHandlerBuilder(log::Logger* logger, const Patcher& patcher, const IntegrityData* exe_data,
-	                    const dal::UserDAO& user_dao, const AccountService& acct_svc,
-	                    RealmList& realm_list, Metrics& metrics, bool locale_enforce)
-	                    : logger_(logger), patcher_(patcher), user_dao_(user_dao), acct_svc_(acct_svc),
+	                    ChecksumPool* checksums, EphemeralPool* ephemerals,
+	                    const dal::UserDAO& user_dao, UserCache* user_cache,
+	                    CharacterCountCache* char_counts, BatchWriter& writer,
+	                    RateLimiter& account_limiter, LoginTimings& timings,
+	                    const AccountService& acct_svc, RealmList& realm_list, Metrics& metrics,
+	                    const TransferConfig& transfer_config, bool locale_enforce)
+	                    : logger_(logger), patcher_(patcher), user_dao_(user_dao),
+	                      user_cache_(user_cache), char_counts_(char_counts), writer_(writer),
+	                      account_limiter_(account_limiter), timings_(timings), acct_svc_(acct_svc),
 	                      realm_list_(realm_list), metrics_(metrics), exe_data_(exe_data),
-	                      locale_enforce_(locale_enforce) {}
+	                      checksums_(checksums), ephemerals_(ephemerals),
+	                      transfer_config_(transfer_config), locale_enforce_(locale_enforce) {}
 
 	LoginHandler create(std::string source) const {
-		return { user_dao_, acct_svc_, patcher_, exe_data_, logger_, realm_list_, std::move(source),
-		         metrics_, locale_enforce_ };
+		return { user_dao_, user_cache_, char_counts_, writer_, account_limiter_, timings_, acct_svc_,
+		         patcher_, exe_data_, checksums_, ephemerals_, logger_, realm_list_, std::move(source), metrics_,
+		         transfer_config_, locale_enforce_ };
 	}
 };
 
@@ -11,24 +11,33 @@
 #include "FilterTypes.h"
 #include <shared/metrics/Metrics.h>
 #include <shared/threading/ThreadPool.h>
+#include <array>
 #include <exception>
 #include <functional>
 #include <memory>
 #include <utility>
+#include <vector>
+#include <cstdint>
 
 namespace ember {
 
 LoginSession::LoginSession(SessionManager& sessions, boost::asio::ip::tcp::socket socket,
-                           log::Logger* logger, ThreadPool& pool, const LoginHandlerBuilder& builder)
+                           log::Logger* logger, ThreadPool& pool, ThreadPool& crypto_pool,
+                           const LoginHandlerBuilder& builder)
                            : handler_(builder.create(remote_address())),
-                             logger_(logger), pool_(pool), grunt_handler_(logger),
+                             logger_(logger), pool_(pool), crypto_pool_(crypto_pool),
+                             grunt_handler_(logger), transfer_timer_(strand().get_io_service()),
                              NetworkSession(sessions, std::move(socket), logger) {
 	handler_.send = [&](auto& packet) {
 		write_chain(packet, false);
 	};
 
-	handler_.send_chunk = [&](auto& packet) {
-		write_chain(packet, true);
+	handler_.send_chunks = [&](auto& chunks) {
+		write_chunks(chunks);
+	};
+
+	handler_.defer_chunks = [&](auto delay) {
+		defer_chunks(delay);
 	};
 
 	handler_.execute_async = [&](auto action) {
@@ -39,12 +48,25 @@ LoginSession::LoginSession(SessionManager& sessions, boost::asio::ip::tcp::socke
 bool LoginSession::handle_packet(spark::Buffer& buffer) try {
 	LOG_TRACE_FILTER(logger_, LF_NETWORK) << __func__ << LOG_ASYNC;
 
-	boost::optional<grunt::PacketHandle> packet = grunt_handler_.try_deserialise(buffer);
+	// a single read can hold several packets if the client didn't wait for a reply between them
+	while(!buffer.empty()) {
+		// leave anything pipelined behind an outstanding action in the buffer until it completes
+		if(handler_.awaiting_action()) {
+			return buffer.size() <= MAX_PIPELINED_BYTES;
+		}
+
+		boost::optional<grunt::PacketHandle> packet = grunt_handler_.try_deserialise(buffer);
+
+		if(!packet) {
+			break;
+		}
 
-	if(packet) {
 		LOG_TRACE_FILTER(logger_, LF_NETWORK) << remote_address() << " -> "
 			<< grunt::to_string((*packet)->opcode) << LOG_ASYNC;
-		return handler_.update_state(packet->get());
+
+		if(!handler_.update_state(packet->get())) {
+			return false;
+		}
 	}
 
 	return true;
@@ -57,14 +79,38 @@ void LoginSession::execute_async(std::shared_ptr<Action> action) {
 	LOG_TRACE_FILTER(logger_, LF_NETWORK) << __func__ << LOG_ASYNC;
 
 	auto self(shared_from_this());
+	auto& times = action->timestamps;
+	times.submitted = Action::Clock::now();
 
-	pool_.run([action, this, self] {
-		action->execute();
+	// resume the handler on the session's strand, regardless of where the action finished
+	auto complete = [action, this, self] {
+		action->timestamps.completed = Action::Clock::now();
 
 		strand().post([action, this, self] {
 			async_completion(action);
 		});
-	});
+	};
+
+	auto run = [action, complete] {
+		action->timestamps.started = Action::Clock::now();
+		action->execute(complete);
+	};
+
+	switch(action->dispatch()) {
+		case Action::Dispatch::THREAD_POOL:
+			pool_.run(run);
+			break;
+		case Action::Dispatch::CRYPTO:
+			// the action will report that it never ran if the pool sheds it
+			if(!crypto_pool_.try_run(run)) {
+				times.started = times.submitted;
+				complete();
+			}
+			break;
+		case Action::Dispatch::ASYNC:
+			run();
+			break;
+	}
 }
 
 void LoginSession::async_completion(std::shared_ptr<Action> action) try {
@@ -72,7 +118,10 @@ void LoginSession::async_completion(std::shared_ptr<Action> action) try {
 
 	if(!handler_.update_state(action)) {
 		close_session(); // todo change
+		return;
 	}
+
+	process_buffered();
 } catch(std::exception& e) {
 	LOG_DEBUG(logger_) << e.what() << LOG_ASYNC;
 	close_session();
@@ -91,6 +140,43 @@ void LoginSession::write_chain(const grunt::Packet& packet, bool notify) {
 	NetworkSession::write_chain(chain, notify);
 }
 
+/*
+ * All chunks go out in one write so they can't interleave with each other on the socket.
+ * Only the headers are copied - the payloads are sent straight from the file mapping,
+ * which the handler keeps alive for as long as this session (and so the write) exists.
+ */
+void LoginSession::write_chunks(const std::vector<grunt::server::TransferData>& chunks) {
+	LOG_TRACE_FILTER(logger_, LF_NETWORK) << __func__ << LOG_ASYNC;
+
+	typedef std::array<std::uint8_t, grunt::server::TransferData::HEADER_LENGTH> Header;
+	auto headers = std::make_shared<std::vector<Header>>();
+	headers->reserve(chunks.size());
+
+	std::vector<boost::asio::const_buffer> buffers;
+	buffers.reserve(chunks.size() * 2);
+
+	for(auto& chunk : chunks) {
+		headers->emplace_back(chunk.header());
+		buffers.emplace_back(boost::asio::buffer(headers->back()));
+		buffers.emplace_back(boost::asio::buffer(chunk.chunk, chunk.size));
+	}
+
+	write_buffers(headers, buffers, true);
+}
+
+void LoginSession::defer_chunks(std::chrono::milliseconds delay) {
+	LOG_TRACE_FILTER(logger_, LF_NETWORK) << __func__ << LOG_ASYNC;
+
+	auto self(shared_from_this());
+
+	transfer_timer_.expires_from_now(delay);
+	transfer_timer_.async_wait(strand().wrap([this, self](const boost::system::error_code& ec) {
+		if(!ec) {
+			handler_.on_chunk_complete();
+		}
+	}));
+}
+
 void LoginSession::on_write_complete() {
 	handler_.on_chunk_complete();
 }
@@ -15,7 +15,11 @@
 #include <spark/Buffer.h>
 #include <logger/Logging.h>
 #include <shared/threading/ThreadPool.h>
+#include <boost/asio.hpp>
+#include <chrono>
 #include <memory>
+#include <vector>
+#include <cstddef>
 
 namespace ember {
 
@@ -23,18 +27,27 @@ class LoginHandlerBuilder;
 class ThreadPool;
 
 class LoginSession final : public NetworkSession {
+	// data held back while the handler waits on an action - a client has no reason to send much
+	static const std::size_t MAX_PIPELINED_BYTES = 4096;
+
 	void async_completion(std::shared_ptr<Action> action);
+	boost::asio::basic_waitable_timer<std::chrono::steady_clock> transfer_timer_;
+
 	void write_chain(const grunt::Packet& packet, bool notify);
+	void write_chunks(const std::vector<grunt::server::TransferData>& chunks);
+	void defer_chunks(std::chrono::milliseconds delay);
 	void execute_async(std::shared_ptr<Action> action);
 
 public:
 	ThreadPool& pool_;
+	ThreadPool& crypto_pool_;
 	LoginHandler handler_;
 	log::Logger* logger_;
 	grunt::Handler grunt_handler_;
 
 	LoginSession(SessionManager& sessions, boost::asio::ip::tcp::socket socket,
-	             log::Logger* logger, ThreadPool& pool, const LoginHandlerBuilder& builder);
+	             log::Logger* logger, ThreadPool& pool, ThreadPool& crypto_pool,
+	             const LoginHandlerBuilder& builder);
 
 	bool handle_packet(spark::Buffer& buffer) override;
 	void on_write_complete() override;
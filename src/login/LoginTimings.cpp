@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2016 Ember
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "LoginTimings.h"
+#include <sstream>
+
+namespace ember {
+
+namespace {
+
+const char* const phase_names[] = {
+	"await_challenge", "fetch_user", "compute_challenge", "await_proof", "compute_proof",
+	"fetch_session", "await_reconnect_proof", "write_session", "fetch_characters",
+	"queued", "database", "spark", "crypto", "resume", "handler",
+	"total"
+};
+
+static_assert(sizeof(phase_names) / sizeof(phase_names[0]) == LoginTimings::PHASES,
+              "Missing login phase names");
+
+} // unnamed
+
+LoginTimings::LoginTimings(std::chrono::milliseconds slow_threshold)
+                           : slow_threshold_(slow_threshold), next_slow_log_(0) {
+	for(std::size_t i = 0; i < PHASES; ++i) {
+		const std::string prefix = std::string("login_timing.") + phase_names[i];
+		keys_[i] = { prefix + ".count", prefix + ".p50_us", prefix + ".p99_us", prefix + ".max_us" };
+	}
+}
+
+bool LoginTimings::record(const Sample& sample) {
+	for(std::size_t i = 0; i < PHASES; ++i) {
+		const auto phase = static_cast<Phase>(i);
+
+		if(sample.recorded(phase)) {
+			histograms_[i].record(sample[phase]);
+		}
+	}
+
+	if(!slow_threshold_.count() || sample[Phase::TOTAL] < slow_threshold_) {
+		return false;
+	}
+
+	// only one slow login is logged a second, a backlog would otherwise flood the log
+	const auto now = Clock::now().time_since_epoch().count();
+	auto next = next_slow_log_.load();
+	const auto interval = std::chrono::duration_cast<Clock::duration>(std::chrono::seconds(1)).count();
+	return now >= next && next_slow_log_.compare_exchange_strong(next, now + interval);
+}
+
+void LoginTimings::report(Metrics& metrics) {
+	for(std::size_t i = 0; i < PHASES; ++i) {
+		const auto snapshot = histograms_[i].reset();
+
+		if(!snapshot.count) {
+			continue;
+		}
+
+		const auto& keys = keys_[i];
+		metrics.increment(keys.count.c_str(), snapshot.count);
+		metrics.gauge(keys.p50.c_str(), snapshot.percentile(50).count());
+		metrics.gauge(keys.p99.c_str(), snapshot.percentile(99).count());
+		metrics.gauge(keys.max.c_str(), snapshot.max);
+	}
+}
+
+const char* LoginTimings::name(Phase phase) {
+	return phase_names[static_cast<std::size_t>(phase)];
+}
+
+std::string LoginTimings::describe(const Sample& sample) {
+	std::stringstream format;
+	bool first = true;
+
+	for(std::size_t i = 0; i < PHASES; ++i) {
+		const auto phase = static_cast<Phase>(i);
+
+		if(!sample.recorded(phase)) {
+			continue;
+		}
+
+		const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(sample[phase]);
+		format << (first? "" : ", ") << name(phase) << ": " << elapsed.count() << "us";
+		first = false;
+	}
+
+	return format.str();
+}
+
+} // ember
\ No newline at end of file
@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2016 Ember
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include <shared/metrics/Histogram.h>
+#include <shared/metrics/Metrics.h>
+#include <array>
+#include <atomic>
+#include <bitset>
+#include <chrono>
+#include <string>
+#include <cstddef>
+
+namespace ember {
+
+/*
+ * Aggregates where the time goes during login handshakes, shared between
+ * all handlers. The wait phases follow the handler's states while the
+ * breakdown phases total up every action's time spent queued for a worker,
+ * in the DAO, waiting on Spark, in SRP6 and queued to resume on the strand.
+ */
+class LoginTimings final {
+public:
+	typedef std::chrono::steady_clock Clock;
+
+	enum class Phase {
+		// states
+		AWAIT_CHALLENGE, FETCH_USER, COMPUTE_CHALLENGE, AWAIT_PROOF, COMPUTE_PROOF,
+		FETCH_SESSION, AWAIT_RECONNECT_PROOF, WRITE_SESSION, FETCH_CHARACTERS,
+
+		// breakdown
+		QUEUED, DATABASE, SPARK, CRYPTO, RESUME, HANDLER,
+
+		TOTAL, MAX
+	};
+
+	static const std::size_t PHASES = static_cast<std::size_t>(Phase::MAX);
+
+	class Sample {
+		std::array<Clock::duration, PHASES> phases_{};
+		std::bitset<PHASES> recorded_;
+
+	public:
+		void add(Phase phase, Clock::duration duration) {
+			const auto index = static_cast<std::size_t>(phase);
+			phases_[index] += duration;
+			recorded_.set(index);
+		}
+
+		bool recorded(Phase phase) const {
+			return recorded_.test(static_cast<std::size_t>(phase));
+		}
+
+		Clock::duration operator[](Phase phase) const {
+			return phases_[static_cast<std::size_t>(phase)];
+		}
+	};
+
+private:
+	struct Keys {
+		std::string count, p50, p99, max;
+	};
+
+	const std::chrono::milliseconds slow_threshold_;
+	std::array<Histogram, PHASES> histograms_;
+	std::array<Keys, PHASES> keys_;
+	std::atomic<Clock::rep> next_slow_log_;
+
+public:
+	explicit LoginTimings(std::chrono::milliseconds slow_threshold);
+
+	// returns true if the login was slow and should be logged, at most once a second
+	bool record(const Sample& sample);
+
+	void report(Metrics& metrics);
+
+	static const char* name(Phase phase);
+	static std::string describe(const Sample& sample);
+};
+
+} // ember
\ No newline at end of file
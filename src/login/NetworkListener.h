@@ -12,59 +12,86 @@
 #include "SessionBuilders.h"
 #include "SessionManager.h"
 #include "FilterTypes.h"
+#include "RateLimiter.h"
 #include <logger/Logger.h>
 #include <shared/IPBanCache.h>
 #include <shared/memory/ASIOAllocator.h>
 #include <shared/metrics/Metrics.h>
+#include <shared/threading/ServicePool.h>
 #include <boost/asio.hpp>
+#include <memory>
+#include <stdexcept>
 #include <string>
 #include <utility>
+#include <vector>
 #include <cstdint>
 #include <cstddef>
 
 namespace ember {
 
+/*
+ * Listens with a single acceptor on the shared service by default. Given a
+ * service pool, it instead opens one SO_REUSEPORT acceptor per pooled service
+ * and leaves the kernel to spread new connections between them, so accepting
+ * and setting up a session stays on the thread that will run it.
+ */
 class NetworkListener {
+	struct Acceptor {
+		boost::asio::ip::tcp::acceptor acceptor;
+		boost::asio::ip::tcp::socket socket;
+
+		explicit Acceptor(boost::asio::io_service& service) : acceptor(service), socket(service) { }
+	};
+
 	boost::asio::io_service& service_;
 	boost::asio::signal_set signals_;
-	boost::asio::ip::tcp::acceptor acceptor_;
-	boost::asio::ip::tcp::socket socket_;
+	std::vector<std::unique_ptr<Acceptor>> acceptors_;
 
 	const NetworkSessionBuilder& session_create_;
 	SessionManager sessions_;
 	log::Logger* logger_;
 	Metrics& metrics_;
 	IPBanCache& ban_list_;
+	RateLimiter& ip_limiter_;
+	const std::size_t v4_prefix_;
+	const std::size_t v6_prefix_;
 	ASIOAllocator allocator_; // todo - thread_local, VS2015
 
-	void accept_connection() {
+	void accept_connection(Acceptor& acceptor) {
 		LOG_TRACE_FILTER(logger_, LF_NETWORK) << __func__ << LOG_ASYNC;
 
-		acceptor_.async_accept(socket_, [this](boost::system::error_code ec) {
-			if(!acceptor_.is_open()) {
+		acceptor.acceptor.async_accept(acceptor.socket, [this, &acceptor](boost::system::error_code ec) {
+			if(!acceptor.acceptor.is_open()) {
 				return;
 			}
 
 			if(!ec) {
-				auto ip = socket_.remote_endpoint().address();
+				auto& socket = acceptor.socket;
+				auto ip = socket.remote_endpoint().address();
 
 				if(ban_list_.is_banned(ip)) {
 					LOG_DEBUG_FILTER(logger_, LF_NETWORK)
 						<< "Rejected connection " << ip.to_string()
 						<< " from banned IP range" << LOG_ASYNC;
 					metrics_.increment("rejected_connections");
-					return;
-				}
-
-				LOG_DEBUG_FILTER(logger_, LF_NETWORK)
-					<< "Accepted connection " << ip.to_string() << ":"
-					<< socket_.remote_endpoint().port() << LOG_ASYNC;
-				metrics_.increment("accepted_connections");
+					socket.close();
+				} else if(!ip_limiter_.admit(address_key(ip, v4_prefix_, v6_prefix_))) {
+					// shed before a session exists so no handler, crypto or database work is spent
+					LOG_DEBUG_FILTER(logger_, LF_NETWORK)
+						<< "Shed connection " << ip.to_string()
+						<< ", rate limit exceeded" << LOG_ASYNC;
+					socket.close();
+				} else {
+					LOG_DEBUG_FILTER(logger_, LF_NETWORK)
+						<< "Accepted connection " << ip.to_string() << ":"
+						<< socket.remote_endpoint().port() << LOG_ASYNC;
+					metrics_.increment("accepted_connections");
 
-				start_session(std::move(socket_));
+					start_session(std::move(socket));
+				}
 			}
 
-			accept_connection();
+			accept_connection(acceptor);
 		});
 	}
 
@@ -74,27 +101,70 @@ class NetworkListener {
 		sessions_.start(session);
 	}
 
+	static void open(boost::asio::ip::tcp::acceptor& acceptor, const boost::asio::ip::tcp::endpoint& endpoint,
+	                 bool tcp_no_delay, bool reuse_port) {
+		acceptor.open(endpoint.protocol());
+		acceptor.set_option(boost::asio::ip::tcp::no_delay(tcp_no_delay));
+		acceptor.set_option(boost::asio::ip::tcp::acceptor::reuse_address(true));
+
+		if(reuse_port) {
+#ifdef SO_REUSEPORT
+			typedef boost::asio::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT> reuse_port_opt;
+			acceptor.set_option(reuse_port_opt(true));
+#else
+			throw std::runtime_error("SO_REUSEPORT is not supported on this platform");
+#endif
+		}
+
+		acceptor.bind(endpoint);
+		acceptor.listen();
+	}
+
 public:
-	NetworkListener(boost::asio::io_service& service, const std::string& interface, std::uint16_t port,
+	NetworkListener(boost::asio::io_service& service, ServicePool* accept_pool,
+	                const std::string& interface, std::uint16_t port,
 	                bool tcp_no_delay, const NetworkSessionBuilder& session_create, IPBanCache& bans,
+	                RateLimiter& ip_limiter, std::size_t v4_prefix, std::size_t v6_prefix,
 	                log::Logger* logger, Metrics& metrics)
-	                : acceptor_(service_, boost::asio::ip::tcp::endpoint(
-	                            boost::asio::ip::address::from_string(interface), port)),
-	                  service_(service), socket_(service_), logger_(logger), ban_list_(bans),
+	                : service_(service), logger_(logger), ban_list_(bans),
+	                  ip_limiter_(ip_limiter), v4_prefix_(v4_prefix), v6_prefix_(v6_prefix),
 	                  signals_(service_, SIGINT, SIGTERM), session_create_(session_create),
 	                  metrics_(metrics) {
-		acceptor_.set_option(boost::asio::ip::tcp::no_delay(tcp_no_delay));
-		acceptor_.set_option(boost::asio::ip::tcp::acceptor::reuse_address(true));
+		const boost::asio::ip::tcp::endpoint endpoint(boost::asio::ip::address::from_string(interface), port);
+
+		if(accept_pool) {
+			for(std::size_t i = 0; i < accept_pool->size(); ++i) {
+				acceptors_.emplace_back(std::make_unique<Acceptor>(*accept_pool->get_service(i)));
+				open(acceptors_.back()->acceptor, endpoint, tcp_no_delay, true);
+			}
+		} else {
+			acceptors_.emplace_back(std::make_unique<Acceptor>(service_));
+			open(acceptors_.back()->acceptor, endpoint, tcp_no_delay, false);
+		}
+
 		signals_.async_wait([this](auto& error, auto signal) { shutdown(); });
-		accept_connection();
+
+		for(auto& acceptor : acceptors_) {
+			accept_connection(*acceptor);
+		}
 	}
 
 	void shutdown() {
 		LOG_TRACE_FILTER(logger_, LF_NETWORK) << __func__ << LOG_ASYNC;
-		acceptor_.close();
+
+		// each acceptor is closed by the thread running its service
+		for(auto& acceptor : acceptors_) {
+			auto& handle = acceptor->acceptor;
+			handle.get_io_service().post([&handle] { handle.close(); });
+		}
+
 		sessions_.stop_all();
 	}
 
+	std::size_t acceptor_count() const {
+		return acceptors_.size();
+	}
+
 	std::size_t connection_count() const {
 		return sessions_.count();
 	}
@@ -20,6 +20,7 @@
 #include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 #include <cstdint>
 
 namespace ember {
@@ -161,8 +162,42 @@ public:
 		)));
 	}
 
+	// sends the buffers without copying them - owner must keep everything they point to alive
+	void write_buffers(std::shared_ptr<const void> owner,
+	                   const std::vector<boost::asio::const_buffer>& buffers, bool notify) {
+		auto self(shared_from_this());
+
+		if(!socket_.is_open()) {
+			return;
+		}
+
+		set_timer();
+
+		boost::asio::async_write(socket_, buffers,
+			strand_.wrap(create_alloc_handler(allocator_,
+			[this, self, owner, notify](boost::system::error_code ec, std::size_t) {
+				if(ec && ec != boost::asio::error::operation_aborted) {
+					close_session();
+				} else if(!ec && notify) {
+					on_write_complete();
+				}
+			}
+		)));
+	}
+
 	boost::asio::strand& strand() { return strand_;  }
 
+	// hands data that handle_packet left in the inbound buffer back to it, must be called on the strand
+	void process_buffered() {
+		if(stopped_ || inbound_buffer_.empty()) {
+			return;
+		}
+
+		if(!handle_packet(inbound_buffer_)) {
+			close_session();
+		}
+	}
+
 	virtual bool handle_packet(spark::Buffer& buffer) = 0;
 	virtual void on_write_complete() = 0;
 	virtual ~NetworkSession() = default;
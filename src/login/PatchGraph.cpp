@@ -10,7 +10,7 @@
 #include <boost/optional.hpp>
 #include <algorithm>
 #include <queue>
-#include <set>
+#include <unordered_set>
 
 namespace ember {
 
@@ -30,29 +30,26 @@ void PatchGraph::build_graph(const std::vector<PatchMeta>& patches) {
 	}
 }
 
-bool PatchGraph::edge_test(const std::vector<Edge>& edges, std::uint16_t to) const {
-	for(auto& e : edges) {
-		if(e.build_to == to) {
-			return true;
+bool PatchGraph::is_path(std::uint16_t from, std::uint16_t to) const {
+	std::unordered_set<std::uint16_t> visited;
+	std::vector<std::uint16_t> pending { from };
+
+	// each build is only expanded once, regardless of how many routes lead to it
+	while(!pending.empty()) {
+		auto it = adjacency_.find(pending.back());
+		pending.pop_back();
+
+		if(it == adjacency_.end()) {
+			continue;
 		}
-		
-		auto it = adjacency_.find(e.build_to);
 
-		if(it != adjacency_.end()) {
-			if(edge_test(it->second, to)) {
+		for(auto& e : it->second) {
+			if(e.build_to == to) {
 				return true;
 			}
-		}
-	}
-
-	return false;
-}
 
-bool PatchGraph::is_path(std::uint16_t from, std::uint16_t to) const {
-	for(auto& entry : adjacency_) {
-		if(entry.first == from) {
-			if(edge_test(entry.second, to)) {
-				return true;
+			if(visited.insert(e.build_to).second) {
+				pending.emplace_back(e.build_to);
 			}
 		}
 	}
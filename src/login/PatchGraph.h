@@ -26,7 +26,6 @@ class PatchGraph {
 	std::unordered_map<std::uint16_t, std::vector<Edge>> adjacency_;
 
 	void build_graph(const std::vector<PatchMeta>& patches);
-	bool edge_test(const std::vector<Edge>& edges, std::uint16_t to) const;
 
 public:
 	struct Node {
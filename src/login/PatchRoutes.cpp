@@ -0,0 +1,205 @@
+/*
+ * Copyright (c) 2016 Ember
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "PatchRoutes.h"
+#include <shared/util/FNVHash.h>
+#include <algorithm>
+#include <iterator>
+#include <set>
+
+namespace ember {
+
+PatchRoutes::PatchRoutes(std::vector<GameVersion> versions, const std::vector<PatchMeta>& patches)
+                         : versions_(std::move(versions)) {
+	std::unordered_map<std::size_t, std::vector<PatchMeta>> bins;
+
+	for(auto& patch : patches) {
+		bins[hash(patch.locale, patch.arch, patch.os)].emplace_back(patch);
+	}
+
+	for(auto& bin : bins) {
+		build_bin(bin.first, bin.second);
+	}
+}
+
+void PatchRoutes::build_bin(std::size_t bin, const std::vector<PatchMeta>& patches) {
+	const PatchGraph graph(patches);
+	std::set<std::uint16_t> builds, rollups;
+
+	for(auto& patch : patches) {
+		builds.insert(patch.build_from);
+
+		if(patch.rollup) {
+			rollups.insert(patch.build_from);
+		}
+	}
+
+	// builds that have a patch path to a supported version
+	for(auto build : builds) {
+		for(auto& version : versions_) {
+			if(graph.is_path(build, version.build)) {
+				routes_[hash(bin, build)] = route_from(graph, patches, build);
+				break;
+			}
+		}
+	}
+
+	// everything else has to start from the best eligible rollup
+	auto& thresholds = rollups_[bin];
+
+	for(auto build : rollups) {
+		thresholds.emplace_back(build, route_rollup(graph, patches, build));
+	}
+}
+
+boost::optional<PatchRoutes::Route> PatchRoutes::route_rollup(const PatchGraph& graph,
+                                                              const std::vector<PatchMeta>& patches,
+                                                              std::uint16_t build) const {
+	for(auto& version : versions_) {
+		auto meta = locate_rollup(patches, build, version.build);
+
+		// check to see whether there's a patch path from this rollup
+		if(meta && graph.is_path(meta->build_from, version.build)) {
+			return route_from(graph, patches, meta->build_from);
+		}
+	}
+
+	return boost::none;
+}
+
+// using the optimal patching path, locate the next patch file
+boost::optional<PatchRoutes::Route> PatchRoutes::route_from(const PatchGraph& graph,
+                                                            const std::vector<PatchMeta>& patches,
+                                                            std::uint16_t build) const {
+	for(auto& version : versions_) {
+		auto path = graph.path(build, version.build);
+
+		if(path.empty()) {
+			continue;
+		}
+
+		std::vector<std::uint16_t> hops;
+
+		for(auto& node : path) {
+			hops.emplace_back(node.from);
+		}
+
+		hops.emplace_back(version.build);
+
+		// smallest patch for each hop, as chosen by the graph search
+		const PatchMeta* next = nullptr;
+		std::uint64_t cost = 0;
+
+		for(std::size_t i = 0; i + 1 < hops.size(); ++i) {
+			const PatchMeta* hop = nullptr;
+
+			for(auto& patch : patches) {
+				if(patch.build_from == hops[i] && patch.build_to == hops[i + 1]
+				   && (!hop || patch.file_meta.size < hop->file_meta.size)) {
+					hop = &patch;
+				}
+			}
+
+			if(!hop) {
+				break;
+			}
+
+			if(i == 0) {
+				next = hop;
+			}
+
+			cost += hop->file_meta.size;
+		}
+
+		if(next) {
+			return Route { build, version.build, hops.size() - 1, cost, *next };
+		}
+	}
+
+	return boost::none;
+}
+
+const PatchMeta* PatchRoutes::locate_rollup(const std::vector<PatchMeta>& patches,
+                                            std::uint16_t from, std::uint16_t to) {
+	const PatchMeta* meta = nullptr;
+
+	for(auto& patch : patches) {
+		if(!patch.rollup) {
+			continue;
+		}
+
+		// rollup build must be <= the client build and <= the server build
+		if(patch.build_from <= from && patch.build_to <= to) {
+			if(meta == nullptr) {
+				meta = &patch;
+			} else if(meta->file_meta.size >= patch.file_meta.size) {
+				meta = &patch; // go for the smaller file
+			}
+		}
+	}
+
+	return meta;
+}
+
+boost::optional<PatchMeta> PatchRoutes::find(std::uint16_t build, grunt::Locale locale,
+                                             grunt::Platform platform, grunt::System os) const {
+	const auto bin = hash(grunt::to_string(locale), grunt::to_string(platform), grunt::to_string(os));
+	auto route = routes_.find(hash(bin, build));
+
+	if(route != routes_.end()) {
+		return route->second? route->second->patch : boost::optional<PatchMeta>();
+	}
+
+	auto rollups = rollups_.find(bin);
+
+	if(rollups == rollups_.end()) {
+		return boost::none;
+	}
+
+	// find the last threshold at or below the client's build
+	auto& thresholds = rollups->second;
+
+	auto it = std::upper_bound(thresholds.begin(), thresholds.end(), build,
+		[](std::uint16_t build, const Thresholds::value_type& threshold) {
+			return build < threshold.first;
+		});
+
+	if(it == thresholds.begin() || !std::prev(it)->second) {
+		return boost::none;
+	}
+
+	return std::prev(it)->second->patch;
+}
+
+auto PatchRoutes::routes() const -> std::vector<Route> {
+	std::vector<Route> routes;
+
+	for(auto& route : routes_) {
+		if(route.second) {
+			routes.emplace_back(*route.second);
+		}
+	}
+
+	return routes;
+}
+
+std::size_t PatchRoutes::hash(const std::string& locale, const std::string& platform,
+                              const std::string& os) {
+	FNVHash hasher;
+	hasher.update(locale);
+	hasher.update(platform);
+	return hasher.update(os);
+}
+
+std::size_t PatchRoutes::hash(std::size_t bin, std::uint16_t build) {
+	FNVHash hasher;
+	hasher.update(bin);
+	return hasher.update(build);
+}
+
+} // ember
\ No newline at end of file
@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2016 Ember
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include "GameVersion.h"
+#include "PatchGraph.h"
+#include "grunt/Magic.h"
+#include <shared/database/objects/PatchMeta.h>
+#include <boost/optional.hpp>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace ember {
+
+/*
+ * Every patch routing decision depends only on the client's build, locale,
+ * platform and OS, so they're all made up front when the patches are loaded
+ * rather than searching the patch graph for each client that logs in.
+ *
+ * Builds with a patch path to a supported version are stored directly. Every
+ * other build can only be served by a rollup patch and which rollups are
+ * eligible only changes at each rollup's starting build, so those are stored
+ * as a sorted list of thresholds per locale/platform/OS.
+ */
+class PatchRoutes {
+public:
+	struct Route {
+		std::uint16_t from;
+		std::uint16_t to;
+		std::size_t hops;
+		std::uint64_t cost; // total bytes the client will download along the route
+		PatchMeta patch;    // next patch to send
+	};
+
+private:
+	typedef std::vector<std::pair<std::uint16_t, boost::optional<Route>>> Thresholds;
+
+	const std::vector<GameVersion> versions_;
+	std::unordered_map<std::size_t, boost::optional<Route>> routes_;
+	std::unordered_map<std::size_t, Thresholds> rollups_;
+
+	boost::optional<Route> route_from(const PatchGraph& graph, const std::vector<PatchMeta>& patches,
+	                                  std::uint16_t build) const;
+	boost::optional<Route> route_rollup(const PatchGraph& graph, const std::vector<PatchMeta>& patches,
+	                                    std::uint16_t build) const;
+	void build_bin(std::size_t bin, const std::vector<PatchMeta>& patches);
+
+	static const PatchMeta* locate_rollup(const std::vector<PatchMeta>& patches,
+	                                      std::uint16_t from, std::uint16_t to);
+	static std::size_t hash(const std::string& locale, const std::string& platform,
+	                        const std::string& os);
+	static std::size_t hash(std::size_t bin, std::uint16_t build);
+
+public:
+	PatchRoutes(std::vector<GameVersion> versions, const std::vector<PatchMeta>& patches);
+
+	boost::optional<PatchMeta> find(std::uint16_t build, grunt::Locale locale,
+	                                grunt::Platform platform, grunt::System os) const;
+	std::vector<Route> routes() const;
+};
+
+} // ember
\ No newline at end of file
@@ -7,125 +7,69 @@
  */
 
 #include "Patcher.h"
-#include "PatchGraph.h"
-#include <shared/util/FileMD5.h>
-#include <shared/util/FNVHash.h>
+#include "DigestCache.h"
+#include <boost/filesystem.hpp>
 #include <boost/endian/conversion.hpp>
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <exception>
 #include <fstream>
+#include <thread>
 
-namespace ember {
-
-Patcher::Patcher(std::vector<GameVersion> versions, std::vector<PatchMeta> patches)
-                 : versions_(std::move(versions)), patches_(std::move(patches)),
-                   survey_id_(0) {
-	FNVHash hasher;
-
-	for(auto& patch : patches_) {
-		hasher.update(patch.locale);
-		hasher.update(patch.arch);
-		hasher.update(patch.os);
-		auto hash = hasher.finalise();
-		patch_bins[hash].emplace_back(patch);
-	}
+namespace bfs = boost::filesystem;
 
-	for(auto& bin : patch_bins) {
-		graphs_.emplace(bin.first, PatchGraph(bin.second));
-	}
-}
+namespace ember {
 
-const PatchMeta* Patcher::locate_rollup(const std::vector<PatchMeta>& patches,
-                                        std::uint16_t from, std::uint16_t to) const {
-	const PatchMeta* meta = nullptr;
+namespace {
 
-	for(auto& patch : patches) {
-		if(!patch.rollup) {
-			continue;
-		}
+const char* const DIGEST_CACHE = "md5.cache";
 
-		// rollup build must be <= the client build and <= the server build
-		if(patch.build_from <= from && patch.build_to <= to) {
-			if(meta == nullptr) {
-				meta = &patch;
-			} else if(meta->file_meta.size >= patch.file_meta.size) {
-				meta = &patch; // go for the smaller file
-			}
-		}
-	}
+} // unnamed
 
-	return meta;
+Patcher::Patcher(std::vector<GameVersion> versions, const std::vector<PatchMeta>& patches)
+                 : versions_(std::move(versions)), survey_id_(0) {
+	reload(patches);
 }
 
 boost::optional<PatchMeta> Patcher::find_patch(const GameVersion& client_version, grunt::Locale locale,
                                                grunt::Platform platform, grunt::System os) const {
-	FNVHash hasher;
-	hasher.update(grunt::to_string(locale));
-	hasher.update(grunt::to_string(platform));
-	auto hash = hasher.update(grunt::to_string(os));
-
-	auto g_it = graphs_.find(hash);
-	auto p_it = patch_bins.find(hash);
-	
-	if(g_it == graphs_.end() || p_it == patch_bins.end()) {
-		return boost::none;
-	}
-
-	auto build = client_version.build;
-	bool path = false;
-
-	// ensure there's a patch path from the client version to a supported version
-	for(auto& version : versions_) {
-		if(g_it->second.is_path(build, version.build)) {
-			path = true;
-			break;
-		}
-	}
-
-	// couldn't find a patch path, find the best rollup patch that'll cover the client
-	if(!path) {
-		const PatchMeta* meta = nullptr;
+	return routes()->find(client_version.build, locale, platform, os);
+}
 
-		for(auto& version : versions_) {
-			meta = locate_rollup(p_it->second, client_version.build, version.build);
+// sessions already holding the old routes are unaffected by the swap
+void Patcher::reload(const std::vector<PatchMeta>& patches) {
+	auto routes = std::make_shared<const PatchRoutes>(versions_, patches);
 
-			// check to see whether there's a patch path from this rollup
-			if(meta && g_it->second.is_path(meta->build_from, version.build)) {
-				build = meta->build_from;
-				path = true;
-				break;
-			}
-		}
+	std::lock_guard<std::mutex> guard(lock_);
+	routes_ = std::move(routes);
+	files_.clear();
+}
 
-		// still no path? Guess we're out of luck.
-		if(!path) {
-			return boost::none;
-		}
-	}
+std::shared_ptr<const PatchRoutes> Patcher::routes() const {
+	std::lock_guard<std::mutex> guard(lock_);
+	return routes_;
+}
 
-	// using the optimal patching path, locate the next patch file
-	for(auto& version : versions_) {
-		auto paths = g_it->second.path(build, version.build);
-		
-		if(paths.empty()) {
-			continue;
-		}
-		
-		auto build_to = version.build;
-		auto build_from = paths.front().from;
-		paths.pop_front();
+/*
+ * Each patch file is mapped once and shared by every session transferring it.
+ * The mapping stays alive until the last session using it has finished, even
+ * if the patches are reloaded in the meantime.
+ */
+std::shared_ptr<const BinaryView> Patcher::patch_file(const FileMeta& meta) const {
+	const auto path = meta.path + meta.name;
 
-		if(!paths.empty()) {
-			build_to = paths.front().from;
-		}
+	std::lock_guard<std::mutex> guard(lock_);
+	auto it = files_.find(path);
 
-		for(auto& patch : p_it->second) {
-			if(patch.build_from == build_from && patch.build_to == build_to) {
-				return patch;
-			}
-		}
+	if(it != files_.end()) {
+		return it->second;
 	}
 
-	return boost::none;
+	auto file = std::make_shared<BinaryView>();
+	file->map(path, BinaryView::Advice::WILL_NEED);
+	files_.emplace(path, file);
+	return file;
 }
 
 auto Patcher::check_version(const GameVersion& client_version) const -> PatchLevel {
@@ -144,29 +88,23 @@ auto Patcher::check_version(const GameVersion& client_version) const -> PatchLev
 	return PatchLevel::TOO_NEW;
 }
 
-void Patcher::set_survey(const std::string& path, std::uint32_t id) {
+void Patcher::set_survey(const std::string& path, std::uint32_t id, log::Logger* logger) {
 	survey_.name = "Survey";
 	survey_id_ = id;
-	
-	std::ifstream file(path + "Survey.mpq", std::ios::binary | std::ios::ate);
-
-	if(!file.is_open()) {
-		throw std::runtime_error("Unable to open " + path + "Survey.mpq");
-	}
 
-	survey_.size = file.tellg();
-	file.seekg(0, std::ios::beg);
+	const auto file = path + "Survey.mpq";
+	DigestCache cache(path + DIGEST_CACHE);
+	const auto md5 = cache.digest(file);
 
-	std::vector<char> buffer(static_cast<std::size_t>(survey_.size));
-	file.read(buffer.data(), survey_.size);
+	survey_data_.map(file, BinaryView::Advice::WILL_NEED);
+	survey_.size = survey_data_.size();
+	survey_.md5 = md5;
 
-	if(!file.good()) {
-		throw std::runtime_error("An error occured while reading " + path + "Survey.mpq");
+	try {
+		cache.save();
+	} catch(const std::exception& e) {
+		LOG_WARN(logger) << e.what() << LOG_SYNC; // not fatal, we'll just hash again next time
 	}
-
-	auto md5 = util::generate_md5(buffer.data(), buffer.size());
-	std::copy(md5.begin(), md5.end(), survey_.md5.data());
-	survey_data_ = std::move(buffer);
 }
 
 FileMeta Patcher::survey_meta() const {
@@ -182,12 +120,13 @@ bool Patcher::survey_platform(grunt::Platform platform, grunt::System os) const
 }
 
 // todo, change how this works
-const std::vector<char>& Patcher::survey_data(grunt::Platform platform, grunt::System os) const {
+const char* Patcher::survey_data(grunt::Platform platform, grunt::System os) const {
 	if(!survey_platform(platform, os)) {
 		throw std::invalid_argument("Attempted to retrieve survey binaries for an unsupported platform!");
 	}
 
-	return survey_data_;
+	auto& segments = survey_data_.segments();
+	return segments.empty()? nullptr : reinterpret_cast<const char*>(segments.front().data);
 }
 
 std::uint32_t Patcher::survey_id() const {
@@ -196,47 +135,88 @@ std::uint32_t Patcher::survey_id() const {
 
 std::vector<PatchMeta> Patcher::load_patches(const std::string& path, const dal::PatchDAO& dao,
                                              log::Logger* logger) {
+	const auto start = std::chrono::steady_clock::now();
 	auto patches = dao.fetch_patches();
 
 	for(auto& patch : patches) {
-		bool dirty = false;
 		patch.file_meta.path = path;
 
 		// we open each patch to make sure that it at least exists
-		std::ifstream file(path + patch.file_meta.name, std::ios::binary | std::ios::ate);
+		std::ifstream file(path + patch.file_meta.name, std::ios::binary);
 
 		if(!file.is_open()) {
 			throw std::runtime_error("Unable to open patch " + path + patch.file_meta.name);
 		}
+	}
 
-		if(patch.file_meta.size == 0) {
-			patch.file_meta.size = static_cast<std::uint64_t>(file.tellg());
-
-			if(!file.good()) {
-				throw std::runtime_error("Unable determine patch size for " + path + patch.file_meta.name);
+	/*
+	 * Hash the patches across all cores, reusing digests from the last run
+	 * for any files that haven't changed since. The database is only updated
+	 * for patches whose size or MD5 turned out to be different.
+	 */
+	DigestCache cache(path + DIGEST_CACHE);
+	std::vector<char> dirty(patches.size());
+	std::vector<std::exception_ptr> errors(patches.size());
+	std::atomic<std::size_t> next { 0 };
+
+	auto hash_patches = [&] {
+		for(auto i = next++; i < patches.size(); i = next++) {
+			auto& meta = patches[i].file_meta;
+
+			try {
+				const auto size = static_cast<std::uint64_t>(bfs::file_size(path + meta.name));
+				const auto md5 = cache.digest(path + meta.name);
+
+				if(meta.size != size || meta.md5 != md5) {
+					meta.size = size;
+					meta.md5 = md5;
+					dirty[i] = true;
+				}
+			} catch(const std::exception&) {
+				errors[i] = std::current_exception();
 			}
-
-			dirty = true;
 		}
+	};
 
-		int value = 0;
+	const auto threads = std::min<std::size_t>(std::max(std::thread::hardware_concurrency(), 1u),
+	                                           patches.size());
+	std::vector<std::thread> workers;
 
-		for(auto c : patch.file_meta.md5) {
-			value |= c;
-		}
+	for(std::size_t i = 1; i < threads; ++i) {
+		workers.emplace_back(hash_patches);
+	}
+
+	hash_patches();
+
+	for(auto& worker : workers) {
+		worker.join();
+	}
 
-		if(!value) {
-			LOG_INFO(logger) << "Calculating MD5 for " << patch.file_meta.name << LOG_SYNC;
-			auto md5 = util::generate_md5(path + patch.file_meta.name);
-			std::copy(md5.begin(), md5.end(), patch.file_meta.md5.data());
-			dirty = true;
+	for(auto& error : errors) {
+		if(error) {
+			std::rethrow_exception(error);
 		}
+	}
 
-		if(dirty) {
-			dao.update(patch);
+	for(std::size_t i = 0; i < patches.size(); ++i) {
+		if(dirty[i]) {
+			LOG_INFO(logger) << "Updated MD5 for " << patches[i].file_meta.name << LOG_SYNC;
+			dao.update(patches[i]);
 		}
 	}
 
+	try {
+		cache.save();
+	} catch(const std::exception& e) {
+		LOG_WARN(logger) << e.what() << LOG_SYNC; // not fatal, we'll just hash again next time
+	}
+
+	const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+		std::chrono::steady_clock::now() - start);
+
+	LOG_INFO(logger) << "Loaded " << patches.size() << " patch(es) in " << elapsed.count()
+	                 << "ms, " << cache.hashed() << " hashed" << LOG_SYNC;
+
 	return patches;
 }
 
@@ -9,47 +9,50 @@
 #pragma once
 
 #include "GameVersion.h"
-#include "PatchGraph.h"
+#include "BinaryView.h"
+#include "PatchRoutes.h"
 #include "grunt/Magic.h"
 #include <shared/database/daos/PatchDAO.h>
 #include <shared/database/objects/PatchMeta.h>
 #include <logger/Logging.h>
 #include <boost/optional.hpp>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
 namespace ember {
 
 class Patcher {
-	const std::vector<PatchMeta> patches_;
 	const std::vector<GameVersion> versions_;
-	std::unordered_map<std::size_t, PatchGraph> graphs_;
-	std::unordered_map<std::size_t, std::vector<PatchMeta>> patch_bins;
+	std::shared_ptr<const PatchRoutes> routes_;
+	mutable std::unordered_map<std::string, std::shared_ptr<const BinaryView>> files_;
+	mutable std::mutex lock_;
 
 	FileMeta survey_;
-	std::vector<char> survey_data_;
+	BinaryView survey_data_;
 	std::uint32_t survey_id_;
 
-	const PatchMeta* locate_rollup(const std::vector<PatchMeta>& patches,
-	                               std::uint16_t from, std::uint16_t to) const;
-
 public:
 	enum class PatchLevel { OK, TOO_OLD, TOO_NEW };
 
-	Patcher(std::vector<GameVersion> versions, std::vector<PatchMeta> patches);
+	Patcher(std::vector<GameVersion> versions, const std::vector<PatchMeta>& patches);
 	
 	// Survey
-	void set_survey(const std::string& path, std::uint32_t id);
+	void set_survey(const std::string& path, std::uint32_t id, log::Logger* logger);
 	FileMeta survey_meta() const;
 	std::uint32_t survey_id() const;
 	bool survey_platform(grunt::Platform platform, grunt::System os) const;
-	const std::vector<char>& survey_data(grunt::Platform platform, grunt::System os) const;
+	const char* survey_data(grunt::Platform platform, grunt::System os) const;
 
 	// Patching
 	boost::optional<PatchMeta> find_patch(const GameVersion& client_version, grunt::Locale locale,
 	                                      grunt::Platform platform, grunt::System os) const;
 
 	PatchLevel check_version(const GameVersion& client_version) const;
+	void reload(const std::vector<PatchMeta>& patches);
+	std::shared_ptr<const PatchRoutes> routes() const;
+	std::shared_ptr<const BinaryView> patch_file(const FileMeta& meta) const;
 
 	static std::vector<PatchMeta> load_patches(const std::string& path, const dal::PatchDAO& dao,
 	                                           log::Logger* logger);
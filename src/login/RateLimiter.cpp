@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) 2016 Ember
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "RateLimiter.h"
+#include <algorithm>
+#include <functional>
+#include <random>
+
+namespace ember {
+
+namespace {
+
+std::size_t round_pow2(std::size_t value) {
+	std::size_t result = 1;
+
+	while(result < value) {
+		result <<= 1;
+	}
+
+	return result;
+}
+
+std::uint64_t random_seed() {
+	std::random_device rd;
+	return (static_cast<std::uint64_t>(rd()) << 32) | rd();
+}
+
+} // unnamed
+
+RateLimiter::RateLimiter(std::size_t slots, double rate, double burst)
+                         : rate_(rate), burst_(std::max(burst, 1.0)), seed_(random_seed()),
+                           mask_(0), admitted_(0), shed_(0), evicted_(0) {
+	if(!enabled()) {
+		return;
+	}
+
+	buckets_.resize(round_pow2(slots > STRIPES? slots : STRIPES), { 0, burst_, Clock::time_point() });
+	mask_ = buckets_.size() - 1;
+}
+
+// splitmix64 finaliser - spreads similar keys (adjacent addresses) across the table
+std::uint64_t RateLimiter::mix(std::uint64_t key) const {
+	key ^= seed_;
+	key = (key ^ (key >> 30)) * 0xBF58476D1CE4E5B9ull;
+	key = (key ^ (key >> 27)) * 0x94D049BB133111EBull;
+	return key ^ (key >> 31);
+}
+
+bool RateLimiter::admit(std::uint64_t key, Clock::time_point now) {
+	if(!enabled()) {
+		return true;
+	}
+
+	key = mix(key);
+	const std::size_t index = key & mask_;
+	Bucket& bucket = buckets_[index];
+
+	std::lock_guard<std::mutex> guard(stripes_[index % STRIPES].lock);
+
+	if(bucket.key != key) {
+		if(bucket.updated != Clock::time_point()) {
+			++evicted_;
+		}
+
+		bucket.key = key;
+		bucket.tokens = burst_;
+	} else {
+		const std::chrono::duration<double> elapsed = now - bucket.updated;
+		bucket.tokens = std::min(burst_, bucket.tokens + std::max(elapsed.count(), 0.0) * rate_);
+	}
+
+	bucket.updated = now;
+
+	if(bucket.tokens < 1.0) {
+		++shed_;
+		return false;
+	}
+
+	bucket.tokens -= 1.0;
+	++admitted_;
+	return true;
+}
+
+bool RateLimiter::admit(const std::string& key) {
+	return admit(std::hash<std::string>()(key));
+}
+
+RateLimiter::Counters RateLimiter::reset_counters() {
+	return { admitted_.exchange(0), shed_.exchange(0), evicted_.exchange(0) };
+}
+
+std::uint64_t address_key(const boost::asio::ip::address& address,
+                          std::size_t v4_prefix, std::size_t v6_prefix) {
+	if(address.is_v6() && !address.to_v6().is_v4_mapped()) {
+		auto bytes = address.to_v6().to_bytes();
+		std::uint64_t key = 0xCBF29CE484222325ull;
+
+		for(std::size_t i = 0; i < bytes.size(); ++i) {
+			const std::size_t bit = i * 8;
+			const std::size_t keep = v6_prefix > bit? std::min<std::size_t>(v6_prefix - bit, 8) : 0;
+			const auto masked = static_cast<std::uint8_t>(bytes[i] & (0xFF00 >> keep));
+			key = (key ^ masked) * 0x100000001B3ull; // FNV-1a
+		}
+
+		return key;
+	}
+
+	const auto v4 = address.is_v4()? address.to_v4() : address.to_v6().to_v4();
+	const std::uint64_t mask = v4_prefix? ~0ull << (32 - std::min<std::size_t>(v4_prefix, 32)) : 0;
+	return v4.to_ulong() & mask & 0xFFFFFFFF;
+}
+
+} // ember
\ No newline at end of file
@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2016 Ember
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include <boost/asio/ip/address.hpp>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace ember {
+
+/*
+ * Token bucket limiter over a fixed-size table of buckets, so memory use is
+ * set at startup no matter how many distinct keys an attacker cycles through.
+ * Keys are hashed with a per-process seed to pick a bucket - a key that lands
+ * on a bucket owned by another key takes it over with a full allowance, which
+ * trades a little precision under heavy churn for never growing the table.
+ *
+ * Buckets are guarded by a fixed set of striped locks rather than one lock
+ * per bucket or one for the whole table.
+ */
+class RateLimiter final {
+public:
+	typedef std::chrono::steady_clock Clock;
+
+	struct Counters {
+		std::uint64_t admitted;
+		std::uint64_t shed;
+		std::uint64_t evicted;
+	};
+
+private:
+	static const std::size_t STRIPES = 64;
+	static const std::size_t CACHELINE_SIZE = 64;
+
+	struct Bucket {
+		std::uint64_t key;
+		double tokens;
+		Clock::time_point updated;
+	};
+
+	struct alignas(CACHELINE_SIZE) Stripe {
+		std::mutex lock;
+	};
+
+	const double rate_;
+	const double burst_;
+	const std::uint64_t seed_;
+	std::vector<Bucket> buckets_;
+	std::size_t mask_;
+	std::array<Stripe, STRIPES> stripes_;
+	std::atomic<std::uint64_t> admitted_;
+	std::atomic<std::uint64_t> shed_;
+	std::atomic<std::uint64_t> evicted_;
+
+	std::uint64_t mix(std::uint64_t key) const;
+
+public:
+	// a rate of zero disables the limiter and every call to admit succeeds
+	RateLimiter(std::size_t slots, double rate, double burst);
+
+	bool admit(std::uint64_t key, Clock::time_point now = Clock::now());
+	bool admit(const std::string& key);
+
+	bool enabled() const {
+		return rate_ > 0;
+	}
+
+	Counters reset_counters();
+};
+
+/*
+ * Maps an address onto a limiter key, masked to the given prefix length so
+ * clients sharing a subnet share an allowance. IPv4-mapped IPv6 addresses
+ * are keyed as the IPv4 address they represent.
+ */
+std::uint64_t address_key(const boost::asio::ip::address& address,
+                          std::size_t v4_prefix, std::size_t v6_prefix);
+
+} // ember
\ No newline at end of file
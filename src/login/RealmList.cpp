@@ -7,11 +7,13 @@
  */
 
 #include "RealmList.h"
+#include <boost/range/adaptor/map.hpp>
 #include <utility>
 
 namespace ember {
 
-RealmList::RealmList(std::vector<Realm> realms) : realms_(std::make_shared<RealmMap>()) {
+RealmList::RealmList(std::vector<Realm> realms) {
+	update(std::make_shared<RealmMap>());
 	add_realm(std::move(realms));
 }
 
@@ -24,7 +26,7 @@ void RealmList::add_realm(std::vector<Realm> realms) {
 		copy->emplace(r.id, std::move(r));
 	}
 
-	realms_ = copy;
+	update(std::move(copy));
 }
 
 void RealmList::add_realm(Realm realm) {
@@ -33,7 +35,29 @@ void RealmList::add_realm(Realm realm) {
 	auto copy = std::make_shared<RealmMap>(*realms_);
 	(*copy)[realm.id] = realm;
 
-	realms_ = copy;
+	update(std::move(copy));
+}
+
+// rebuilds the templates from the new realms and swaps both in together
+void RealmList::update(std::shared_ptr<const RealmMap> realms) {
+	std::vector<Realm> all;
+	std::map<dbc::Cfg_Categories::Region, std::vector<Realm>> regions;
+
+	for(auto& realm : *realms | boost::adaptors::map_values) {
+		all.emplace_back(realm);
+		regions[realm.region].emplace_back(realm);
+	}
+
+	auto templates = std::make_shared<RealmListTemplates>();
+	templates->all = grunt::server::RealmListTemplate(all);
+	templates->empty = grunt::server::RealmListTemplate(std::vector<Realm>());
+
+	for(auto& region : regions) {
+		templates->regions.emplace(region.first, grunt::server::RealmListTemplate(region.second));
+	}
+
+	realms_ = std::move(realms);
+	templates_ = std::move(templates);
 }
 
 Realm RealmList::get_realm(std::uint32_t id) const {
@@ -42,7 +66,28 @@ Realm RealmList::get_realm(std::uint32_t id) const {
 }
 
 auto RealmList::realms() const -> std::shared_ptr<const RealmMap> {
+	std::lock_guard<std::mutex> guard(lock_);
 	return realms_;
 }
 
+auto RealmList::realm_list(boost::optional<dbc::Cfg_Categories::Region> region) const
+                           -> std::shared_ptr<const grunt::server::RealmListTemplate> {
+	std::unique_lock<std::mutex> guard(lock_);
+	auto templates = templates_;
+	guard.unlock();
+
+	// aliases the snapshot so the template outlives any later updates
+	if(!region) {
+		return { templates, &templates->all };
+	}
+
+	auto it = templates->regions.find(*region);
+
+	if(it == templates->regions.end()) {
+		return { templates, &templates->empty };
+	}
+
+	return { templates, &it->second };
+}
+
 } // ember
\ No newline at end of file
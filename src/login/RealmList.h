@@ -8,7 +8,10 @@
 
 #pragma once
 
+#include "grunt/server/RealmListTemplate.h"
 #include <shared/Realm.h>
+#include <boost/optional.hpp>
+#include <map>
 #include <memory>
 #include <mutex>
 #include <unordered_map>
@@ -19,17 +22,31 @@ namespace ember {
 
 typedef std::unordered_map<std::uint32_t, Realm> RealmMap;
 
+// realm list responses serialised for each region filter whenever the realms change
+struct RealmListTemplates {
+	grunt::server::RealmListTemplate all;
+	grunt::server::RealmListTemplate empty;
+	std::map<dbc::Cfg_Categories::Region, grunt::server::RealmListTemplate> regions;
+};
+
 class RealmList {
 	std::shared_ptr<const RealmMap> realms_;
+	std::shared_ptr<const RealmListTemplates> templates_;
 	mutable std::mutex lock_;
 
+	void update(std::shared_ptr<const RealmMap> realms);
+
 public:
 	explicit RealmList(std::vector<Realm> realms);
-	RealmList() : realms_(std::make_shared<RealmMap>()){}
+	RealmList() { update(std::make_shared<RealmMap>()); }
 	void add_realm(std::vector<Realm> realms);
 	void add_realm(Realm realm);
 	Realm get_realm(std::uint32_t id) const;
 	std::shared_ptr<const RealmMap> realms() const;
+
+	// no region returns the list without any filtering
+	std::shared_ptr<const grunt::server::RealmListTemplate>
+		realm_list(boost::optional<dbc::Cfg_Categories::Region> region) const;
 };
 
 } // ember
\ No newline at end of file
@@ -32,14 +32,16 @@ public:
 class LoginSessionBuilder final : public NetworkSessionBuilder {
 	const LoginHandlerBuilder& builder_;
 	ThreadPool& pool_;
+	ThreadPool& crypto_pool_;
 
 public:
-	LoginSessionBuilder(const LoginHandlerBuilder& builder, ThreadPool& pool)
-	                    : builder_(builder), pool_(pool) { }
+	LoginSessionBuilder(const LoginHandlerBuilder& builder, ThreadPool& pool, ThreadPool& crypto_pool)
+	                    : builder_(builder), pool_(pool), crypto_pool_(crypto_pool) { }
 
 	std::shared_ptr<NetworkSession> create(SessionManager& sessions, bai::tcp::socket socket,
 	                                       log::Logger* logger) const override {
-		return std::make_shared<LoginSession>(sessions, std::move(socket), logger, pool_, builder_);
+		return std::make_shared<LoginSession>(sessions, std::move(socket), logger, pool_,
+		                                      crypto_pool_, builder_);
 	}
 };
 
@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2016 Ember
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "UserCache.h"
+
+namespace ember {
+
+UserCache::UserCache(std::size_t capacity, std::chrono::seconds ttl, std::chrono::seconds negative_ttl)
+                     : capacity_(capacity), ttl_(ttl), negative_ttl_(negative_ttl),
+                       hits_(0), misses_(0) { }
+
+bool UserCache::find(const std::string& username, Record& record) {
+	std::lock_guard<std::mutex> guard(lock_);
+
+	auto it = entries_.find(username);
+
+	if(it == entries_.end()) {
+		++misses_;
+		return false;
+	}
+
+	if(it->second->expiry <= Clock::now()) {
+		erase(it->second);
+		++misses_;
+		return false;
+	}
+
+	// move to the front of the LRU list
+	lru_.splice(lru_.begin(), lru_, it->second);
+	record = it->second->record;
+	++hits_;
+	return true;
+}
+
+void UserCache::store(const std::string& username, Record record) {
+	std::lock_guard<std::mutex> guard(lock_);
+
+	auto it = entries_.find(username);
+
+	if(it != entries_.end()) {
+		erase(it->second);
+	}
+
+	if(!capacity_) {
+		return;
+	}
+
+	if(lru_.size() >= capacity_) {
+		erase(std::prev(lru_.end()));
+	}
+
+	const auto expiry = Clock::now() + (record? ttl_ : negative_ttl_);
+	lru_.push_front({ username, record, expiry });
+	entries_[username] = lru_.begin();
+
+	if(record) {
+		ids_[record->user.id()] = lru_.begin();
+	}
+}
+
+void UserCache::invalidate(const std::string& username) {
+	std::lock_guard<std::mutex> guard(lock_);
+
+	auto it = entries_.find(username);
+
+	if(it != entries_.end()) {
+		erase(it->second);
+	}
+}
+
+void UserCache::invalidate(std::uint32_t account_id) {
+	std::lock_guard<std::mutex> guard(lock_);
+
+	auto it = ids_.find(account_id);
+
+	if(it != ids_.end()) {
+		erase(it->second);
+	}
+}
+
+void UserCache::erase(LRUList::iterator it) {
+	if(it->record) {
+		ids_.erase(it->record->user.id());
+	}
+
+	entries_.erase(it->username);
+	lru_.erase(it);
+}
+
+std::size_t UserCache::size() {
+	std::lock_guard<std::mutex> guard(lock_);
+	return lru_.size();
+}
+
+auto UserCache::reset_counters() -> Counters {
+	return { hits_.exchange(0), misses_.exchange(0) };
+}
+
+} // ember
\ No newline at end of file
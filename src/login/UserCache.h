@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2016 Ember
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include <shared/database/objects/User.h>
+#include <botan/bigint.h>
+#include <atomic>
+#include <chrono>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <cstddef>
+#include <cstdint>
+
+namespace ember {
+
+// user record with the SRP6 values already decoded from their database strings
+struct CachedUser {
+	const User user;
+	const Botan::BigInt salt;
+	const Botan::BigInt verifier;
+
+	explicit CachedUser(User record)
+	                    : user(std::move(record)), salt(user.salt()), verifier(user.verifier()) {}
+};
+
+/*
+ * Bounded LRU cache of user records, keyed by username. Lookups for accounts
+ * that don't exist are cached as well (with a shorter lifetime) so repeated
+ * attempts against unknown usernames don't each cost a query.
+ *
+ * Entries expire after a short TTL to bound how stale the data can get and
+ * are invalidated early by account events (bans, suspensions) and failed
+ * proofs, which is what a password change looks like from our side.
+ */
+class UserCache final {
+public:
+	typedef std::shared_ptr<const CachedUser> Record; // null for unknown accounts
+	typedef std::chrono::steady_clock Clock;
+
+	struct Counters {
+		std::uint64_t hits;
+		std::uint64_t misses;
+	};
+
+private:
+	struct Entry {
+		std::string username;
+		Record record;
+		Clock::time_point expiry;
+	};
+
+	typedef std::list<Entry> LRUList;
+
+	const std::size_t capacity_;
+	const std::chrono::seconds ttl_;
+	const std::chrono::seconds negative_ttl_;
+
+	LRUList lru_;
+	std::unordered_map<std::string, LRUList::iterator> entries_;
+	std::unordered_map<std::uint32_t, LRUList::iterator> ids_;
+	std::atomic<std::uint64_t> hits_;
+	std::atomic<std::uint64_t> misses_;
+	std::mutex lock_;
+
+	void erase(LRUList::iterator it);
+
+public:
+	UserCache(std::size_t capacity, std::chrono::seconds ttl, std::chrono::seconds negative_ttl);
+
+	// returns true on a hit, in which case a null record means the account doesn't exist
+	bool find(const std::string& username, Record& record);
+	void store(const std::string& username, Record record);
+
+	void invalidate(const std::string& username);
+	void invalidate(std::uint32_t account_id);
+
+	std::size_t size();
+	Counters reset_counters();
+};
+
+} // ember
\ No newline at end of file
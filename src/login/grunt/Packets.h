@@ -19,6 +19,7 @@
 #include "server/LoginChallenge.h"
 #include "server/LoginProof.h"
 #include "server/RealmList.h"
+#include "server/RealmListTemplate.h"
 #include "server/ReconnectChallenge.h"
 #include "server/ReconnectProof.h"
 #include "server/TransferInitiate.h"
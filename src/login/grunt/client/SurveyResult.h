@@ -107,7 +107,14 @@ public:
 		stream << be::native_to_little(survey_id);
 		stream << error;
 
-		std::vector<std::uint8_t> compressed(data.size());
+		// the server doesn't expect any data along with an error
+		if(error) {
+			stream << std::uint16_t(0);
+			return;
+		}
+
+		// small inputs can grow when compressed
+		std::vector<std::uint8_t> compressed(compressBound(data.size()));
 		uLongf dest_len = compressed.size();
 
 		auto ret = compress(compressed.data(), &dest_len, reinterpret_cast<const Bytef*>(data.data()), data.size());
@@ -23,19 +23,33 @@ namespace ember { namespace grunt { namespace server {
 namespace be = boost::endian;
 
 class LoginChallenge final : public Packet {
+	static const std::size_t HEADER_LENGTH = 3;
 	static const std::size_t WIRE_LENGTH = 119;
 	static const std::uint8_t SALT_LENGTH = 32;
 
+	enum class ReadState {
+		READ_HEADER, READ_BODY, READ_PIN_DATA, DONE
+	} read_state_ = ReadState::READ_HEADER;
+
 	State state_ = State::INITIAL;
 
-	void read_body(spark::SafeBinaryStream& stream) {
+	bool read_header(spark::SafeBinaryStream& stream) {
+		if(stream.size() < HEADER_LENGTH) {
+			return false;
+		}
+
 		stream >> opcode;
-		stream >> result;
 		stream >> protocol_ver;
+		stream >> result;
 
-		if(result != grunt::Result::SUCCESS) {
-			state_ = State::DONE;
-			return; // rest of the fields won't be sent
+		// rest of the fields won't be sent
+		read_state_ = (result == grunt::Result::SUCCESS)? ReadState::READ_BODY : ReadState::DONE;
+		return true;
+	}
+
+	bool read_body(spark::SafeBinaryStream& stream) {
+		if(stream.size() < (WIRE_LENGTH - HEADER_LENGTH)) {
+			return false;
 		}
 
 		Botan::byte b_buff[PUB_KEY_LENGTH];
@@ -59,22 +73,23 @@ class LoginChallenge final : public Packet {
 
 		stream.get(checksum_salt.data(), checksum_salt.size());
 		stream >> two_factor_auth;
-	}
 
-	void read_pin_data(spark::SafeBinaryStream& stream) {
-		if(!two_factor_auth || state_ == State::DONE) {
-			return;
-		}
+		read_state_ = two_factor_auth? ReadState::READ_PIN_DATA : ReadState::DONE;
+		return true;
+	}
 
+	bool read_pin_data(spark::SafeBinaryStream& stream) {
 		// does the stream hold enough bytes to complete the PIN data?
-		if(stream.size() >= (pin_salt.size() + sizeof(pin_grid_seed))) {
-			stream >> pin_grid_seed;
-			be::little_to_native_inplace(pin_grid_seed);
-			stream.get(pin_salt.data(), PIN_SALT_LENGTH);
-			state_ = State::DONE;
-		} else {
-			state_ = State::CALL_AGAIN;
+		if(stream.size() < (pin_salt.size() + sizeof(pin_grid_seed))) {
+			return false;
 		}
+
+		stream >> pin_grid_seed;
+		be::little_to_native_inplace(pin_grid_seed);
+		stream.get(pin_salt.data(), PIN_SALT_LENGTH);
+
+		read_state_ = ReadState::DONE;
+		return true;
 	}
 
 public:
@@ -102,25 +117,29 @@ public:
 	std::uint32_t pin_grid_seed;
 	std::array<std::uint8_t, PIN_SALT_LENGTH> pin_salt;
 
-	// todo - early abort (wire length change)
 	State read_from_stream(spark::SafeBinaryStream& stream) override {
 		BOOST_ASSERT_MSG(state_ != State::DONE, "Packet already complete - check your logic!");
 
-		if(state_ == State::INITIAL && stream.size() < WIRE_LENGTH) {
-			return State::CALL_AGAIN;
-		}
-
-		switch(state_) {
-			case State::INITIAL:
-				read_body(stream);
-				[[fallthrough]];
-			case State::CALL_AGAIN:
-				read_pin_data(stream);
-				break;
-			default:
-				BOOST_ASSERT_MSG(false, "Unreachable condition hit");
+		bool continue_read = true;
+
+		while(continue_read) {
+			switch(read_state_) {
+				case ReadState::READ_HEADER:
+					continue_read = read_header(stream);
+					break;
+				case ReadState::READ_BODY:
+					continue_read = read_body(stream);
+					break;
+				case ReadState::READ_PIN_DATA:
+					continue_read = read_pin_data(stream);
+					break;
+				case ReadState::DONE:
+					continue_read = false;
+					break;
+			}
 		}
 
+		state_ = (read_state_ == ReadState::DONE)? State::DONE : State::CALL_AGAIN;
 		return state_;
 	}
 
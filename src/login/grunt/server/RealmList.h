@@ -14,6 +14,7 @@
 #include <shared/Realm.h>
 #include <boost/assert.hpp>
 #include <boost/endian/conversion.hpp>
+#include <vector>
 #include <cstdint>
 #include <cstddef>
 
@@ -159,6 +160,22 @@ public:
 	}
 
 	void write_to_stream(spark::BinaryStream& stream) const override {
+		write(stream, nullptr);
+	}
+
+	/*
+	 * Writes the packet and returns the stream offsets of each entry's
+	 * character count, allowing a serialised copy to be reused for
+	 * different accounts by patching just those bytes
+	 */
+	std::vector<std::size_t> write_template(spark::BinaryStream& stream) const {
+		std::vector<std::size_t> offsets;
+		write(stream, &offsets);
+		return offsets;
+	}
+
+private:
+	void write(spark::BinaryStream& stream, std::vector<std::size_t>* count_offsets) const {
 		if(realms.size() > MAX_REALM_ENTRIES) {
 			throw bad_packet("Attempted to send too many realm list entries!");
 		}
@@ -175,6 +192,11 @@ public:
 			stream << realm.name;
 			stream << realm.ip;
 			stream << be::native_to_little(realm.population);
+
+			if(count_offsets) {
+				count_offsets->emplace_back(stream.size());
+			}
+
 			stream << static_cast<std::uint8_t>(entry.characters);
 			stream << static_cast<std::uint8_t>(realm.category);
 			stream << std::uint8_t(realm.id);
@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2016 Ember
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include "RealmList.h"
+#include "../Opcodes.h"
+#include "../Packet.h"
+#include <spark/buffers/ChainedBuffer.h>
+#include <shared/Realm.h>
+#include <boost/assert.hpp>
+#include <unordered_map>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace ember { namespace grunt { namespace server {
+
+/*
+ * A realm list response serialised ahead of time. The only part that differs
+ * between accounts is the character count for each realm, so the offsets of
+ * those bytes are recorded for patching when the response is sent.
+ */
+struct RealmListTemplate {
+	struct CountSlot {
+		std::size_t offset;
+		std::uint32_t realm_id;
+	};
+
+	std::vector<char> data;
+	std::vector<CountSlot> slots;
+
+	RealmListTemplate() = default;
+
+	explicit RealmListTemplate(const std::vector<Realm>& realms) {
+		RealmList packet;
+
+		for(auto& realm : realms) {
+			packet.realms.push_back({ realm, 0 });
+		}
+
+		spark::ChainedBuffer<1024> buffer;
+		spark::BinaryStream stream(buffer);
+		auto offsets = packet.write_template(stream);
+
+		for(std::size_t i = 0; i < offsets.size(); ++i) {
+			slots.push_back({ offsets[i], realms[i].id });
+		}
+
+		data.resize(buffer.size());
+		buffer.read(data.data(), data.size());
+	}
+};
+
+/*
+ * Writes a realm list template with the account's character counts spliced
+ * in, without copying or modifying the shared template
+ */
+class RealmListResponse final : public Packet {
+	typedef std::unordered_map<std::uint32_t, std::uint32_t> CharacterCount;
+
+	const RealmListTemplate& template_;
+	const CharacterCount& counts_;
+
+public:
+	RealmListResponse(const RealmListTemplate& list, const CharacterCount& counts)
+	                  : Packet(Opcode::CMD_REALM_LIST), template_(list), counts_(counts) {}
+
+	State read_from_stream(spark::SafeBinaryStream& stream) override {
+		BOOST_ASSERT_MSG(false, "Server-only packet, use RealmList to deserialise");
+		return State::DONE;
+	}
+
+	void write_to_stream(spark::BinaryStream& stream) const override {
+		std::size_t written = 0;
+
+		for(auto& slot : template_.slots) {
+			stream.put(template_.data.data() + written, slot.offset - written);
+
+			auto it = counts_.find(slot.realm_id);
+			stream << static_cast<std::uint8_t>(it == counts_.end()? 0 : it->second);
+			written = slot.offset + 1;
+		}
+
+		stream.put(template_.data.data() + written, template_.data.size() - written);
+	}
+};
+
+}}} // server, grunt, ember
\ No newline at end of file
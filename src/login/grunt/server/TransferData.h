@@ -13,6 +13,7 @@
 #include "../Exceptions.h"
 #include <boost/assert.hpp>
 #include <boost/endian/conversion.hpp>
+#include <array>
 #include <vector>
 #include <cstdint>
 #include <cstddef>
@@ -27,11 +28,12 @@ class TransferData final : public Packet {
 
 public:
 	static const std::uint16_t MAX_CHUNK_SIZE = 65535;
+	static const std::size_t HEADER_LENGTH = 3;
 
 	TransferData() : Packet(Opcode::CMD_XFER_DATA) {}
 
 	std::uint16_t size = 0;
-	std::array<char, MAX_CHUNK_SIZE> chunk;
+	const char* chunk = nullptr; // not owned, must remain valid until the packet is written
 
 	State read_from_stream(spark::SafeBinaryStream& stream) override {
 		BOOST_ASSERT_MSG(state_ != State::DONE, "Packet already complete - check your logic!");
@@ -49,10 +51,19 @@ public:
 		return (state_ = State::DONE);
 	}
 
+	// opcode and size only, for writing the chunk straight from its own storage
+	std::array<std::uint8_t, HEADER_LENGTH> header() const {
+		return {{
+			static_cast<std::uint8_t>(opcode),
+			static_cast<std::uint8_t>(size & 0xFF),
+			static_cast<std::uint8_t>(size >> 8)
+		}};
+	}
+
 	void write_to_stream(spark::BinaryStream& stream) const override {
 		stream << opcode;
 		stream << be::native_to_little(size);
-		stream.put(chunk.data(), size);
+		stream.put(chunk, size);
 	}
 };
 
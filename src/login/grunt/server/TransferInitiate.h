@@ -13,6 +13,8 @@
 #include "../Exceptions.h"
 #include <boost/assert.hpp>
 #include <boost/endian/conversion.hpp>
+#include <array>
+#include <string>
 #include <cstdint>
 #include <cstddef>
 
@@ -21,8 +23,10 @@ namespace ember { namespace grunt { namespace server {
 namespace be = boost::endian;
 
 class TransferInitiate final : public Packet {
-	static const std::size_t WIRE_LENGTH = 1;
+	static const std::size_t HEADER_LENGTH = 2;
+	static const std::size_t BODY_LENGTH = 24; // excluding the filename
 	State state_ = State::INITIAL;
+	std::uint8_t name_len_ = 0;
 
 public:
 	TransferInitiate() : Packet(Opcode::CMD_XFER_INITIATE) {}
@@ -34,12 +38,23 @@ public:
 	State read_from_stream(spark::SafeBinaryStream& stream) override {
 		BOOST_ASSERT_MSG(state_ != State::DONE, "Packet already complete - check your logic!");
 
-		if(stream.size() < WIRE_LENGTH) {
-			return State::CALL_AGAIN;
+		if(state_ == State::INITIAL) {
+			if(stream.size() < HEADER_LENGTH) {
+				return State::CALL_AGAIN;
+			}
+
+			stream >> opcode;
+			stream >> name_len_;
+			state_ = State::CALL_AGAIN;
 		}
 
-		stream >> opcode;
+		if(stream.size() < name_len_ + BODY_LENGTH) {
+			return state_;
+		}
 
+		stream.get(filename, name_len_);
+		stream >> filesize;
+		stream.get(md5.data(), md5.size());
 
 		return (state_ = State::DONE);
 	}
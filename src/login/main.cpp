@@ -7,18 +7,26 @@
  */
 
 #include "AccountService.h"
+#include "BatchWriter.h"
+#include "CharacterCountCache.h"
+#include "CharacterService.h"
+#include "ChecksumPool.h"
 #include "RealmService.h"
 #include "FilterTypes.h"
 #include "GameVersion.h"
 #include "SessionBuilders.h"
 #include "LoginHandlerBuilder.h"
+#include "LoginTimings.h"
 #include "IntegrityData.h"
 #include "MonitorCallbacks.h"
 #include "NetworkListener.h"
 #include "Patcher.h"
+#include "RateLimiter.h"
 #include "RealmList.h"
+#include "UserCache.h"
 #include <logger/Logging.h>
 #include <conpool/ConnectionPool.h>
+#include <conpool/AsyncExecutor.h>
 #include <conpool/Policies.h>
 #include <conpool/drivers/AutoSelect.h>
 #include <spark/Service.h>
@@ -29,6 +37,8 @@
 #include <shared/metrics/MetricsImpl.h>
 #include <shared/metrics/Monitor.h>
 #include <shared/metrics/MetricsPoll.h>
+#include <shared/metrics/PoolMetrics.h>
+#include <shared/threading/ServicePool.h>
 #include <shared/threading/ThreadPool.h>
 #include <shared/database/daos/IPBanDAO.h>
 #include <shared/database/daos/PatchDAO.h>
@@ -38,11 +48,13 @@
 #include <shared/util/xoroshiro128plus.h>
 #include <botan/version.h>
 #include <boost/asio/io_service.hpp>
+#include <boost/asio/steady_timer.hpp>
 #include <boost/version.hpp>
 #include <boost/program_options.hpp>
 #include <boost/range/adaptor/map.hpp>
 #include <pcre.h>
 #include <zlib.h>
+#include <chrono>
 #include <fstream>
 #include <functional>
 #include <iostream>
@@ -97,6 +109,8 @@ int main(int argc, const char* argv[]) try {
 }
 
 void launch(const po::variables_map& args, el::Logger* logger) try {
+	const auto start_time = std::chrono::steady_clock::now();
+
 #ifdef DEBUG_NO_THREADS
 	LOG_WARN(logger) << "Compiled with DEBUG_NO_THREADS!" << LOG_SYNC;
 #endif
@@ -129,12 +143,17 @@ void launch(const po::variables_map& args, el::Logger* logger) try {
 		pool_log_callback(severity, message, logger);
 	});
 
+	LOG_INFO(logger) << "Starting database threads..." << LOG_SYNC;
+	auto db_threads = args["database.async_threads"].as<unsigned short>();
+	auto db_backlog = args["database.async_backlog"].as<std::size_t>();
+	ep::AsyncExecutor<decltype(pool)> db_executor(pool, db_threads, db_backlog);
+
 	LOG_INFO(logger) << "Initialising DAOs..." << LOG_SYNC; 
-	auto user_dao = ember::dal::user_dao(pool);
+	auto user_dao = ember::dal::user_dao(pool, &db_executor);
 	auto realm_dao = ember::dal::realm_dao(pool);
 	auto patch_dao = ember::dal::patch_dao(pool);
 	auto ip_ban_dao = ember::dal::ip_ban_dao(pool); 
-	auto ip_ban_cache = ember::IPBanCache(ip_ban_dao->all_bans());
+	ember::IPBanCache ip_ban_cache(ip_ban_dao->all_bans());
 
 	// Load integrity, patch and survey data
 	LOG_INFO(logger) << "Loading client integrity validation data..." << LOG_SYNC;
@@ -142,9 +161,17 @@ void launch(const po::variables_map& args, el::Logger* logger) try {
 
 	const auto allowed_clients = client_versions(); // move
 
+	std::unique_ptr<ember::ChecksumPool> checksum_pool;
+
 	if(args["integrity.enabled"].as<bool>()) {
 		auto bin_path = args["integrity.bin_path"].as<std::string>();
-		exe_data = std::make_unique<ember::IntegrityData>(allowed_clients, bin_path);
+		auto prefetch = args["integrity.prefetch"].as<bool>();
+		exe_data = std::make_unique<ember::IntegrityData>(allowed_clients, bin_path, logger, prefetch);
+
+		if(auto pool_size = args["integrity.checksum_pool"].as<unsigned int>()) {
+			LOG_INFO(logger) << "Starting client integrity checksum pool (" << pool_size << ")..." << LOG_SYNC;
+			checksum_pool = std::make_unique<ember::ChecksumPool>(*exe_data, allowed_clients, pool_size);
+		}
 	}
 
 	LOG_INFO(logger) << "Loading patch data..." << LOG_SYNC;
@@ -156,11 +183,23 @@ void launch(const po::variables_map& args, el::Logger* logger) try {
 
 	ember::Patcher patcher(allowed_clients, patches);
 
+	// map the patches up front rather than on the first transfer
+	for(auto& patch : patches) {
+		patcher.patch_file(patch.file_meta);
+	}
+
+	for(auto& route : patcher.routes()->routes()) {
+		LOG_DEBUG(logger) << "Patch route " << route.patch.locale << "/" << route.patch.arch << "/"
+		                  << route.patch.os << " " << route.from << " -> " << route.to << ": "
+		                  << route.hops << " patch(es), " << route.cost << " bytes" << LOG_SYNC;
+	}
+
 	if(args["survey.enabled"].as<bool>()) {
 		LOG_INFO(logger) << "Loading survey data..." << LOG_SYNC;
 		patcher.set_survey(
 			args["survey.bin_path"].as<std::string>(),
-			args["survey.id"].as<std::uint32_t>()
+			args["survey.id"].as<std::uint32_t>(),
+			logger
 		);
 	}
 
@@ -173,12 +212,53 @@ void launch(const po::variables_map& args, el::Logger* logger) try {
 		LOG_DEBUG(logger) << "#" << realm.id << " " << realm.name << LOG_SYNC;
 	}
 
+	// Cache user records so repeat logins skip the DB query and verifier decoding
+	std::unique_ptr<ember::UserCache> user_cache;
+
+	if(auto cache_size = args["users.cache_size"].as<unsigned int>()) {
+		user_cache = std::make_unique<ember::UserCache>(cache_size,
+			std::chrono::seconds(args["users.cache_ttl"].as<unsigned int>()),
+			std::chrono::seconds(args["users.negative_ttl"].as<unsigned int>()));
+	}
+
+	// Per-account character counts, filled in by the character service once it starts
+	std::unique_ptr<ember::CharacterCountCache> char_counts;
+
+	if(auto cache_size = args["characters.cache_size"].as<unsigned int>()) {
+		char_counts = std::make_unique<ember::CharacterCountCache>(cache_size,
+			std::chrono::seconds(args["characters.cache_ttl"].as<unsigned int>()));
+	}
+
+	// Server ephemerals don't depend on the user, so generate them ahead of demand
+	std::unique_ptr<ember::EphemeralPool> ephemeral_pool;
+	auto ephemeral_pool_size = args["crypto.ephemeral_pool"].as<unsigned int>();
+
+	if(ephemeral_pool_size) {
+		LOG_INFO(logger) << "Starting SRP6 ephemeral pool (" << ephemeral_pool_size << ")..." << LOG_SYNC;
+		const ember::srp6::Generator gen(ember::LoginAuthenticator::GROUP);
+
+		ephemeral_pool = std::make_unique<ember::EphemeralPool>(ephemeral_pool_size, [gen] {
+			return ember::srp6::precompute_ephemeral(gen);
+		});
+	}
+
 	// Start ASIO service
 	LOG_INFO(logger) << "Starting thread pool with " << concurrency << " threads..." << LOG_SYNC;
 
 	ember::ThreadPool thread_pool(concurrency);
 	boost::asio::io_service service(concurrency);
 
+	// SRP6 work is CPU-bound, so it gets its own bounded pool to keep it off the network threads
+	auto crypto_threads = args["crypto.threads"].as<unsigned int>();
+	auto crypto_backlog = args["crypto.max_queued"].as<unsigned int>();
+
+	if(!crypto_threads) {
+		crypto_threads = concurrency;
+	}
+
+	LOG_INFO(logger) << "Starting crypto pool with " << crypto_threads << " threads..." << LOG_SYNC;
+	ember::ThreadPool crypto_pool(crypto_threads, crypto_backlog);
+
 	// Start Spark services
 	LOG_INFO(logger) << "Starting Spark service..." << LOG_SYNC;
 	auto s_address = args["spark.address"].as<std::string>();
@@ -192,9 +272,29 @@ void launch(const po::variables_map& args, el::Logger* logger) try {
 	es::ServiceDiscovery discovery(service, s_address, s_port, mcast_iface, mcast_group,
 	                               mcast_port, logger, spark_filter);
 
-	ember::AccountService acct_svc(spark, discovery, logger);
+	ember::AccountService acct_svc(spark, discovery, logger, [&user_cache, logger](std::uint32_t id,
+	                               ember::messaging::account::DisconnectReason reason) {
+		using ember::messaging::account::DisconnectReason;
+
+		// only bans and suspensions change the cached account state
+		if(!user_cache || (reason != DisconnectReason::ACCOUNT_BANNED
+		                   && reason != DisconnectReason::ACCOUNT_SUSPENDED)) {
+			return;
+		}
+
+		LOG_DEBUG(logger) << "Invalidating cached user " << id << LOG_ASYNC;
+		user_cache->invalidate(id);
+	});
+
 	ember::RealmService realm_svc(realm_list, spark, discovery, logger);
 
+	// Character counts are kept current by the character service's notifications
+	std::unique_ptr<ember::CharacterService> char_svc;
+
+	if(char_counts) {
+		char_svc = std::make_unique<ember::CharacterService>(*char_counts, spark, discovery, logger);
+	}
+
 	// Start metrics service
 	auto metrics = std::make_unique<ember::Metrics>();
 
@@ -206,19 +306,80 @@ void launch(const po::variables_map& args, el::Logger* logger) try {
 		);
 	}
 
+	// Non-critical writes (login history, surveys) are batched off the login path
+	ember::BatchWriter writer(*user_dao, logger, args["write_behind.capacity"].as<unsigned int>(),
+	                          args["write_behind.batch_size"].as<unsigned int>(),
+	                          std::chrono::milliseconds(args["write_behind.interval"].as<unsigned int>()));
+
+	// Admission control - attempts over the limit are shed before any crypto or database work
+	const auto limiter_slots = args["rate_limit.table_size"].as<unsigned int>();
+
+	ember::RateLimiter ip_limiter(limiter_slots, args["rate_limit.ip_rate"].as<double>(),
+	                              args["rate_limit.ip_burst"].as<double>());
+
+	ember::RateLimiter account_limiter(limiter_slots, args["rate_limit.account_rate"].as<double>(),
+	                                   args["rate_limit.account_burst"].as<double>());
+
+	// Where the time goes during handshakes, reported through the metrics poller
+	ember::LoginTimings login_timings(std::chrono::milliseconds(args["metrics.slow_login"].as<unsigned int>()));
+
 	// Start login server
-	ember::LoginHandlerBuilder builder(logger, patcher, exe_data.get(), *user_dao, acct_svc,
-	                                   realm_list, *metrics, args["locale.enforce"].as<bool>());
-	ember::LoginSessionBuilder s_builder(builder, thread_pool);
+	const ember::TransferConfig transfer_config {
+		args["patches.transfer_window"].as<unsigned int>(),
+		args["patches.max_rate"].as<unsigned int>() * 1024u
+	};
+
+	ember::LoginHandlerBuilder builder(logger, patcher, exe_data.get(), checksum_pool.get(),
+	                                   ephemeral_pool.get(), *user_dao, user_cache.get(), char_counts.get(),
+	                                   writer, account_limiter, login_timings, acct_svc, realm_list,
+	                                   *metrics, transfer_config, args["locale.enforce"].as<bool>());
+	ember::LoginSessionBuilder s_builder(builder, thread_pool, crypto_pool);
 
 	auto interface = args["network.interface"].as<std::string>();
 	auto port = args["network.port"].as<std::uint16_t>();
 	auto tcp_no_delay = args["network.tcp_no_delay"].as<bool>();
 
+	// One acceptor and service per worker thread, sessions stay on the thread that accepted them
+	std::unique_ptr<ember::ServicePool> accept_pool;
+
+	if(args["network.reuse_port"].as<bool>()) {
+		accept_pool = std::make_unique<ember::ServicePool>(concurrency);
+	}
+
 	LOG_INFO(logger) << "Starting network service on " << interface << ":" << port << LOG_SYNC;
 
-	ember::NetworkListener server(service, interface, port, tcp_no_delay, s_builder, ip_ban_cache,
-	                              logger, *metrics);
+	ember::NetworkListener server(service, accept_pool.get(), interface, port, tcp_no_delay,
+	                              s_builder, ip_ban_cache, ip_limiter,
+	                              args["rate_limit.ipv4_prefix"].as<unsigned int>(),
+	                              args["rate_limit.ipv6_prefix"].as<unsigned int>(), logger, *metrics);
+
+	// Pick up bans added since startup - the new list is loaded on the thread pool and swapped in whole
+	boost::asio::steady_timer ban_timer(service);
+	std::function<void()> schedule_ban_reload;
+	const std::chrono::seconds ban_reload_interval(args["network.ban_reload_interval"].as<unsigned int>());
+
+	schedule_ban_reload = [&]() {
+		ban_timer.expires_from_now(ban_reload_interval);
+		ban_timer.async_wait([&](const boost::system::error_code& ec) {
+			if(ec) { // timer cancelled, shutting down
+				return;
+			}
+
+			thread_pool.run([&] {
+				try {
+					ip_ban_cache.reload(ip_ban_dao->all_bans());
+				} catch(const std::exception& e) {
+					LOG_ERROR(logger) << "Unable to reload IP bans: " << e.what() << LOG_ASYNC;
+				}
+
+				service.post(schedule_ban_reload);
+			});
+		});
+	};
+
+	if(ban_reload_interval.count()) {
+		schedule_ban_reload();
+	}
 
 	// Start monitoring service
 	std::unique_ptr<ember::Monitor> monitor;
@@ -240,32 +401,127 @@ void launch(const po::variables_map& args, el::Logger* logger) try {
 
 	poller.add_source([&pool](ember::Metrics& metrics) {
 		metrics.gauge("db_connections", pool.size());
+		ember::report_pool_stats(metrics, pool.reset_stats());
+	}, 5s);
+
+	poller.add_source([&db_executor](ember::Metrics& metrics) {
+		metrics.gauge("db_queue_depth", db_executor.queue_depth());
 	}, 5s);
 
 	poller.add_source([&server](ember::Metrics& metrics) {
 		metrics.gauge("sessions", server.connection_count());
 	}, 5s);
 
-	service.dispatch([logger]() {
-		LOG_INFO(logger) << "Login daemon started successfully" << LOG_SYNC;
+	poller.add_source([&login_timings](ember::Metrics& metrics) {
+		login_timings.report(metrics);
+	}, 5s);
+
+	poller.add_source([&crypto_pool](ember::Metrics& metrics) {
+		metrics.gauge("crypto_queue_depth", crypto_pool.queue_depth());
+	}, 5s);
+
+	if(ephemeral_pool) {
+		poller.add_source([&ephemeral_pool](ember::Metrics& metrics) {
+			const auto counters = ephemeral_pool->reset_counters();
+			metrics.gauge("srp6_ephemerals_available", ephemeral_pool->size());
+			metrics.increment("srp6_ephemerals_generated", counters.generated);
+			metrics.increment("srp6_ephemerals_exhausted", counters.exhausted);
+		}, 5s);
+	}
+
+	if(user_cache) {
+		poller.add_source([&user_cache](ember::Metrics& metrics) {
+			const auto counters = user_cache->reset_counters();
+			metrics.gauge("user_cache_size", user_cache->size());
+			metrics.increment("user_cache_hits", counters.hits);
+			metrics.increment("user_cache_misses", counters.misses);
+		}, 5s);
+	}
+
+	poller.add_source([&writer](ember::Metrics& metrics) {
+		const auto counters = writer.reset_counters();
+		metrics.gauge("write_behind_queued", writer.size());
+		metrics.increment("write_behind_written", counters.written);
+		metrics.increment("write_behind_dropped", counters.dropped);
+		metrics.increment("write_behind_failed", counters.failed);
+	}, 5s);
+
+	if(char_counts) {
+		poller.add_source([&char_counts](ember::Metrics& metrics) {
+			const auto counters = char_counts->reset_counters();
+			metrics.gauge("character_count_cache_size", char_counts->size());
+			metrics.increment("character_count_cache_hits", counters.hits);
+			metrics.increment("character_count_cache_misses", counters.misses);
+		}, 5s);
+	}
+
+	if(ip_limiter.enabled()) {
+		poller.add_source([&ip_limiter](ember::Metrics& metrics) {
+			const auto counters = ip_limiter.reset_counters();
+			metrics.increment("ip_limit_admitted", counters.admitted);
+			metrics.increment("ip_limit_shed", counters.shed);
+			metrics.increment("ip_limit_evicted", counters.evicted);
+		}, 5s);
+	}
+
+	if(account_limiter.enabled()) {
+		poller.add_source([&account_limiter](ember::Metrics& metrics) {
+			const auto counters = account_limiter.reset_counters();
+			metrics.increment("account_limit_admitted", counters.admitted);
+			metrics.increment("account_limit_shed", counters.shed);
+			metrics.increment("account_limit_evicted", counters.evicted);
+		}, 5s);
+	}
+
+	if(checksum_pool) {
+		poller.add_source([&checksum_pool](ember::Metrics& metrics) {
+			const auto counters = checksum_pool->reset_counters();
+			metrics.gauge("integrity_checksums_available", checksum_pool->size());
+			metrics.increment("integrity_checksums_generated", counters.generated);
+			metrics.increment("integrity_checksums_exhausted", counters.exhausted);
+		}, 5s);
+	}
+
+	service.dispatch([logger, start_time]() {
+		const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+			std::chrono::steady_clock::now() - start_time);
+
+		LOG_INFO(logger) << "Login daemon started successfully in " << elapsed.count() << "ms" << LOG_SYNC;
 	});
 	
 	// Spawn worker threads for ASIO
 	std::vector<std::thread> workers;
 
-	// start from one to take the main thread into account
-	for(unsigned int i = 1; i < concurrency; ++i) {
-		workers.emplace_back(static_cast<std::size_t(boost::asio::io_service::*)()>
-			(&boost::asio::io_service::run), &service); 
+	if(accept_pool) {
+		// sessions run on the pool, leaving the shared service on the main thread
+		LOG_INFO(logger) << "Accepting with " << server.acceptor_count()
+		                 << " SO_REUSEPORT listeners" << LOG_SYNC;
+		workers.emplace_back(&ember::ServicePool::run, accept_pool.get());
+	} else {
+		// start from one to take the main thread into account
+		for(unsigned int i = 1; i < concurrency; ++i) {
+			workers.emplace_back(static_cast<std::size_t(boost::asio::io_service::*)()>
+				(&boost::asio::io_service::run), &service); 
+		}
 	}
 
 	service.run();
 
 	LOG_INFO(logger) << APP_NAME << " shutting down..." << LOG_SYNC;
 
+	// the pool's services are kept alive by work objects, so they won't run dry on their own
+	if(accept_pool) {
+		accept_pool->stop();
+	}
+
 	for(auto& worker : workers) {
 		worker.join();
 	}
+
+	// pool work can post back to the service, so it has to finish while the service is still around
+	thread_pool.shutdown();
+	crypto_pool.shutdown();
+	db_executor.shutdown();
 } catch(std::exception& e) {
 	LOG_FATAL(logger) << e.what() << LOG_SYNC;
 }
@@ -296,11 +552,30 @@ po::variables_map parse_arguments(int argc, const char* argv[]) {
 	config_opts.add_options()
 		("locale.enforce", po::value<bool>()->required())
 		("patches.bin_path", po::value<std::string>()->required())
+		("patches.transfer_window", po::value<unsigned int>()->default_value(4))
+		("patches.max_rate", po::value<unsigned int>()->default_value(0))
 		("survey.enabled", po::value<bool>()->default_value(false))
 		("survey.bin_path", po::value<std::string>()->required())
 		("survey.id", po::value<std::uint32_t>()->required())
 		("integrity.enabled", po::value<bool>()->default_value(false))
 		("integrity.bin_path", po::value<std::string>()->required())
+		("integrity.checksum_pool", po::value<unsigned int>()->default_value(0))
+		("integrity.prefetch", po::value<bool>()->default_value(false))
+		("users.cache_size", po::value<unsigned int>()->default_value(0))
+		("users.cache_ttl", po::value<unsigned int>()->default_value(30))
+		("users.negative_ttl", po::value<unsigned int>()->default_value(5))
+		("characters.cache_size", po::value<unsigned int>()->default_value(0))
+		("characters.cache_ttl", po::value<unsigned int>()->default_value(600))
+		("write_behind.capacity", po::value<unsigned int>()->default_value(65536))
+		("write_behind.batch_size", po::value<unsigned int>()->default_value(256))
+		("write_behind.interval", po::value<unsigned int>()->default_value(1000))
+		("rate_limit.table_size", po::value<unsigned int>()->default_value(65536))
+		("rate_limit.ip_rate", po::value<double>()->default_value(0))
+		("rate_limit.ip_burst", po::value<double>()->default_value(10))
+		("rate_limit.ipv4_prefix", po::value<unsigned int>()->default_value(32))
+		("rate_limit.ipv6_prefix", po::value<unsigned int>()->default_value(64))
+		("rate_limit.account_rate", po::value<double>()->default_value(0))
+		("rate_limit.account_burst", po::value<double>()->default_value(5))
 		("spark.address", po::value<std::string>()->required())
 		("spark.port", po::value<std::uint16_t>()->required())
 		("spark.multicast_interface", po::value<std::string>()->required())
@@ -309,6 +584,11 @@ po::variables_map parse_arguments(int argc, const char* argv[]) {
 		("network.interface", po::value<std::string>()->required())
 		("network.port", po::value<std::uint16_t>()->required())
 		("network.tcp_no_delay", po::value<bool>()->default_value(true))
+		("network.reuse_port", po::value<bool>()->default_value(false))
+		("network.ban_reload_interval", po::value<unsigned int>()->default_value(0))
+		("crypto.threads", po::value<unsigned int>()->default_value(0))
+		("crypto.max_queued", po::value<unsigned int>()->default_value(0))
+		("crypto.ephemeral_pool", po::value<unsigned int>()->default_value(0))
 		("console_log.verbosity", po::value<std::string>()->required())
 		("console_log.filter-mask", po::value<std::uint32_t>()->default_value(0))
 		("console_log.colours", po::value<bool>()->required())
@@ -329,9 +609,12 @@ po::variables_map parse_arguments(int argc, const char* argv[]) {
 		("database.config_path", po::value<std::string>()->required())
 		("database.min_connections", po::value<unsigned short>()->required())
 		("database.max_connections", po::value<unsigned short>()->required())
+		("database.async_threads", po::value<unsigned short>()->default_value(4))
+		("database.async_backlog", po::value<std::size_t>()->default_value(1024))
 		("metrics.enabled", po::value<bool>()->required())
 		("metrics.statsd_host", po::value<std::string>()->required())
 		("metrics.statsd_port", po::value<std::uint16_t>()->required())
+		("metrics.slow_login", po::value<unsigned int>()->default_value(0))
 		("monitor.enabled", po::value<bool>()->required())
 		("monitor.interface", po::value<std::string>()->required())
 		("monitor.port", po::value<std::uint16_t>()->required());
@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2016 Ember
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cstddef>
+
+namespace ember { namespace bench {
+
+struct Options {
+	std::size_t iterations;
+	std::size_t binary_size; // bytes hashed by the client integrity benchmarks
+};
+
+struct Result {
+	std::string name;
+	std::size_t iterations;
+	std::chrono::nanoseconds elapsed;
+
+	double seconds_per_op() const {
+		return std::chrono::duration<double>(elapsed).count() / iterations;
+	}
+
+	double ops_per_second() const {
+		return 1.0 / seconds_per_op();
+	}
+};
+
+typedef std::vector<Result> Results;
+
+/*
+ * Runs the function a handful of times before timing it so lazily built
+ * state (precomputed tables, allocator pools) doesn't skew the results
+ */
+template<typename Func>
+Result measure(std::string name, std::size_t iterations, Func&& func) {
+	const std::size_t warmup = std::min<std::size_t>(iterations / 10 + 1, 100);
+
+	for(std::size_t i = 0; i < warmup; ++i) {
+		func();
+	}
+
+	const auto start = std::chrono::steady_clock::now();
+
+	for(std::size_t i = 0; i < iterations; ++i) {
+		func();
+	}
+
+	const auto elapsed = std::chrono::steady_clock::now() - start;
+	return { std::move(name), iterations, elapsed };
+}
+
+// the suites - each appends its results and is run on a single thread
+void srp6_suite(const Options& opts, Results& results);
+void integrity_suite(const Options& opts, Results& results);
+void pin_suite(const Options& opts, Results& results);
+void ip_ban_suite(const Options& opts, Results& results);
+void conpool_suite(const Options& opts, Results& results);
+
+// names of the results that make up the CPU cost of a single login
+namespace login_cost {
+
+const char* const SERVER_EPHEMERAL  = "srp6 server ephemeral (B), 256-bit";
+const char* const SESSION_KEY       = "srp6 server session key, 256-bit";
+const char* const CLIENT_PROOF      = "srp6 client proof verification";
+const char* const SERVER_PROOF      = "srp6 server proof";
+const char* const INTEGRITY         = "integrity HMAC-SHA1 checksum";
+
+} // login_cost
+
+}} // bench, ember
\ No newline at end of file
@@ -0,0 +1,284 @@
+/*
+ * Copyright (c) 2016 Ember
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "Benchmark.h"
+#include <conpool/ConnectionPool.h>
+#include <conpool/Policies.h>
+#include <conpool/drivers/DummyDriver.h>
+#include <conpool/drivers/DummyConnection.h>
+#include <shared/threading/Semaphore.h>
+#include <shared/threading/Spinlock.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace ember { namespace bench {
+
+namespace {
+
+namespace ep = connection_pool;
+using namespace std::chrono_literals;
+
+typedef ep::ConnDetail<DummyConnection> Detail;
+
+// the original spinlock and linear scan checkout, kept as a baseline
+class ScanPool {
+	drivers::DummyDriver& driver_;
+	Spinlock lock_;
+	std::vector<Detail> pool_;
+	std::vector<std::atomic<bool>> pool_guards_;
+	Semaphore<std::mutex> semaphore_;
+
+	bool find_free_connection(Detail& cd) {
+		if(pool_guards_[cd.id].load(std::memory_order_relaxed)) {
+			return false;
+		}
+
+		std::atomic_thread_fence(std::memory_order_acquire);
+
+		if(!cd.error && !cd.sweep && !cd.empty_slot) {
+			cd.checked_out = true;
+			cd.idle = 0s;
+			pool_guards_[cd.id].store(true, std::memory_order_relaxed);
+			return true;
+		}
+
+		return false;
+	}
+
+public:
+	ScanPool(drivers::DummyDriver& driver, std::size_t size)
+	         : driver_(driver), pool_guards_(size) {
+		for(unsigned int i = 0; i < size; ++i) {
+			pool_.emplace_back(driver.open(), i);
+		}
+	}
+
+	Detail* checkout() {
+		std::lock_guard<Spinlock> guard(lock_);
+
+		auto res = std::find_if(pool_.begin(), pool_.end(), [&](Detail& cd) {
+			return find_free_connection(cd);
+		});
+
+		if(res == pool_.end()) {
+			return nullptr;
+		}
+
+		driver_.thread_enter();
+		return &*res;
+	}
+
+	void checkin(Detail& detail) {
+		driver_.clean(detail.conn);
+		detail.checked_out = false;
+		std::atomic_thread_fence(std::memory_order_release);
+		pool_guards_[detail.id].store(false, std::memory_order_relaxed);
+		driver_.thread_exit();
+		semaphore_.signal();
+	}
+};
+
+/*
+ * The free-list checkout stripped of everything else the pool does, for
+ * comparing the two checkout strategies like for like
+ */
+class ListPool {
+	drivers::DummyDriver& driver_;
+	std::vector<Detail> pool_;
+	std::vector<std::atomic<bool>> pool_guards_;
+	ep::FreeList free_;
+	Semaphore<std::mutex> semaphore_;
+
+public:
+	ListPool(drivers::DummyDriver& driver, std::size_t size)
+	         : driver_(driver), pool_guards_(size), free_(size) {
+		for(unsigned int i = 0; i < size; ++i) {
+			pool_.emplace_back(driver.open(), i);
+			free_.push(i);
+		}
+	}
+
+	Detail* checkout() {
+		std::uint32_t slot;
+
+		while(free_.pop(slot)) {
+			bool available = false;
+
+			if(pool_guards_[slot].compare_exchange_strong(available, true, std::memory_order_acquire)) {
+				pool_[slot].checked_out = true;
+				pool_[slot].idle = 0s;
+				driver_.thread_enter();
+				return &pool_[slot];
+			}
+		}
+
+		return nullptr;
+	}
+
+	void checkin(Detail& detail) {
+		driver_.clean(detail.conn);
+		detail.checked_out = false;
+		pool_guards_[detail.id].store(false, std::memory_order_release);
+		free_.push(detail.id);
+		driver_.thread_exit();
+		semaphore_.signal();
+	}
+};
+
+/*
+ * Times the function running concurrently on each thread, giving the
+ * combined throughput. Threads are released together so none of them
+ * gets a head start on an uncontended pool.
+ */
+template<typename Func>
+Result measure_threads(std::string name, std::size_t threads, std::size_t iterations, Func func) {
+	std::atomic<bool> go { false };
+	std::vector<std::thread> workers;
+
+	for(std::size_t t = 0; t < threads; ++t) {
+		workers.emplace_back([&] {
+			while(!go) {
+				std::this_thread::yield();
+			}
+
+			for(std::size_t i = 0; i < iterations; ++i) {
+				func();
+			}
+		});
+	}
+
+	const auto start = std::chrono::steady_clock::now();
+	go = true;
+
+	for(auto& worker : workers) {
+		worker.join();
+	}
+
+	const auto elapsed = std::chrono::steady_clock::now() - start;
+	return { std::move(name), iterations * threads, elapsed };
+}
+
+/*
+ * Checkouts can lose races with each other even when there should be enough
+ * connections to go round, so failures are counted rather than left to take
+ * the benchmark down
+ */
+template<typename PoolType>
+auto checkout(PoolType& pool, std::atomic<std::size_t>& failures) {
+	return [&pool, &failures] {
+		try {
+			pool.wait_connection(5s);
+		} catch(const ep::no_free_connections&) {
+			++failures;
+		}
+	};
+}
+
+void flag_failures(Result& result, const std::atomic<std::size_t>& failures) {
+	if(failures) {
+		result.name += " (" + std::to_string(failures) + " failed checkouts)";
+	}
+}
+
+} // unnamed
+
+void conpool_suite(const Options& opts, Results& results) {
+	typedef ep::Pool<drivers::DummyDriver, ep::CheckinClean, ep::FixedSize> Pool;
+	typedef ep::Connection<DummyConnection> Connection;
+
+	const std::size_t CONNECTIONS = 32;
+	const std::size_t iterations = opts.iterations * 100;
+	drivers::DummyDriver driver;
+
+	/*
+	 * Models a busy pool - everything the benchmark threads aren't using is
+	 * held for the duration, as it would be by slow queries on other threads,
+	 * so checkouts have to look past it. The bare strategies are timed first,
+	 * then the pool itself with the cost of its connection handles included.
+	 */
+	for(std::size_t threads : { 1, 4, 16, 32 }) {
+		const std::size_t held = CONNECTIONS - threads;
+		const std::string suffix = ", " + std::to_string(threads) + " threads, "
+			+ std::to_string(held) + "/" + std::to_string(CONNECTIONS) + " held";
+
+		ScanPool scan(driver, CONNECTIONS);
+		std::vector<Detail*> scan_held;
+
+		for(std::size_t i = 0; i < held; ++i) {
+			scan_held.emplace_back(scan.checkout());
+		}
+
+		results.emplace_back(measure_threads("conpool linear scan checkout" + suffix, threads,
+		                                     iterations, [&] {
+			if(auto detail = scan.checkout()) {
+				scan.checkin(*detail);
+			}
+		}));
+
+		for(auto detail : scan_held) {
+			scan.checkin(*detail);
+		}
+
+		ListPool list(driver, CONNECTIONS);
+		std::vector<Detail*> list_held;
+
+		for(std::size_t i = 0; i < held; ++i) {
+			list_held.emplace_back(list.checkout());
+		}
+
+		results.emplace_back(measure_threads("conpool free-list checkout" + suffix, threads,
+		                                     iterations, [&] {
+			if(auto detail = list.checkout()) {
+				list.checkin(*detail);
+			}
+		}));
+
+		for(auto detail : list_held) {
+			list.checkin(*detail);
+		}
+
+		for(bool affinity : { false, true }) {
+			Pool pool(driver, CONNECTIONS, CONNECTIONS, 300s);
+			pool.thread_affinity(affinity);
+			std::vector<Connection> pool_held;
+
+			for(std::size_t i = 0; i < held; ++i) {
+				pool_held.emplace_back(pool.get_connection());
+			}
+
+			const std::string name = affinity? "conpool pool, thread affinity" : "conpool pool";
+			std::atomic<std::size_t> failures { 0 };
+
+			results.emplace_back(measure_threads(name + suffix, threads, iterations,
+			                                     checkout(pool, failures)));
+			flag_failures(results.back(), failures);
+		}
+	}
+
+	// more threads than connections, so most checkouts queue for a hand-off
+	for(std::size_t threads : { 8, 32 }) {
+		const std::size_t connections = 4;
+		Pool pool(driver, connections, connections, 300s);
+		std::atomic<std::size_t> failures { 0 };
+
+		results.emplace_back(measure_threads("conpool exhausted wait, " + std::to_string(threads)
+		                                     + " threads, " + std::to_string(connections)
+		                                     + " connections", threads, iterations / 10,
+		                                     checkout(pool, failures)));
+		flag_failures(results.back(), failures);
+	}
+}
+
+}} // bench, ember
\ No newline at end of file
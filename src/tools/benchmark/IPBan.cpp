@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) 2016 Ember
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "Benchmark.h"
+#include <shared/IPBanCache.h>
+#include <boost/asio/ip/address.hpp>
+#include <random>
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace ember { namespace bench {
+
+namespace {
+
+namespace ip = boost::asio::ip;
+
+// the original linear scan, kept as a baseline
+class LinearBanList {
+	struct Entry {
+		std::uint32_t range;
+		std::uint32_t mask;
+	};
+
+	std::vector<Entry> entries_;
+
+public:
+	explicit LinearBanList(const std::vector<IPEntry>& bans) {
+		for(auto& ban : bans) {
+			auto address = ip::address::from_string(ban.first).to_v4().to_ulong();
+			std::uint32_t mask = ban.second? (~0U) << (32 - ban.second) : 0;
+			entries_.push_back({ static_cast<std::uint32_t>(address), mask });
+		}
+	}
+
+	bool is_banned(const ip::address_v4& address) const {
+		const auto ip_long = address.to_ulong();
+
+		for(auto& e : entries_) {
+			if((ip_long & e.mask) == (e.range & e.mask)) {
+				return true;
+			}
+		}
+
+		return false;
+	}
+};
+
+// abuse lists are mostly single hosts and /24s with a scattering of larger ranges
+std::vector<IPEntry> generate_v4_bans(std::mt19937& rng, std::size_t count) {
+	const std::uint32_t cidrs[] = { 32, 32, 32, 32, 24, 24, 24, 16, 20, 28 };
+	std::vector<IPEntry> bans;
+
+	for(std::size_t i = 0; i < count; ++i) {
+		bans.emplace_back(ip::address_v4(rng()).to_string(), cidrs[rng() % 10]);
+	}
+
+	return bans;
+}
+
+std::vector<IPEntry> generate_v6_bans(std::mt19937& rng, std::size_t count) {
+	const std::uint32_t cidrs[] = { 128, 64, 64, 64, 56, 48, 48, 32 };
+	std::vector<IPEntry> bans;
+
+	for(std::size_t i = 0; i < count; ++i) {
+		ip::address_v6::bytes_type bytes;
+
+		for(auto& byte : bytes) {
+			byte = static_cast<std::uint8_t>(rng());
+		}
+
+		bans.emplace_back(ip::address_v6(bytes).to_string(), cidrs[rng() % 8]);
+	}
+
+	return bans;
+}
+
+} // unnamed
+
+void ip_ban_suite(const Options& opts, Results& results) {
+	std::mt19937 rng(5875);
+	volatile bool banned; // keeps the lookups from being optimised out
+	std::vector<ip::address> v4_clients, v6_clients;
+
+	for(std::size_t i = 0; i < 1024; ++i) {
+		v4_clients.emplace_back(ip::address_v4(rng()));
+		ip::address_v6::bytes_type bytes;
+
+		for(auto& byte : bytes) {
+			byte = static_cast<std::uint8_t>(rng());
+		}
+
+		v6_clients.emplace_back(ip::address_v6(bytes));
+	}
+
+	for(std::size_t count : { 100, 1000, 10000, 50000 }) {
+		const auto bans = generate_v4_bans(rng, count);
+		const std::string suffix = ", " + std::to_string(count) + " IPv4 ranges";
+
+		LinearBanList linear(bans);
+		IPBanCache trie(bans);
+		std::size_t i = 0;
+
+		results.emplace_back(measure("ip ban linear scan" + suffix, opts.iterations, [&] {
+			banned = linear.is_banned(v4_clients[i++ % v4_clients.size()].to_v4());
+		}));
+
+		results.emplace_back(measure("ip ban prefix trie" + suffix, opts.iterations, [&] {
+			banned = trie.is_banned(v4_clients[i++ % v4_clients.size()]);
+		}));
+	}
+
+	IPBanCache v6_trie(generate_v6_bans(rng, 10000));
+	std::size_t i = 0;
+
+	results.emplace_back(measure("ip ban prefix trie, 10000 IPv6 ranges", opts.iterations, [&] {
+		banned = v6_trie.is_banned(v6_clients[i++ % v6_clients.size()]);
+	}));
+}
+
+}} // bench, ember
\ No newline at end of file
@@ -0,0 +1,43 @@
+/*
+ * Copyright (c) 2016 Ember
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "Benchmark.h"
+#include <login/ExecutablesChecksum.h>
+#include <botan/auto_rng.h>
+#include <botan/secmem.h>
+#include <algorithm>
+#include <array>
+#include <vector>
+#include <cstdint>
+
+namespace ember { namespace bench {
+
+void integrity_suite(const Options& opts, Results& results) {
+	Botan::AutoSeeded_RNG rng;
+
+	// contents don't matter, only the size - real builds are several megabytes
+	const std::vector<char> buffer(opts.binary_size, 'E');
+	BinaryView binaries;
+	binaries.append(buffer.data(), buffer.size());
+	const auto salt = rng.random_vec(16);
+	const std::array<std::uint8_t, 16> client_salt {};
+
+	// hashing megabytes per op, so there's no point running this as often as the others
+	const std::size_t iterations = std::max<std::size_t>(opts.iterations / 100, 10);
+
+	results.emplace_back(measure(login_cost::INTEGRITY, iterations, [&] {
+		auto checksum = client_integrity::checksum(salt, binaries);
+		client_integrity::finalise(checksum, client_salt.data(), client_salt.size());
+	}));
+
+	results.emplace_back(measure("integrity salt RNG construction", opts.iterations, [&] {
+		Botan::AutoSeeded_RNG().random_vec(16);
+	}));
+}
+
+}} // bench, ember
\ No newline at end of file
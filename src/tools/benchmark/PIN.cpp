@@ -0,0 +1,42 @@
+/*
+ * Copyright (c) 2016 Ember
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "Benchmark.h"
+#include <login/PINAuthenticator.h>
+#include <logger/Logging.h>
+#include <array>
+#include <string>
+#include <cstdint>
+
+namespace ember { namespace bench {
+
+void pin_suite(const Options& opts, Results& results) {
+	log::Logger logger;
+	PINAuthenticator auth(&logger);
+	const std::string totp_key("JBSWY3DPEHPK3PXP");
+	const std::array<std::uint8_t, 20> client_hash {};
+
+	auth.grid_seed();
+	auth.server_salt();
+	auth.set_client_salt({});
+	auth.set_client_hash(client_hash);
+
+	results.emplace_back(measure("PIN TOTP generation", opts.iterations, [&] {
+		PINAuthenticator::generate_totp_pin(totp_key, 0);
+	}));
+
+	// mirrors the handler, which tries the previous, current and next intervals
+	results.emplace_back(measure("PIN TOTP validation (3 intervals)", opts.iterations, [&] {
+		for(int interval = -1; interval < 2; ++interval) {
+			auth.set_pin(PINAuthenticator::generate_totp_pin(totp_key, interval));
+			auth.validate_pin(client_hash);
+		}
+	}));
+}
+
+}} // bench, ember
\ No newline at end of file
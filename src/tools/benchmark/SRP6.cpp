@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2016 Ember
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "Benchmark.h"
+#include <srp6/Client.h>
+#include <srp6/Generator.h>
+#include <srp6/Server.h>
+#include <srp6/Util.h>
+#include <botan/auto_rng.h>
+#include <botan/bigint.h>
+#include <botan/numthry.h>
+#include <algorithm>
+#include <string>
+#include <utility>
+
+namespace ember { namespace bench {
+
+namespace {
+
+const std::pair<srp6::Generator::Group, const char*> groups[] = {
+	{ srp6::Generator::Group::_256_BIT,  "256-bit"  },
+	{ srp6::Generator::Group::_1024_BIT, "1024-bit" },
+	{ srp6::Generator::Group::_1536_BIT, "1536-bit" },
+	{ srp6::Generator::Group::_2048_BIT, "2048-bit" },
+	{ srp6::Generator::Group::_3072_BIT, "3072-bit" },
+	{ srp6::Generator::Group::_4096_BIT, "4096-bit" },
+	{ srp6::Generator::Group::_6144_BIT, "6144-bit" },
+	{ srp6::Generator::Group::_8192_BIT, "8192-bit" }
+};
+
+// the larger groups are far slower - keep the total run time reasonable
+std::size_t scale(std::size_t iterations, const srp6::Generator& gen) {
+	const std::size_t factor = gen.prime().bits() / 256;
+	return std::max<std::size_t>(iterations / (factor * factor), 10);
+}
+
+void generator_bench(const Options& opts, Results& results) {
+	Botan::AutoSeeded_RNG rng;
+	const Botan::BigInt exponent = Botan::BigInt::decode(rng.random_vec(32));
+
+	for(auto& group : groups) {
+		const srp6::Generator gen(group.first);
+		const auto iterations = scale(opts.iterations, gen);
+		const std::string suffix = std::string(", ") + group.second;
+
+		results.emplace_back(measure("srp6 g^x fixed-base" + suffix, iterations, [&] {
+			gen(exponent);
+		}));
+
+		results.emplace_back(measure("srp6 g^x power_mod" + suffix, iterations, [&] {
+			Botan::power_mod(gen.generator(), exponent, gen.prime());
+		}));
+	}
+}
+
+} // unnamed
+
+void srp6_suite(const Options& opts, Results& results) {
+	generator_bench(opts, results);
+
+	// replicate the values used by a real login
+	const std::string username("CHAOSVEX");
+	const srp6::Generator gen(srp6::Generator::Group::_256_BIT);
+	const Botan::BigInt salt = srp6::generate_salt(32);
+	const Botan::BigInt verifier = srp6::generate_verifier(username, "ABC", gen, salt,
+	                                                       srp6::Compliance::GAME);
+
+	srp6::Client client(username, "ABC", gen);
+	srp6::Server server(gen, verifier);
+	const Botan::BigInt A = client.public_ephemeral();
+	const Botan::BigInt B = server.public_ephemeral();
+	const srp6::SessionKey key = server.session_key(A);
+	const Botan::BigInt client_proof = client.generate_proof(client.session_key(B, salt));
+
+	results.emplace_back(measure(login_cost::SERVER_EPHEMERAL, opts.iterations, [&] {
+		srp6::Server{ gen, verifier };
+	}));
+
+	results.emplace_back(measure("srp6 server ephemeral (B), precomputed", opts.iterations, [&] {
+		srp6::Server{ gen, verifier, srp6::PrecomputedEphemeral{ 1, 1 } };
+	}));
+
+	results.emplace_back(measure(login_cost::SESSION_KEY, opts.iterations, [&] {
+		server.session_key(A);
+	}));
+
+	results.emplace_back(measure(login_cost::CLIENT_PROOF, opts.iterations, [&] {
+		srp6::generate_client_proof(username, key, gen.prime(), gen.generator(), A, B, salt);
+	}));
+
+	results.emplace_back(measure(login_cost::SERVER_PROOF, opts.iterations, [&] {
+		server.generate_proof(key, client_proof);
+	}));
+
+	const auto S = srp6::detail::encode_flip(A);
+
+	results.emplace_back(measure("srp6 interleaved hash", opts.iterations, [&] {
+		srp6::detail::interleaved_hash(S);
+	}));
+
+	results.emplace_back(measure("srp6 verifier generation", opts.iterations, [&] {
+		srp6::generate_verifier(username, "ABC", gen, salt, srp6::Compliance::GAME);
+	}));
+}
+
+}} // bench, ember
\ No newline at end of file
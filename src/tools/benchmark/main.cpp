@@ -0,0 +1,137 @@
+/*
+ * Copyright (c) 2016 Ember
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "Benchmark.h"
+#include <shared/Banner.h>
+#include <boost/program_options.hpp>
+#include <algorithm>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <cstddef>
+
+namespace po = boost::program_options;
+namespace eb = ember::bench;
+
+typedef std::function<void(const eb::Options&, eb::Results&)> Suite;
+
+po::variables_map parse_arguments(int argc, const char* argv[]);
+void print_results(const eb::Results& results);
+void print_login_estimate(const eb::Results& results);
+
+const std::string APP_NAME = "Login Benchmarks";
+
+const std::vector<std::pair<std::string, Suite>> suites {
+	{ "srp6",      eb::srp6_suite      },
+	{ "integrity", eb::integrity_suite },
+	{ "pin",       eb::pin_suite       },
+	{ "ipban",     eb::ip_ban_suite    },
+	{ "conpool",   eb::conpool_suite   }
+};
+
+int main(int argc, const char* argv[]) try {
+	ember::print_banner(APP_NAME);
+
+	const po::variables_map args = parse_arguments(argc, argv);
+	const auto selected = args["suite"].as<std::vector<std::string>>();
+
+	const eb::Options opts {
+		args["iterations"].as<std::size_t>(),
+		args["binary_size"].as<std::size_t>()
+	};
+
+	eb::Results results;
+
+	for(auto& suite : suites) {
+		if(std::find(selected.begin(), selected.end(), suite.first) != selected.end()
+		   || std::find(selected.begin(), selected.end(), "all") != selected.end()) {
+			std::cout << "Running " << suite.first << " benchmarks..." << std::endl;
+			suite.second(opts, results);
+		}
+	}
+
+	print_results(results);
+	print_login_estimate(results);
+} catch(std::exception& e) {
+	std::cerr << e.what();
+	return 1;
+}
+
+void print_results(const eb::Results& results) {
+	std::cout << "\n" << std::left << std::setw(48) << "Benchmark"
+	          << std::right << std::setw(12) << "Iterations"
+	          << std::setw(16) << "us/op" << std::setw(16) << "ops/sec" << "\n";
+
+	for(auto& result : results) {
+		std::cout << std::left << std::setw(48) << result.name
+		          << std::right << std::setw(12) << result.iterations
+		          << std::setw(16) << std::fixed << std::setprecision(2)
+		          << result.seconds_per_op() * 1e6
+		          << std::setw(16) << std::setprecision(0) << result.ops_per_second() << "\n";
+	}
+}
+
+/*
+ * Sums the CPU cost of the operations a single full login performs to
+ * give the figure that login server hardware is sized on. The benchmarks
+ * are single-threaded, so this is per core.
+ */
+void print_login_estimate(const eb::Results& results) {
+	namespace lc = eb::login_cost;
+	const char* const components[] = {
+		lc::SERVER_EPHEMERAL, lc::SESSION_KEY, lc::CLIENT_PROOF, lc::SERVER_PROOF, lc::INTEGRITY
+	};
+
+	double seconds = 0.0;
+
+	for(auto component : components) {
+		auto it = std::find_if(results.begin(), results.end(), [&](const eb::Result& result) {
+			return result.name == component;
+		});
+
+		if(it == results.end()) {
+			std::cout << "\nRun the srp6 and integrity suites for a logins/sec/core estimate\n";
+			return;
+		}
+
+		seconds += it->seconds_per_op();
+	}
+
+	std::cout << "\nEstimated login CPU cost: " << std::setprecision(2) << seconds * 1e6 << "us\n"
+	          << "Estimated logins/sec/core: " << std::setprecision(0) << 1.0 / seconds << "\n"
+	          << "Estimated logins/sec (" << std::thread::hardware_concurrency() << " cores): "
+	          << std::thread::hardware_concurrency() / seconds << std::endl;
+}
+
+po::variables_map parse_arguments(int argc, const char* argv[]) {
+	po::options_description opts("Options");
+	opts.add_options()
+		("help", "Displays a list of available options")
+		("suite,s", po::value<std::vector<std::string>>()->multitoken()
+			->default_value({ "all" }, "all"),
+			"Suites to run - srp6, integrity, pin, ipban, conpool or all")
+		("iterations,i", po::value<std::size_t>()->default_value(1000),
+			"Base iteration count for each benchmark")
+		("binary_size,b", po::value<std::size_t>()->default_value(5 * 1024 * 1024),
+			"Bytes of client binaries to checksum, per login");
+
+	po::variables_map options;
+	po::store(po::command_line_parser(argc, argv).options(opts).run(), options);
+	po::notify(options);
+
+	if(options.count("help")) {
+		std::cout << opts << "\n";
+		std::exit(0);
+	}
+
+	return options;
+}
\ No newline at end of file
@@ -0,0 +1,30 @@
+/*
+ * Copyright (c) 2016 Ember
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "AccountStub.h"
+#include <account/FilterTypes.h>
+#include <cstddef>
+
+namespace ember { namespace loadgen {
+
+AccountStub::AccountStub(const std::string& address, std::uint16_t port, const std::string& mcast_iface,
+                         const std::string& mcast_group, std::uint16_t mcast_port, log::Logger* logger)
+                         : spark_("account", service_, address, port, logger, log::Filter(LF_SPARK)),
+                           discovery_(service_, address, port, mcast_iface, mcast_group, mcast_port,
+                                      logger, log::Filter(LF_SPARK)),
+                           sessions_(true), account_(sessions_, spark_, discovery_, logger) {
+	worker_ = std::thread(static_cast<std::size_t(boost::asio::io_service::*)()>
+		(&boost::asio::io_service::run), &service_);
+}
+
+AccountStub::~AccountStub() {
+	service_.stop();
+	worker_.join();
+}
+
+}} // loadgen, ember
\ No newline at end of file
@@ -0,0 +1,41 @@
+/*
+ * Copyright (c) 2016 Ember
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include <account/Service.h>
+#include <account/Sessions.h>
+#include <spark/Spark.h>
+#include <logger/Logging.h>
+#include <boost/asio/io_service.hpp>
+#include <string>
+#include <thread>
+#include <cstdint>
+
+namespace ember { namespace loadgen {
+
+/*
+ * Hosts the account service in-process so the login server under test has
+ * somewhere to register and look up session keys without a separate daemon.
+ * It's found through Spark's multicast discovery, as the real one would be.
+ */
+class AccountStub final {
+	boost::asio::io_service service_;
+	spark::Service spark_;
+	spark::ServiceDiscovery discovery_;
+	Sessions sessions_;
+	Service account_;
+	std::thread worker_;
+
+public:
+	AccountStub(const std::string& address, std::uint16_t port, const std::string& mcast_iface,
+	            const std::string& mcast_group, std::uint16_t mcast_port, log::Logger* logger);
+	~AccountStub();
+};
+
+}} // loadgen, ember
\ No newline at end of file
@@ -0,0 +1,435 @@
+/*
+ * Copyright (c) 2016 Ember
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "Client.h"
+#include <spark/buffers/BufferSequence.h>
+#include <srp6/Exception.h>
+#include <srp6/Util.h>
+#include <botan/auto_rng.h>
+#include <botan/sha160.h>
+#include <algorithm>
+#include <exception>
+#include <utility>
+
+namespace ember { namespace loadgen {
+
+Client::Client(boost::asio::io_service& service, const Config& config, Stats& stats, UserSource users)
+               : service_(service), socket_(service), timer_(service), config_(config), stats_(stats),
+                 users_(std::move(users)), step_(Step::CHALLENGE), expected_opcode_(),
+                 generation_(0), stopped_(false), survey_id_(0) { }
+
+void Client::start() {
+	auto self(shared_from_this());
+	service_.dispatch([this, self] { next_login(); });
+}
+
+void Client::stop() {
+	auto self(shared_from_this());
+
+	service_.dispatch([this, self] {
+		stopped_ = true;
+		reset_connection();
+	});
+}
+
+void Client::next_login() {
+	if(stopped_ || !users_(username_)) {
+		return;
+	}
+
+	stats_.attempt();
+	login_start_ = Stats::Clock::now();
+	connect(Step::CHALLENGE);
+}
+
+void Client::connect(Step step) {
+	reset_connection();
+
+	const auto generation = generation_;
+	auto self(shared_from_this());
+	step_start_ = Stats::Clock::now();
+	set_timer();
+
+	socket_.async_connect(config_.server, [this, self, generation, step](const boost::system::error_code& ec) {
+		if(generation != generation_) {
+			return;
+		}
+
+		if(ec) {
+			fail(Stats::Error::CONNECT);
+			return;
+		}
+
+		boost::system::error_code ignored;
+		socket_.set_option(boost::asio::ip::tcp::no_delay(true), ignored);
+		stats_.record(Stats::Phase::CONNECT, Stats::Clock::now() - step_start_);
+
+		read();
+		send_challenge(step == Step::CHALLENGE? grunt::Opcode::CMD_AUTH_LOGON_CHALLENGE :
+		                                         grunt::Opcode::CMD_AUTH_RECONNECT_CHALLENGE);
+	});
+}
+
+void Client::read() {
+	const auto generation = generation_;
+	auto self(shared_from_this());
+	auto tail = inbound_.back();
+
+	if(!tail->free()) {
+		tail = inbound_.allocate();
+		inbound_.push_back(tail);
+	}
+
+	socket_.async_receive(boost::asio::buffer(tail->write_data(), tail->free()),
+		[this, self, generation](const boost::system::error_code& ec, std::size_t size) {
+			if(generation != generation_) {
+				return;
+			}
+
+			if(ec) {
+				fail(Stats::Error::DISCONNECT);
+				return;
+			}
+
+			inbound_.advance_write_cursor(size);
+			handle_packets();
+
+			// handling the packet may have moved the login on to a new connection
+			if(generation == generation_) {
+				read();
+			}
+		}
+	);
+}
+
+void Client::write(std::shared_ptr<Chain> chain) {
+	const auto generation = generation_;
+	auto self(shared_from_this());
+	spark::BufferSequence<1024> sequence(*chain);
+
+	socket_.async_send(sequence,
+		[this, self, chain, generation](const boost::system::error_code& ec, std::size_t size) {
+			if(generation != generation_) {
+				return;
+			}
+
+			if(ec) {
+				fail(Stats::Error::DISCONNECT);
+				return;
+			}
+
+			chain->skip(size);
+
+			if(chain->size()) {
+				write(chain);
+			}
+		}
+	);
+}
+
+void Client::send(const grunt::Packet& packet, Step step) {
+	auto chain = std::make_shared<Chain>();
+	spark::BinaryStream stream(*chain);
+	packet.write_to_stream(stream);
+	expect(step);
+	write(chain);
+}
+
+void Client::expect(Step step) {
+	step_ = step;
+	step_start_ = Stats::Clock::now();
+
+	switch(step) {
+		case Step::CHALLENGE:
+			packet_ = std::make_unique<grunt::server::LoginChallenge>();
+			break;
+		case Step::PROOF:
+			packet_ = std::make_unique<grunt::server::LoginProof>();
+			break;
+		case Step::PATCH:
+		case Step::SURVEY:
+			packet_ = std::make_unique<grunt::server::TransferInitiate>();
+			break;
+		case Step::REALM_LIST:
+		case Step::RECONNECT_REALM_LIST:
+			packet_ = std::make_unique<grunt::server::RealmList>();
+			break;
+		case Step::RECONNECT_CHALLENGE:
+			packet_ = std::make_unique<grunt::server::ReconnectChallenge>();
+			break;
+		case Step::RECONNECT_PROOF:
+			packet_ = std::make_unique<grunt::server::ReconnectProof>();
+			break;
+	}
+
+	expected_opcode_ = packet_->opcode;
+	set_timer();
+}
+
+void Client::set_timer() {
+	const auto generation = generation_;
+	auto self(shared_from_this());
+
+	timer_.expires_from_now(config_.timeout);
+	timer_.async_wait([this, self, generation](const boost::system::error_code& ec) {
+		if(ec || generation != generation_) { // cancelled or rearmed for the next step
+			return;
+		}
+
+		fail(Stats::Error::TIMEOUT);
+	});
+}
+
+void Client::handle_packets() {
+	const auto generation = generation_;
+
+	// the server can send a follow-up (such as a transfer after the proof) before we've replied
+	while(!inbound_.empty() && generation == generation_) {
+		if(!packet_) {
+			fail(Stats::Error::BAD_PACKET);
+			return;
+		}
+
+		spark::SafeBinaryStream stream(inbound_);
+
+		try {
+			if(packet_->read_from_stream(stream) != grunt::Packet::State::DONE) {
+				return;
+			}
+		} catch(const std::exception&) {
+			fail(Stats::Error::BAD_PACKET);
+			return;
+		}
+
+		if(packet_->opcode != expected_opcode_) {
+			fail(Stats::Error::BAD_PACKET);
+			return;
+		}
+
+		auto packet = std::move(packet_);
+		handle_packet(*packet, Stats::Clock::now() - step_start_);
+	}
+}
+
+void Client::handle_packet(const grunt::Packet& packet, Stats::Clock::duration elapsed) {
+	switch(step_) {
+		case Step::CHALLENGE:
+			stats_.record(Stats::Phase::CHALLENGE, elapsed);
+			on_challenge(static_cast<const grunt::server::LoginChallenge&>(packet));
+			break;
+		case Step::PROOF:
+			stats_.record(Stats::Phase::PROOF, elapsed);
+			on_login_proof(static_cast<const grunt::server::LoginProof&>(packet));
+			break;
+		case Step::PATCH:
+		case Step::SURVEY:
+			on_transfer(static_cast<const grunt::server::TransferInitiate&>(packet));
+			break;
+		case Step::REALM_LIST:
+			stats_.record(Stats::Phase::REALM_LIST, elapsed);
+			on_realm_list();
+			break;
+		case Step::RECONNECT_CHALLENGE:
+			stats_.record(Stats::Phase::RECONNECT_CHALLENGE, elapsed);
+			on_reconnect_challenge(static_cast<const grunt::server::ReconnectChallenge&>(packet));
+			break;
+		case Step::RECONNECT_PROOF:
+			stats_.record(Stats::Phase::RECONNECT_PROOF, elapsed);
+			on_reconnect_proof(static_cast<const grunt::server::ReconnectProof&>(packet));
+			break;
+		case Step::RECONNECT_REALM_LIST:
+			stats_.record(Stats::Phase::RECONNECT_REALM_LIST, elapsed);
+			on_realm_list();
+			break;
+	}
+}
+
+void Client::send_challenge(grunt::Opcode opcode) {
+	const bool reconnect = opcode == grunt::Opcode::CMD_AUTH_RECONNECT_CHALLENGE;
+
+	grunt::client::LoginChallenge challenge;
+	challenge.opcode = opcode;
+	challenge.protocol_ver = reconnect? grunt::client::LoginChallenge::RECONNECT_CHALLENGE_VER :
+	                                    grunt::client::LoginChallenge::CHALLENGE_VER;
+	challenge.game = grunt::Game::WoW;
+	challenge.version = config_.version;
+	challenge.platform = grunt::Platform::x86;
+	challenge.os = grunt::System::Win;
+	challenge.locale = config_.locale;
+	challenge.username = username_;
+
+	boost::system::error_code ec;
+	const auto local = socket_.local_endpoint(ec).address();
+
+	if(!ec && local.is_v4()) {
+		challenge.ip = local.to_v4().to_ulong();
+	}
+
+	send(challenge, reconnect? Step::RECONNECT_CHALLENGE : Step::CHALLENGE);
+}
+
+void Client::on_challenge(const grunt::server::LoginChallenge& packet) {
+	// a patch transfer follows but there's nothing to gain from downloading it thousands of times
+	if(packet.result == grunt::Result::FAIL_VERSION_UPDATE) {
+		stats_.failure(packet.result);
+		expect(Step::PATCH);
+		return;
+	}
+
+	if(packet.result != grunt::Result::SUCCESS) {
+		fail(packet.result);
+		return;
+	}
+
+	if(packet.two_factor_auth) {
+		fail(Stats::Error::UNSUPPORTED);
+		return;
+	}
+
+	try {
+		// seeded accounts use the username as the password
+		srp6::Generator generator(Botan::BigInt(packet.g), packet.N);
+		srp6::Client client(username_, username_, generator);
+		key_ = client.session_key(packet.B, packet.s);
+		A_ = client.public_ephemeral();
+		M1_ = client.generate_proof(key_);
+	} catch(const srp6::exception&) {
+		fail(Stats::Error::BAD_PACKET);
+		return;
+	}
+
+	grunt::client::LoginProof proof;
+	proof.A = A_;
+	proof.M1 = M1_;
+	proof.client_checksum.fill(0); // the server needs integrity checking disabled
+	send(proof, Step::PROOF);
+}
+
+void Client::on_login_proof(const grunt::server::LoginProof& packet) {
+	if(packet.result != grunt::Result::SUCCESS) {
+		fail(packet.result);
+		return;
+	}
+
+	if(packet.M2 != srp6::generate_server_proof(A_, M1_, key_)) {
+		fail(Stats::Error::BAD_SERVER_PROOF);
+		return;
+	}
+
+	if(packet.survey_id) {
+		survey_id_ = packet.survey_id;
+		expect(Step::SURVEY);
+		return;
+	}
+
+	request_realms(Step::REALM_LIST);
+}
+
+void Client::on_transfer(const grunt::server::TransferInitiate& packet) {
+	if(step_ == Step::PATCH) {
+		stats_.patch_offered();
+		finish(false);
+		return;
+	}
+
+	// decline the survey download but send a result anyway so the server's write path is exercised
+	auto chain = std::make_shared<Chain>();
+	spark::BinaryStream stream(*chain);
+
+	grunt::client::TransferCancel cancel;
+	cancel.write_to_stream(stream);
+
+	grunt::client::SurveyResult result;
+	result.survey_id = survey_id_;
+	result.data = "login_loadgen";
+	result.write_to_stream(stream);
+
+	grunt::client::RequestRealmList request;
+	request.write_to_stream(stream);
+
+	stats_.survey_sent();
+	expect(Step::REALM_LIST);
+	write(chain);
+}
+
+void Client::on_reconnect_challenge(const grunt::server::ReconnectChallenge& packet) {
+	if(packet.result != grunt::Result::SUCCESS) {
+		fail(packet.result);
+		return;
+	}
+
+	grunt::client::ReconnectProof proof;
+	Botan::AutoSeeded_RNG().randomize(proof.salt.data(), proof.salt.size());
+	proof.client_checksum.fill(0);
+
+	// the account service hands the key back to the login server as an integer, dropping leading zeroes
+	Botan::SHA_160 hasher;
+	hasher.update(username_);
+	hasher.update(proof.salt.data(), proof.salt.size());
+	hasher.update(packet.salt.data(), packet.salt.size());
+	hasher.update(Botan::BigInt::encode(Botan::BigInt::decode(key_.t.data(), key_.t.size())));
+	const auto digest = hasher.final();
+	std::copy(digest.begin(), digest.end(), proof.proof.begin());
+
+	send(proof, Step::RECONNECT_PROOF);
+}
+
+void Client::on_reconnect_proof(const grunt::server::ReconnectProof& packet) {
+	if(packet.result != grunt::Result::SUCCESS) {
+		fail(packet.result);
+		return;
+	}
+
+	request_realms(Step::RECONNECT_REALM_LIST);
+}
+
+void Client::request_realms(Step step) {
+	send(grunt::client::RequestRealmList(), step);
+}
+
+void Client::on_realm_list() {
+	if(step_ == Step::REALM_LIST && config_.reconnect) {
+		connect(Step::RECONNECT_CHALLENGE);
+		return;
+	}
+
+	finish(true);
+}
+
+void Client::fail(Stats::Error error) {
+	stats_.error(error);
+	finish(false);
+}
+
+void Client::fail(grunt::Result result) {
+	stats_.failure(result);
+	finish(false);
+}
+
+void Client::finish(bool success) {
+	if(success) {
+		stats_.login_complete(Stats::Clock::now() - login_start_);
+	}
+
+	reset_connection();
+	next_login();
+}
+
+void Client::reset_connection() {
+	++generation_;
+
+	boost::system::error_code ec; // we don't care about any errors
+	socket_.shutdown(boost::asio::ip::tcp::socket::shutdown_both, ec);
+	socket_.close(ec);
+	timer_.cancel(ec);
+
+	inbound_.skip(inbound_.size());
+	packet_.reset();
+}
+
+}} // loadgen, ember
\ No newline at end of file
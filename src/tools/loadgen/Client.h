@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) 2016 Ember
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include "Stats.h"
+#include <login/GameVersion.h>
+#include <login/grunt/Packets.h>
+#include <login/grunt/Magic.h>
+#include <spark/buffers/ChainedBuffer.h>
+#include <srp6/Client.h>
+#include <botan/bigint.h>
+#include <boost/asio.hpp>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <cstdint>
+
+namespace ember { namespace loadgen {
+
+/*
+ * Plays the part of a game client, performing full logins back to back on
+ * a single connection at a time until it runs out of accounts. Each login
+ * runs through the challenge, proof and realm list, optionally followed by
+ * a reconnect on a fresh connection. Patch offers are counted and dropped,
+ * surveys are answered.
+ *
+ * Not thread-safe - each client has to stay on a single-threaded service.
+ */
+class Client final : public std::enable_shared_from_this<Client> {
+public:
+	struct Config {
+		boost::asio::ip::tcp::endpoint server;
+		GameVersion version;
+		grunt::Locale locale;
+		bool reconnect;
+		std::chrono::milliseconds timeout;
+	};
+
+	// fills in the next account to log in with, returning false when there are none left
+	typedef std::function<bool(std::string&)> UserSource;
+
+private:
+	typedef spark::ChainedBuffer<1024> Chain;
+
+	enum class Step {
+		CHALLENGE, PROOF, PATCH, SURVEY, REALM_LIST,
+		RECONNECT_CHALLENGE, RECONNECT_PROOF, RECONNECT_REALM_LIST
+	};
+
+	boost::asio::io_service& service_;
+	boost::asio::ip::tcp::socket socket_;
+	boost::asio::basic_waitable_timer<std::chrono::steady_clock> timer_;
+	Chain inbound_;
+	const Config& config_;
+	Stats& stats_;
+	UserSource users_;
+
+	Step step_;
+	std::unique_ptr<grunt::Packet> packet_;
+	grunt::Opcode expected_opcode_;
+	std::uint64_t generation_; // handlers from an earlier connection check this and bail
+	bool stopped_;
+
+	std::string username_;
+	srp6::SessionKey key_;
+	Botan::BigInt A_, M1_;
+	std::uint32_t survey_id_;
+	Stats::Clock::time_point login_start_, step_start_;
+
+	void next_login();
+	void connect(Step step);
+	void read();
+	void write(std::shared_ptr<Chain> chain);
+	void send(const grunt::Packet& packet, Step step);
+	void expect(Step step);
+	void set_timer();
+	void handle_packets();
+	void handle_packet(const grunt::Packet& packet, Stats::Clock::duration elapsed);
+
+	void send_challenge(grunt::Opcode opcode);
+	void on_challenge(const grunt::server::LoginChallenge& packet);
+	void on_login_proof(const grunt::server::LoginProof& packet);
+	void on_transfer(const grunt::server::TransferInitiate& packet);
+	void on_reconnect_challenge(const grunt::server::ReconnectChallenge& packet);
+	void on_reconnect_proof(const grunt::server::ReconnectProof& packet);
+	void on_realm_list();
+	void request_realms(Step step);
+
+	void fail(Stats::Error error);
+	void fail(grunt::Result result);
+	void finish(bool success);
+	void reset_connection();
+
+public:
+	Client(boost::asio::io_service& service, const Config& config, Stats& stats, UserSource users);
+
+	void start();
+	void stop();
+};
+
+}} // loadgen, ember
\ No newline at end of file
@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) 2016 Ember
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "Stats.h"
+#include <iomanip>
+#include <string>
+
+namespace ember { namespace loadgen {
+
+namespace {
+
+const char* const phase_names[] = {
+	"connect", "challenge", "proof", "realm_list",
+	"reconnect_challenge", "reconnect_proof", "reconnect_realm_list",
+	"login"
+};
+
+const char* const error_names[] = {
+	"connect failed", "disconnected", "timed out", "bad packet", "bad server proof",
+	"unsupported (PIN)"
+};
+
+static_assert(sizeof(phase_names) / sizeof(phase_names[0]) == Stats::PHASES, "Missing phase names");
+static_assert(sizeof(error_names) / sizeof(error_names[0]) == Stats::ERRORS, "Missing error names");
+
+} // unnamed
+
+Stats::Stats() : logins_(0), attempts_(0), patches_(0), surveys_(0) {
+	for(auto& error : errors_) {
+		error = 0;
+	}
+
+	for(auto& result : results_) {
+		result = 0;
+	}
+}
+
+void Stats::record(Phase phase, Clock::duration duration) {
+	phases_[static_cast<std::size_t>(phase)].record(duration);
+}
+
+void Stats::error(Error error) {
+	errors_[static_cast<std::size_t>(error)].fetch_add(1, std::memory_order_relaxed);
+}
+
+void Stats::failure(grunt::Result result) {
+	results_[static_cast<std::uint8_t>(result)].fetch_add(1, std::memory_order_relaxed);
+}
+
+void Stats::attempt() {
+	attempts_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Stats::login_complete(Clock::duration duration) {
+	record(Phase::LOGIN, duration);
+	logins_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Stats::patch_offered() {
+	patches_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Stats::survey_sent() {
+	surveys_.fetch_add(1, std::memory_order_relaxed);
+}
+
+std::uint64_t Stats::logins() const {
+	return logins_.load(std::memory_order_relaxed);
+}
+
+std::uint64_t Stats::attempts() const {
+	return attempts_.load(std::memory_order_relaxed);
+}
+
+void Stats::print(std::ostream& out, std::chrono::duration<double> elapsed) {
+	const auto seconds = elapsed.count() > 0? elapsed.count() : 1.0;
+
+	out << "\nAttempts: " << attempts() << ", completed: " << logins()
+	    << std::fixed << std::setprecision(1) << " (" << logins() / seconds << " logins/sec over "
+	    << elapsed.count() << "s)\n";
+	out << "Patches offered: " << patches_ << ", surveys sent: " << surveys_ << "\n";
+
+	out << "\n" << std::left << std::setw(24) << "Phase" << std::right
+	    << std::setw(10) << "Count" << std::setw(12) << "p50 (us)" << std::setw(12) << "p90 (us)"
+	    << std::setw(12) << "p99 (us)" << std::setw(12) << "max (us)" << "\n";
+
+	for(std::size_t i = 0; i < PHASES; ++i) {
+		const auto snapshot = phases_[i].reset();
+
+		if(!snapshot.count) {
+			continue;
+		}
+
+		out << std::left << std::setw(24) << phase_names[i] << std::right
+		    << std::setw(10) << snapshot.count
+		    << std::setw(12) << snapshot.percentile(50).count()
+		    << std::setw(12) << snapshot.percentile(90).count()
+		    << std::setw(12) << snapshot.percentile(99).count()
+		    << std::setw(12) << snapshot.max << "\n";
+	}
+
+	out << "\nErrors\n";
+	bool errors = false;
+
+	for(std::size_t i = 0; i < RESULTS; ++i) {
+		if(const auto count = results_[i].load()) {
+			out << "  " << std::left << std::setw(32)
+			    << grunt::to_string(static_cast<grunt::Result>(i)) << std::right << count << "\n";
+			errors = true;
+		}
+	}
+
+	for(std::size_t i = 0; i < ERRORS; ++i) {
+		if(const auto count = errors_[i].load()) {
+			out << "  " << std::left << std::setw(32) << error_names[i] << std::right << count << "\n";
+			errors = true;
+		}
+	}
+
+	if(!errors) {
+		out << "  none\n";
+	}
+}
+
+}} // loadgen, ember
\ No newline at end of file
@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) 2016 Ember
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include <login/grunt/ResultCodes.h>
+#include <shared/metrics/Histogram.h>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <ostream>
+#include <cstddef>
+#include <cstdint>
+
+namespace ember { namespace loadgen {
+
+/*
+ * Results shared between every simulated client. Recording doesn't lock so
+ * clients on different threads don't contend with each other between steps.
+ */
+class Stats final {
+public:
+	typedef std::chrono::steady_clock Clock;
+
+	enum class Phase {
+		CONNECT, CHALLENGE, PROOF, REALM_LIST,
+		RECONNECT_CHALLENGE, RECONNECT_PROOF, RECONNECT_REALM_LIST,
+		LOGIN, MAX
+	};
+
+	enum class Error {
+		CONNECT, DISCONNECT, TIMEOUT, BAD_PACKET, BAD_SERVER_PROOF, UNSUPPORTED, MAX
+	};
+
+	static const std::size_t PHASES = static_cast<std::size_t>(Phase::MAX);
+	static const std::size_t ERRORS = static_cast<std::size_t>(Error::MAX);
+	static const std::size_t RESULTS = 256;
+
+private:
+	std::array<Histogram, PHASES> phases_;
+	std::array<std::atomic<std::uint64_t>, ERRORS> errors_;
+	std::array<std::atomic<std::uint64_t>, RESULTS> results_;
+	std::atomic<std::uint64_t> logins_, attempts_, patches_, surveys_;
+
+public:
+	Stats();
+
+	void record(Phase phase, Clock::duration duration);
+	void error(Error error);
+	void failure(grunt::Result result);
+	void attempt();
+	void login_complete(Clock::duration duration);
+	void patch_offered();
+	void survey_sent();
+
+	std::uint64_t logins() const;
+	std::uint64_t attempts() const;
+
+	// drains the phase histograms, so should only be called once the run is over
+	void print(std::ostream& out, std::chrono::duration<double> elapsed);
+};
+
+}} // loadgen, ember
\ No newline at end of file
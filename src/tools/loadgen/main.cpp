@@ -0,0 +1,302 @@
+/*
+ * Copyright (c) 2016 Ember
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "AccountStub.h"
+#include "Client.h"
+#include "Stats.h"
+#include <shared/Banner.h>
+#include <shared/threading/ServicePool.h>
+#include <logger/ConsoleSink.h>
+#include <logger/Utility.h>
+#include <srp6/Generator.h>
+#include <srp6/Util.h>
+#include <botan/bigint.h>
+#include <botan/hex.h>
+#include <boost/program_options.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace po = boost::program_options;
+namespace el = ember::log;
+namespace lg = ember::loadgen;
+
+po::variables_map parse_arguments(int argc, const char* argv[]);
+void seed_users(const po::variables_map& args);
+void run(const po::variables_map& args);
+lg::Client::Config client_config(const po::variables_map& args);
+std::string user_prefix(const po::variables_map& args);
+
+const std::string APP_NAME = "Login Load Generator";
+
+/*
+ * Drives full logins against a running login server to find its capacity
+ * before production does. Accounts are seeded ahead of time with --seed,
+ * which writes SQL for the server's database rather than touching it directly.
+ */
+int main(int argc, const char* argv[]) try {
+	ember::print_banner(APP_NAME);
+
+	const po::variables_map args = parse_arguments(argc, argv);
+
+	if(args.count("seed")) {
+		seed_users(args);
+	} else {
+		run(args);
+	}
+} catch(std::exception& e) {
+	std::cerr << e.what();
+	return 1;
+}
+
+// the client uppercases usernames, so the accounts are created that way
+std::string user_prefix(const po::variables_map& args) {
+	auto prefix = args["user_prefix"].as<std::string>();
+	std::transform(prefix.begin(), prefix.end(), prefix.begin(), ::toupper);
+	return prefix;
+}
+
+/*
+ * Accounts use their username as the password so the clients don't need a
+ * copy of the credentials. Every nth account can be flagged to receive a
+ * survey after logging in.
+ */
+void seed_users(const po::variables_map& args) {
+	const auto path = args["seed"].as<std::string>();
+	const auto users = args["users"].as<std::uint64_t>();
+	const auto survey_every = args["survey_every"].as<std::uint64_t>();
+	const auto first = args["first_user"].as<std::uint64_t>();
+	const auto prefix = user_prefix(args);
+	const std::size_t BATCH_SIZE = 500;
+
+	std::ofstream out(path);
+
+	if(!out) {
+		throw std::runtime_error("Unable to open " + path + " for writing");
+	}
+
+	const ember::srp6::Generator gen(ember::srp6::Generator::Group::_256_BIT);
+
+	for(std::uint64_t i = 0; i < users; ++i) {
+		const auto user = prefix + std::to_string(first + i);
+
+		if(user.size() > 16) {
+			throw std::runtime_error("Username too long, " + user);
+		}
+
+		const auto salt = ember::srp6::generate_salt(32);
+		const auto verifier = ember::srp6::generate_verifier(user, user, gen, salt,
+		                                                     ember::srp6::Compliance::GAME);
+		const bool survey = survey_every && i % survey_every == 0;
+
+		if(i % BATCH_SIZE == 0) {
+			out << (i? ";\n" : "") << "INSERT INTO users (username, s, v, survey_request) VALUES\n";
+		} else {
+			out << ",\n";
+		}
+
+		out << "('" << user << "', '0x" << Botan::hex_encode(Botan::BigInt::encode(salt))
+		    << "', '0x" << Botan::hex_encode(Botan::BigInt::encode(verifier)) << "', b'"
+		    << survey << "')";
+	}
+
+	out << ";\n";
+	std::cout << "Wrote " << users << " accounts to " << path << std::endl;
+}
+
+lg::Client::Config client_config(const po::variables_map& args) {
+	const auto address = boost::asio::ip::address::from_string(args["host"].as<std::string>());
+	const auto version = args["version"].as<std::string>();
+	const auto locale_name = args["locale"].as<std::string>();
+
+	unsigned int major = 0, minor = 0, patch = 0;
+
+	if(std::sscanf(version.c_str(), "%u.%u.%u", &major, &minor, &patch) != 3) {
+		throw std::invalid_argument("Invalid client version, " + version);
+	}
+
+	auto locale = std::find_if(ember::grunt::Locale_list.begin(), ember::grunt::Locale_list.end(),
+		[&](ember::grunt::Locale locale) {
+			return ember::grunt::to_string(locale) == locale_name;
+		}
+	);
+
+	if(locale == ember::grunt::Locale_list.end()) {
+		throw std::invalid_argument("Unknown locale, " + locale_name);
+	}
+
+	return {
+		{ address, args["port"].as<std::uint16_t>() },
+		{
+			static_cast<std::uint8_t>(major), static_cast<std::uint8_t>(minor),
+			static_cast<std::uint8_t>(patch), args["build"].as<std::uint16_t>()
+		},
+		*locale,
+		args["reconnect"].as<bool>(),
+		std::chrono::milliseconds(args["timeout"].as<unsigned int>())
+	};
+}
+
+void run(const po::variables_map& args) {
+	const auto config = client_config(args);
+	const auto concurrency = args["clients"].as<std::size_t>();
+	const auto threads = args["threads"].as<std::size_t>();
+	const auto users = args["users"].as<std::uint64_t>();
+	const auto max_logins = args["logins"].as<std::uint64_t>();
+	const auto duration = std::chrono::seconds(args["duration"].as<unsigned int>());
+	const auto first = args["first_user"].as<std::uint64_t>();
+	const auto prefix = user_prefix(args);
+
+	if(!users || !concurrency) {
+		throw std::invalid_argument("Need at least one user and one client");
+	}
+
+	// the login server under test needs somewhere to store session keys
+	std::unique_ptr<el::Logger> logger;
+	std::unique_ptr<lg::AccountStub> account_stub;
+
+	if(args["account_stub"].as<bool>()) {
+		logger = std::make_unique<el::Logger>();
+		const auto severity = el::severity_string(args["verbosity"].as<std::string>());
+
+		if(severity != el::Severity::DISABLED) {
+			logger->add_sink(std::make_unique<el::ConsoleSink>(severity, el::Filter(0)));
+		}
+
+		std::cout << "Starting account service stub..." << std::endl;
+
+		account_stub = std::make_unique<lg::AccountStub>(
+			args["spark.address"].as<std::string>(), args["spark.port"].as<std::uint16_t>(),
+			args["spark.multicast_interface"].as<std::string>(),
+			args["spark.multicast_group"].as<std::string>(),
+			args["spark.multicast_port"].as<std::uint16_t>(), logger.get()
+		);
+	}
+
+	lg::Stats stats;
+	const auto start = lg::Stats::Clock::now();
+	const auto deadline = start + duration;
+	std::atomic<std::uint64_t> issued { 0 };
+	std::atomic<std::size_t> idle { 0 };
+
+	// clients go idle once the login count or the deadline is reached
+	auto next_user = [&](std::string& user) {
+		const auto index = issued++;
+
+		if((max_logins && index >= max_logins) || lg::Stats::Clock::now() >= deadline) {
+			++idle;
+			return false;
+		}
+
+		user = prefix + std::to_string(first + index % users);
+		return true;
+	};
+
+	ember::ServicePool pool(threads? threads : std::thread::hardware_concurrency());
+	std::vector<std::shared_ptr<lg::Client>> clients;
+
+	for(std::size_t i = 0; i < concurrency; ++i) {
+		clients.emplace_back(std::make_shared<lg::Client>(pool.get_service(), config, stats, next_user));
+		clients.back()->start();
+	}
+
+	std::cout << "Running " << concurrency << " clients against " << config.server << "..." << std::endl;
+	std::thread worker([&pool] { pool.run(); });
+	std::uint64_t last_logins = 0;
+
+	while(idle < clients.size()) {
+		std::this_thread::sleep_for(std::chrono::seconds(1));
+		const auto logins = stats.logins();
+		std::cout << logins - last_logins << " logins/sec (" << logins << " completed, "
+		          << stats.attempts() - logins << " failed or in flight)" << std::endl;
+		last_logins = logins;
+	}
+
+	const auto elapsed = lg::Stats::Clock::now() - start;
+
+	pool.stop();
+	worker.join();
+	clients.clear();
+
+	stats.print(std::cout, elapsed);
+}
+
+po::variables_map parse_arguments(int argc, const char* argv[]) {
+	po::options_description opts("Options");
+	opts.add_options()
+		("help", "Displays a list of available options")
+		("seed", po::value<std::string>(),
+			"Writes SQL to create the test accounts to this path and exits")
+		("users,u", po::value<std::uint64_t>()->default_value(1000),
+			"Number of test accounts, shared between clients")
+		("user_prefix", po::value<std::string>()->default_value("LOADGEN"),
+			"Test account username prefix, followed by the account's index")
+		("first_user", po::value<std::uint64_t>()->default_value(0),
+			"Index of the first test account")
+		("survey_every", po::value<std::uint64_t>()->default_value(0),
+			"Seeding only - flag every nth account for a survey, 0 for none")
+		("host,h", po::value<std::string>()->default_value("127.0.0.1"),
+			"Login server address")
+		("port,p", po::value<std::uint16_t>()->default_value(3724),
+			"Login server port")
+		("clients,c", po::value<std::size_t>()->default_value(100),
+			"Concurrent logins")
+		("threads,t", po::value<std::size_t>()->default_value(0),
+			"Client network threads, 0 for one per core")
+		("duration,d", po::value<unsigned int>()->default_value(30),
+			"Seconds to keep starting new logins for")
+		("logins,l", po::value<std::uint64_t>()->default_value(0),
+			"Stop after this many login attempts, 0 for no limit")
+		("timeout", po::value<unsigned int>()->default_value(10000),
+			"Milliseconds to wait for each server response")
+		("reconnect", po::value<bool>()->default_value(true),
+			"Reconnect with the session key after each login")
+		("version", po::value<std::string>()->default_value("1.12.1"),
+			"Client version to present - an older version exercises the patch path")
+		("build", po::value<std::uint16_t>()->default_value(5875),
+			"Client build to present")
+		("locale", po::value<std::string>()->default_value("enGB"),
+			"Client locale to present")
+		("account_stub", po::value<bool>()->default_value(false),
+			"Host an account service for the login server to use")
+		("spark.address", po::value<std::string>()->default_value("127.0.0.1"),
+			"Account service stub address")
+		("spark.port", po::value<std::uint16_t>()->default_value(6003),
+			"Account service stub port")
+		("spark.multicast_interface", po::value<std::string>()->default_value("0.0.0.0"),
+			"Account service stub discovery interface")
+		("spark.multicast_group", po::value<std::string>()->default_value("239.255.0.1"),
+			"Account service stub discovery group")
+		("spark.multicast_port", po::value<std::uint16_t>()->default_value(6000),
+			"Account service stub discovery port")
+		("verbosity,v", po::value<std::string>()->default_value("warning"),
+			"Account service stub log verbosity");
+
+	po::variables_map options;
+	po::store(po::command_line_parser(argc, argv).options(opts).run(), options);
+	po::notify(options);
+
+	if(options.count("help")) {
+		std::cout << opts << "\n";
+		std::exit(0);
+	}
+
+	return options;
+}
\ No newline at end of file
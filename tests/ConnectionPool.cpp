@@ -0,0 +1,415 @@
+/*
+ * Copyright (c) 2016 Ember
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <conpool/AsyncExecutor.h>
+#include <conpool/ConnectionPool.h>
+#include <conpool/Policies.h>
+#include <conpool/drivers/DummyDriver.h>
+#include <conpool/drivers/DummyConnection.h>
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <stdexcept>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <cstdint>
+
+namespace ep = ember::connection_pool;
+using namespace std::chrono_literals;
+
+typedef ep::Pool<ember::drivers::DummyDriver, ep::CheckinClean, ep::ExponentialGrowth> DummyPool;
+typedef ep::Pool<ember::drivers::DummyDriver, ep::CheckinClean, ep::FixedSize> FixedPool;
+
+TEST(ConnectionPool, CheckoutCheckin) {
+	ember::drivers::DummyDriver driver;
+	FixedPool pool(driver, 2, 2, 300s);
+
+	{
+		auto first = pool.get_connection();
+		auto second = pool.get_connection();
+		ASSERT_EQ(2, pool.checked_out());
+		ASSERT_THROW(pool.get_connection(), ep::no_free_connections);
+	}
+
+	ASSERT_EQ(0, pool.checked_out());
+
+	// returned connections should be reusable straight away
+	for(int i = 0; i < 10; ++i) {
+		auto conn = pool.get_connection();
+		ASSERT_EQ(1, pool.checked_out());
+	}
+
+	ASSERT_EQ(2, pool.size());
+}
+
+TEST(ConnectionPool, Growth) {
+	ember::drivers::DummyDriver driver;
+	DummyPool pool(driver, 0, 4, 300s);
+	ASSERT_EQ(0, pool.size());
+
+	std::vector<ep::Connection<ember::DummyConnection>> conns;
+
+	for(int i = 0; i < 4; ++i) {
+		conns.emplace_back(pool.get_connection());
+	}
+
+	ASSERT_EQ(4, pool.size());
+	ASSERT_THROW(pool.get_connection(), ep::no_free_connections);
+
+	conns.clear();
+	ASSERT_EQ(0, pool.checked_out());
+	ASSERT_GT(pool.contention().exhausted, 0);
+}
+
+TEST(ConnectionPool, ThreadAffinity) {
+	ember::drivers::DummyDriver driver;
+	FixedPool pool(driver, 4, 4, 300s);
+	pool.thread_affinity(true);
+
+	for(int i = 0; i < 100; ++i) {
+		auto conn = pool.get_connection();
+	}
+
+	// nothing else wants the connection, so the thread should always get it back
+	ASSERT_EQ(0, pool.contention().affinity_misses);
+
+	auto held = pool.get_connection();
+	std::thread other([&] {
+		auto conn = pool.get_connection();
+	});
+	other.join();
+
+	ASSERT_EQ(1, pool.checked_out());
+}
+
+void concurrent_checkout(bool affinity) {
+	const std::size_t CONNECTIONS = 4;
+	ember::drivers::DummyDriver driver;
+	FixedPool pool(driver, CONNECTIONS, CONNECTIONS, 300s);
+	pool.thread_affinity(affinity);
+	std::atomic<std::size_t> held { 0 };
+	std::atomic<bool> overcommitted { false };
+	std::vector<std::thread> threads;
+
+	for(int t = 0; t < 8; ++t) {
+		threads.emplace_back([&] {
+			for(int i = 0; i < 10000; ++i) {
+				try {
+					auto conn = pool.get_connection();
+
+					if(++held > CONNECTIONS) {
+						overcommitted = true;
+					}
+
+					--held;
+				} catch(ep::no_free_connections&) { }
+			}
+		});
+	}
+
+	for(auto& thread : threads) {
+		thread.join();
+	}
+
+	ASSERT_FALSE(overcommitted) << "A connection was handed out twice";
+	ASSERT_EQ(0, pool.checked_out());
+
+	// every connection should have made it back onto the free list
+	std::vector<ep::Connection<ember::DummyConnection>> conns;
+
+	for(std::size_t i = 0; i < CONNECTIONS; ++i) {
+		conns.emplace_back(pool.get_connection());
+	}
+}
+
+TEST(ConnectionPool, ConcurrentCheckout) {
+	concurrent_checkout(false);
+}
+
+TEST(ConnectionPool, ConcurrentAffineCheckout) {
+	concurrent_checkout(true);
+}
+
+TEST(ConnectionPool, WaitTimeout) {
+	ember::drivers::DummyDriver driver;
+	FixedPool pool(driver, 1, 1, 300s);
+	auto held = pool.get_connection();
+
+	const auto start = std::chrono::steady_clock::now();
+	ASSERT_THROW(pool.wait_connection(50ms), ep::no_free_connections);
+	ASSERT_GE(std::chrono::steady_clock::now() - start, 50ms);
+	ASSERT_THROW(pool.wait_connection(std::chrono::steady_clock::now()), ep::no_free_connections);
+
+	const auto stats = pool.reset_wait_stats();
+	ASSERT_EQ(0, stats.waiting) << "Timed out callers should leave the queue";
+	ASSERT_EQ(1, stats.peak_waiting);
+	ASSERT_EQ(2, stats.timeouts);
+}
+
+TEST(ConnectionPool, WaitHandOff) {
+	ember::drivers::DummyDriver driver;
+	FixedPool pool(driver, 1, 1, 300s);
+	auto held = pool.get_connection();
+
+	std::thread waiter([&] {
+		auto conn = pool.wait_connection(5s);
+	});
+
+	while(!pool.waiting()) {
+		std::this_thread::yield();
+	}
+
+	held.release();
+	waiter.join();
+
+	const auto stats = pool.reset_wait_stats();
+	ASSERT_EQ(1, stats.waits.count);
+	ASSERT_EQ(0, stats.timeouts);
+}
+
+TEST(ConnectionPool, WaitFIFO) {
+	const int WAITERS = 5;
+	ember::drivers::DummyDriver driver;
+	FixedPool pool(driver, 1, 1, 300s);
+	auto held = pool.get_connection();
+
+	std::mutex order_lock;
+	std::vector<int> order;
+	std::vector<std::thread> waiters;
+
+	// each waiter is queued before the next starts
+	for(int i = 0; i < WAITERS; ++i) {
+		waiters.emplace_back([&, i] {
+			auto conn = pool.wait_connection(5s);
+			std::lock_guard<std::mutex> guard(order_lock);
+			order.emplace_back(i);
+		});
+
+		while(pool.waiting() != static_cast<std::size_t>(i + 1)) {
+			std::this_thread::yield();
+		}
+	}
+
+	held.release();
+
+	for(auto& waiter : waiters) {
+		waiter.join();
+	}
+
+	ASSERT_EQ(WAITERS, order.size());
+
+	for(int i = 0; i < WAITERS; ++i) {
+		ASSERT_EQ(i, order[i]) << "Connections should be handed over in arrival order";
+	}
+}
+
+TEST(ConnectionPool, WaitExhausted) {
+	const std::size_t CONNECTIONS = 2;
+	ember::drivers::DummyDriver driver;
+	FixedPool pool(driver, CONNECTIONS, CONNECTIONS, 300s);
+	std::atomic<std::size_t> held { 0 };
+	std::atomic<bool> overcommitted { false };
+	std::vector<std::thread> threads;
+
+	for(int t = 0; t < 8; ++t) {
+		threads.emplace_back([&] {
+			for(int i = 0; i < 2000; ++i) {
+				auto conn = pool.wait_connection(5s);
+
+				if(++held > CONNECTIONS) {
+					overcommitted = true;
+				}
+
+				--held;
+			}
+		});
+	}
+
+	for(auto& thread : threads) {
+		thread.join();
+	}
+
+	ASSERT_FALSE(overcommitted) << "A connection was handed out twice";
+	ASSERT_EQ(0, pool.checked_out());
+
+	const auto stats = pool.reset_wait_stats();
+	ASSERT_EQ(0, stats.waiting);
+	ASSERT_EQ(0, stats.timeouts) << "Nobody should starve";
+	ASSERT_EQ(8 * 2000, stats.waits.count);
+}
+
+TEST(ConnectionPool, AsyncFuture) {
+	ember::drivers::DummyDriver driver;
+	FixedPool pool(driver, 2, 2, 300s);
+	ep::AsyncExecutor<FixedPool> executor(pool, 2, 16);
+
+	auto result = executor.submit([&](ember::DummyConnection) {
+		return pool.checked_out();
+	});
+
+	ASSERT_EQ(1, result.get()) << "Work should run while holding a connection";
+
+	auto error = executor.submit([](ember::DummyConnection) -> int {
+		throw std::runtime_error("query failed");
+	});
+
+	ASSERT_THROW(error.get(), std::runtime_error);
+}
+
+TEST(ConnectionPool, AsyncCallback) {
+	ember::drivers::DummyDriver driver;
+	FixedPool pool(driver, 1, 1, 300s);
+	ep::AsyncExecutor<FixedPool> executor(pool, 1, 16);
+	std::promise<int> done;
+	std::atomic<int> dispatched { 0 };
+
+	auto dispatcher = [&](std::function<void()> completion) {
+		++dispatched;
+		completion();
+	};
+
+	executor.submit([](ember::DummyConnection) {
+		return 42;
+	}, [&](std::future<int> result) {
+		done.set_value(result.get());
+	}, dispatcher);
+
+	ASSERT_EQ(42, done.get_future().get());
+	ASSERT_EQ(1, dispatched);
+}
+
+TEST(ConnectionPool, AsyncBacklog) {
+	ember::drivers::DummyDriver driver;
+	FixedPool pool(driver, 1, 1, 300s);
+	ep::AsyncExecutor<FixedPool> executor(pool, 1, 2);
+	std::promise<void> release;
+	std::promise<void> started;
+	auto blocker = release.get_future().share();
+
+	// occupy the only database thread so further work has to queue
+	auto first = executor.submit([&, blocker](ember::DummyConnection) {
+		started.set_value();
+		blocker.wait();
+	});
+
+	started.get_future().wait();
+
+	auto queued_a = executor.try_submit([](ember::DummyConnection) { return 1; });
+	auto queued_b = executor.try_submit([](ember::DummyConnection) { return 2; });
+	auto refused = executor.try_submit([](ember::DummyConnection) { return 3; });
+
+	ASSERT_TRUE(queued_a);
+	ASSERT_TRUE(queued_b);
+	ASSERT_FALSE(refused) << "Work beyond the backlog should be refused";
+	ASSERT_EQ(2, executor.queue_depth());
+
+	release.set_value();
+	first.get();
+	ASSERT_EQ(1, queued_a->get());
+	ASSERT_EQ(2, queued_b->get());
+}
+
+TEST(ConnectionPool, AsyncCheckoutFailure) {
+	ember::drivers::DummyDriver driver;
+	FixedPool pool(driver, 1, 1, 300s);
+	ep::AsyncExecutor<FixedPool> executor(pool, 1, 16, 10ms);
+	std::promise<void> failed;
+
+	{
+		auto held = pool.get_connection();
+
+		executor.submit([](ember::DummyConnection) {
+			return 1;
+		}, [&](std::future<int> result) {
+			ASSERT_THROW(result.get(), ep::no_free_connections);
+			failed.set_value();
+			throw std::runtime_error("callback failed");
+		});
+
+		failed.get_future().wait();
+	}
+
+	auto result = executor.submit([](ember::DummyConnection) {
+		return 2;
+	});
+
+	ASSERT_EQ(2, result.get()) << "A throwing callback shouldn't take the database thread down";
+}
+
+TEST(ConnectionPool, AsyncShutdownDrains) {
+	ember::drivers::DummyDriver driver;
+	FixedPool pool(driver, 2, 2, 300s);
+	std::atomic<int> completed { 0 };
+
+	{
+		ep::AsyncExecutor<FixedPool> executor(pool, 2, 0);
+
+		for(int i = 0; i < 100; ++i) {
+			executor.submit([&](ember::DummyConnection) {
+				++completed;
+			});
+		}
+
+		executor.shutdown();
+		ASSERT_THROW(executor.submit([](ember::DummyConnection) { }), ep::exception);
+	}
+
+	ASSERT_EQ(100, completed);
+	ASSERT_EQ(0, pool.checked_out()) << "Idle database threads should hand their connections back";
+}
+
+TEST(ConnectionPool, Stats) {
+	ember::drivers::DummyDriver driver;
+	DummyPool pool(driver, 1, 2, 300s);
+
+	{
+		auto first = pool.get_connection();
+		auto second = pool.get_connection();
+		ASSERT_THROW(pool.wait_connection(10ms), ep::no_free_connections);
+	}
+
+	const auto stats = pool.reset_stats();
+	ASSERT_EQ(2, stats.size);
+	ASSERT_EQ(2, stats.holds.count);
+	ASSERT_EQ(2, stats.opens.count) << "Should have opened the minimum and grown once";
+	ASSERT_EQ(1, stats.growth_events);
+	ASSERT_EQ(1, stats.wait.timeouts);
+
+	const auto reset = pool.reset_stats();
+	ASSERT_EQ(0, reset.holds.count);
+	ASSERT_EQ(0, reset.opens.count);
+	ASSERT_EQ(0, reset.growth_events);
+}
+
+TEST(ConnectionPool, ManagerStats) {
+	ember::drivers::DummyDriver driver;
+	FixedPool pool(driver, 2, 2, 0s, 1s);
+
+	{
+		auto first = pool.get_connection();
+		auto second = pool.get_connection();
+	}
+
+	// with no idle allowance, the manager's first pass refreshes every connection
+	std::uint64_t refreshes = 0, failures = 0, sweeps = 0;
+	const auto deadline = std::chrono::steady_clock::now() + 5s;
+
+	while(refreshes < 2 && std::chrono::steady_clock::now() < deadline) {
+		std::this_thread::sleep_for(50ms);
+		const auto stats = pool.reset_stats();
+		refreshes += stats.refreshes.count;
+		failures += stats.keep_alive_failures;
+		sweeps += stats.sweeps;
+	}
+
+	ASSERT_EQ(2, refreshes);
+	ASSERT_EQ(0, failures);
+	ASSERT_EQ(0, sweeps);
+}
\ No newline at end of file
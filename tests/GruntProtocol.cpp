@@ -15,6 +15,8 @@
 #include <memory>
 #include <string>
 #include <tuple>
+#include <unordered_map>
+#include <vector>
 #include <cstdint>
 
  /*
@@ -222,6 +224,56 @@ TEST(GruntProtocol, ServerLoginChallenge) {
 		<< "Serialisation failed (input != output)";
 }
 
+TEST(GruntProtocol, ServerLoginChallengeFailure) {
+	// failures are sent as just the header, the packet shouldn't wait for the rest
+	const unsigned char failure[] = { 0x00, 0x00, 0x0a };
+
+	spark::ChainedBuffer<1024> chain;
+	spark::SafeBinaryStream in_stream(chain);
+	chain.write(failure, sizeof(failure));
+
+	auto packet = grunt::server::LoginChallenge();
+	ASSERT_EQ(grunt::Packet::State::DONE, packet.read_from_stream(in_stream));
+	ASSERT_EQ(0, chain.size()) << "Read length incorrect";
+	ASSERT_EQ(grunt::Result::FAIL_VERSION_UPDATE, packet.result) << "field: result";
+	ASSERT_EQ(0, packet.protocol_ver) << "field: protocol_ver";
+}
+
+TEST(GruntProtocol, ServerLoginChallengePartial) {
+	const std::size_t packet_size = sizeof(server_login_challenge);
+
+	spark::ChainedBuffer<1024> chain;
+	spark::SafeBinaryStream in_stream(chain);
+	auto packet = grunt::server::LoginChallenge();
+
+	chain.write(server_login_challenge, 10);
+	ASSERT_EQ(grunt::Packet::State::CALL_AGAIN, packet.read_from_stream(in_stream));
+
+	chain.write(server_login_challenge + 10, packet_size - 10);
+	ASSERT_EQ(grunt::Packet::State::DONE, packet.read_from_stream(in_stream));
+	ASSERT_EQ(0, chain.size()) << "Read length incorrect";
+	ASSERT_EQ(7, packet.g) << "field: g [generator]";
+}
+
+TEST(GruntProtocol, ServerTransferInitiate) {
+	spark::ChainedBuffer<1024> chain;
+	spark::SafeBinaryStream in_stream(chain);
+	spark::BinaryStream out_stream(chain);
+
+	grunt::server::TransferInitiate initiate;
+	initiate.filename = "Survey";
+	initiate.filesize = 1024;
+	initiate.md5.fill(0x0f);
+	initiate.write_to_stream(out_stream);
+
+	auto packet = grunt::server::TransferInitiate();
+	ASSERT_EQ(grunt::Packet::State::DONE, packet.read_from_stream(in_stream));
+	ASSERT_EQ(0, chain.size()) << "Read length incorrect";
+	ASSERT_EQ("Survey", packet.filename) << "field: filename";
+	ASSERT_EQ(1024, packet.filesize) << "field: filesize";
+	ASSERT_EQ(initiate.md5, packet.md5) << "field: md5";
+}
+
 TEST(GruntProtocol, ServerLoginProof) {
 	const std::size_t packet_size = sizeof(server_login_proof);
 
@@ -311,6 +363,45 @@ TEST(GruntProtocol, ServerRealmList) {
 		<< "Serialisation failed (input != output)";
 }
 
+TEST(GruntProtocol, ServerRealmListTemplate) {
+	spark::ChainedBuffer<1024> chain;
+	spark::SafeBinaryStream in_stream(chain);
+	spark::BinaryStream out_stream(chain);
+	chain.write(realm_list, sizeof(realm_list));
+
+	grunt::server::RealmList packet;
+	packet.read_from_stream(in_stream);
+
+	std::vector<Realm> realms;
+
+	for(auto& entry : packet.realms) {
+		realms.emplace_back(entry.realm);
+	}
+
+	// serialise the expected output the slow way
+	const std::unordered_map<std::uint32_t, std::uint32_t> counts { { realms[1].id, 7 } };
+	packet.realms[1].characters = 7;
+	packet.write_to_stream(out_stream);
+
+	std::vector<char> expected(chain.size());
+	chain.read(expected.data(), expected.size());
+
+	// splice the counts into the template and make sure the output is identical
+	const grunt::server::RealmListTemplate list(realms);
+	grunt::server::RealmListResponse response(list, counts);
+	response.write_to_stream(out_stream);
+
+	ASSERT_EQ(expected.size(), chain.size()) << "Write length incorrect";
+
+	std::vector<char> buffer(chain.size());
+	chain.read(buffer.data(), buffer.size());
+
+	ASSERT_EQ(expected, buffer) << "Template output differs from the packet";
+	ASSERT_EQ(sizeof(realm_list), list.data.size()) << "Template should have no character counts";
+	ASSERT_EQ(0, memcmp(list.data.data(), realm_list, list.data.size()))
+		<< "Template should match the original packet";
+}
+
 TEST(GruntProtocol, ServerReconnectChallenge) {
 	const std::size_t packet_size = sizeof(server_reconnect_challenge);
 
@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) 2016 Ember
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <shared/metrics/Histogram.h>
+#include <gtest/gtest.h>
+#include <chrono>
+
+using namespace std::chrono_literals;
+
+TEST(Histogram, Empty) {
+	ember::Histogram histogram;
+	const auto snapshot = histogram.reset();
+	ASSERT_EQ(0, snapshot.count);
+	ASSERT_EQ(0, snapshot.percentile(99).count());
+}
+
+TEST(Histogram, Percentiles) {
+	ember::Histogram histogram;
+
+	for(int i = 1; i <= 1000; ++i) {
+		histogram.record(std::chrono::microseconds(i));
+	}
+
+	const auto snapshot = histogram.reset();
+	ASSERT_EQ(1000, snapshot.count);
+	ASSERT_EQ(1000, snapshot.max);
+
+	// buckets are a quarter of a power of two wide
+	const auto p50 = snapshot.percentile(50).count();
+	const auto p99 = snapshot.percentile(99).count();
+	ASSERT_GE(p50, 500);
+	ASSERT_LE(p50, 500 * 1.25);
+	ASSERT_GE(p99, 990);
+	ASSERT_LE(p99, 1000);
+}
+
+TEST(Histogram, Units) {
+	ember::Histogram histogram;
+	histogram.record(3ms);
+	histogram.record(-5us); // clock adjustments shouldn't produce huge values
+
+	const auto snapshot = histogram.reset();
+	ASSERT_EQ(2, snapshot.count);
+	ASSERT_EQ(3000, snapshot.max);
+	ASSERT_EQ(0, snapshot.percentile(0).count());
+}
+
+TEST(Histogram, Reset) {
+	ember::Histogram histogram;
+	histogram.record(10us);
+	ASSERT_EQ(1, histogram.reset().count);
+
+	const auto snapshot = histogram.reset();
+	ASSERT_EQ(0, snapshot.count);
+	ASSERT_EQ(0, snapshot.max);
+}
\ No newline at end of file
@@ -83,4 +83,68 @@ TEST_F(IPBanTest, Mask8) {
 	EXPECT_TRUE(bans->is_banned("198.255.255.255"));
 	EXPECT_FALSE(bans->is_banned("199.0.0.0"))
 		<< "Banned above range";
+}
+
+TEST_F(IPBanTest, IPv4Mapped) {
+	EXPECT_TRUE(bans->is_banned("::ffff:198.51.106.51"));
+	EXPECT_TRUE(bans->is_banned("::ffff:192.88.99.62"));
+	EXPECT_FALSE(bans->is_banned("::ffff:192.88.99.63"));
+}
+
+TEST(IPBan, IPv6) {
+	std::vector<ember::IPEntry> entries {
+		{ "2001:db8::",            32 },
+		{ "2001:db9:85a3::8a2e",  128 },
+		{ "fe80::1ff:fe23:4567",   64 }
+	};
+
+	ember::IPBanCache bans(entries);
+
+	EXPECT_TRUE(bans.is_banned("2001:db8::1"));
+	EXPECT_TRUE(bans.is_banned("2001:db8:ffff:ffff:ffff:ffff:ffff:ffff"));
+	EXPECT_FALSE(bans.is_banned("2001:db7:ffff:ffff:ffff:ffff:ffff:ffff"));
+	EXPECT_TRUE(bans.is_banned("2001:db9:85a3::8a2e"));
+	EXPECT_FALSE(bans.is_banned("2001:db9:85a3::8a2f"));
+	EXPECT_TRUE(bans.is_banned("fe80::abcd"));
+	EXPECT_FALSE(bans.is_banned("fe80:0:0:1::abcd"));
+	EXPECT_FALSE(bans.is_banned("198.51.106.51"));
+}
+
+TEST(IPBan, NestedRanges) {
+	std::vector<ember::IPEntry> entries {
+		{ "10.1.2.3",  32 },
+		{ "10.0.0.0",   8 },
+		{ "10.1.0.0",  16 },
+		{ "10.128.0.0", 9 }
+	};
+
+	ember::IPBanCache bans(entries);
+
+	EXPECT_TRUE(bans.is_banned("10.1.2.3"));
+	EXPECT_TRUE(bans.is_banned("10.1.2.4"));
+	EXPECT_TRUE(bans.is_banned("10.200.0.1"));
+	EXPECT_TRUE(bans.is_banned("10.255.255.255"));
+	EXPECT_FALSE(bans.is_banned("11.0.0.0"));
+	EXPECT_FALSE(bans.is_banned("9.255.255.255"));
+}
+
+TEST(IPBan, LongestPrefix) {
+	ember::PrefixTrie<4> trie;
+	trie.insert({ 10, 0, 0, 0 }, 8);
+	trie.insert({ 10, 1, 0, 0 }, 16);
+	trie.insert({ 10, 1, 2, 0 }, 24);
+
+	EXPECT_EQ(24, *trie.match({ 10, 1, 2, 3 }));
+	EXPECT_EQ(16, *trie.match({ 10, 1, 3, 3 }));
+	EXPECT_EQ(8, *trie.match({ 10, 2, 3, 3 }));
+	EXPECT_FALSE(trie.match({ 11, 1, 2, 3 }));
+}
+
+TEST(IPBan, Reload) {
+	ember::IPBanCache bans({ { "192.0.2.0", 24 } });
+	EXPECT_TRUE(bans.is_banned("192.0.2.1"));
+
+	bans.reload({ { "198.51.100.0", 24 } });
+	EXPECT_FALSE(bans.is_banned("192.0.2.1"));
+	EXPECT_TRUE(bans.is_banned("198.51.100.1"));
 }
\ No newline at end of file
@@ -30,4 +30,48 @@ TEST(PatcherTest, VersionChecks) {
 
 	ASSERT_EQ(Patcher::PatchLevel::TOO_OLD, patcher.check_version(version_too_old))
 		<< "Build should have been rejected as too old";
+}
+
+TEST(PatcherTest, Routing) {
+	const std::vector<PatchMeta> patches {
+		{ 1, 5302, 5464, 0, 0, 0, "x86", "enUS", "Win", false, false, { "", "", {}, 50 } },
+		{ 2, 5464, 5875, 0, 0, 0, "x86", "enUS", "Win", false, false, { "", "", {}, 100 } },
+		{ 3, 5302, 5875, 0, 0, 0, "x86", "enUS", "Win", false, false, { "", "", {}, 200 } },
+		{ 4, 4000, 5302, 0, 0, 0, "x86", "enUS", "Win", false, true, { "", "", {}, 500 } }
+	};
+
+	Patcher patcher(versions, patches);
+	const auto locale = grunt::Locale::enUS;
+	const auto platform = grunt::Platform::x86;
+	const auto os = grunt::System::Win;
+
+	// two smaller patches should be preferred over the larger direct patch
+	auto patch = patcher.find_patch({ 1, 1, 2, 5302 }, locale, platform, os);
+	ASSERT_TRUE(patch);
+	ASSERT_EQ(5302, patch->build_from);
+	ASSERT_EQ(5464, patch->build_to);
+
+	// builds outside of the graph should be routed through the rollup
+	patch = patcher.find_patch({ 1, 1, 0, 4500 }, locale, platform, os);
+	ASSERT_TRUE(patch);
+	ASSERT_EQ(4000, patch->build_from);
+	ASSERT_TRUE(patch->rollup);
+
+	ASSERT_FALSE(patcher.find_patch({ 1, 0, 0, 3000 }, locale, platform, os))
+		<< "No rollup covers this build";
+
+	ASSERT_FALSE(patcher.find_patch({ 1, 1, 2, 5302 }, grunt::Locale::deDE, platform, os))
+		<< "No patches exist for this locale";
+
+	bool found = false;
+
+	for(auto& route : patcher.routes()->routes()) {
+		if(route.from == 5302) {
+			ASSERT_EQ(150, route.cost);
+			ASSERT_EQ(2, route.hops);
+			found = true;
+		}
+	}
+
+	ASSERT_TRUE(found) << "Route from 5302 was not reported";
 }
\ No newline at end of file
@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) 2016 Ember
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <login/RateLimiter.h>
+#include <gtest/gtest.h>
+#include <boost/asio/ip/address.hpp>
+#include <chrono>
+
+using ember::RateLimiter;
+using boost::asio::ip::address;
+
+TEST(RateLimiter, Disabled) {
+	RateLimiter limiter(64, 0, 1);
+
+	for(int i = 0; i < 100; ++i) {
+		ASSERT_TRUE(limiter.admit(1));
+	}
+
+	ASSERT_FALSE(limiter.enabled());
+}
+
+TEST(RateLimiter, Burst) {
+	RateLimiter limiter(64, 1, 5);
+	const auto now = RateLimiter::Clock::now();
+
+	for(int i = 0; i < 5; ++i) {
+		ASSERT_TRUE(limiter.admit(1, now));
+	}
+
+	ASSERT_FALSE(limiter.admit(1, now));
+	ASSERT_TRUE(limiter.admit(2, now)) << "Keys should not share an allowance";
+
+	const auto counters = limiter.reset_counters();
+	ASSERT_EQ(6, counters.admitted);
+	ASSERT_EQ(1, counters.shed);
+}
+
+TEST(RateLimiter, Refill) {
+	RateLimiter limiter(64, 2, 2);
+	auto now = RateLimiter::Clock::now();
+
+	ASSERT_TRUE(limiter.admit(1, now));
+	ASSERT_TRUE(limiter.admit(1, now));
+	ASSERT_FALSE(limiter.admit(1, now));
+
+	now += std::chrono::milliseconds(500);
+	ASSERT_TRUE(limiter.admit(1, now));
+	ASSERT_FALSE(limiter.admit(1, now));
+
+	// the allowance never builds beyond the burst size
+	now += std::chrono::hours(1);
+	ASSERT_TRUE(limiter.admit(1, now));
+	ASSERT_TRUE(limiter.admit(1, now));
+	ASSERT_FALSE(limiter.admit(1, now));
+}
+
+TEST(RateLimiter, Strings) {
+	RateLimiter limiter(64, 1, 1);
+	ASSERT_TRUE(limiter.admit("CHAOSVEX"));
+	ASSERT_FALSE(limiter.admit("CHAOSVEX"));
+	ASSERT_TRUE(limiter.admit("ANOTHERUSER"));
+}
+
+TEST(RateLimiter, AddressPrefix) {
+	const auto key = [](const char* ip, std::size_t v4, std::size_t v6) {
+		return ember::address_key(address::from_string(ip), v4, v6);
+	};
+
+	ASSERT_NE(key("10.0.0.1", 32, 64), key("10.0.0.2", 32, 64));
+	ASSERT_EQ(key("10.0.0.1", 24, 64), key("10.0.0.2", 24, 64));
+	ASSERT_NE(key("10.0.1.1", 24, 64), key("10.0.0.1", 24, 64));
+	ASSERT_EQ(key("10.0.0.1", 32, 64), key("::ffff:10.0.0.1", 32, 64));
+	ASSERT_EQ(key("2001:db8::1", 32, 64), key("2001:db8::ffff", 32, 64));
+	ASSERT_NE(key("2001:db8::1", 32, 64), key("2001:db8:0:1::1", 32, 64));
+	ASSERT_NE(key("2001:db8::1", 32, 128), key("2001:db8::2", 32, 128));
+}
\ No newline at end of file
@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) 2016 Ember
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <login/UserCache.h>
+#include <gtest/gtest.h>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <cstdint>
+
+namespace {
+
+ember::UserCache::Record make_user(std::uint32_t id, const std::string& username) {
+	ember::User user(id, username, "0x1234", "0x5678", ember::PINMethod::NONE, 0, "",
+	                 false, false, false, true);
+	return std::make_shared<const ember::CachedUser>(std::move(user));
+}
+
+} // unnamed
+
+TEST(UserCache, HitAndMiss) {
+	ember::UserCache cache(4, std::chrono::seconds(60), std::chrono::seconds(60));
+	ember::UserCache::Record record;
+
+	ASSERT_FALSE(cache.find("CHAOSVEX", record));
+	cache.store("CHAOSVEX", make_user(1, "CHAOSVEX"));
+	ASSERT_TRUE(cache.find("CHAOSVEX", record));
+	ASSERT_TRUE(record);
+	ASSERT_EQ(1, record->user.id());
+	ASSERT_EQ(Botan::BigInt(0x5678), record->verifier);
+
+	// unknown accounts are cached as null records
+	cache.store("UNKNOWN", nullptr);
+	ASSERT_TRUE(cache.find("UNKNOWN", record));
+	ASSERT_FALSE(record);
+
+	const auto counters = cache.reset_counters();
+	ASSERT_EQ(2, counters.hits);
+	ASSERT_EQ(1, counters.misses);
+}
+
+TEST(UserCache, Eviction) {
+	ember::UserCache cache(2, std::chrono::seconds(60), std::chrono::seconds(60));
+	ember::UserCache::Record record;
+
+	cache.store("A", make_user(1, "A"));
+	cache.store("B", make_user(2, "B"));
+	ASSERT_TRUE(cache.find("A", record)); // B is now the least recently used
+	cache.store("C", make_user(3, "C"));
+
+	ASSERT_EQ(2, cache.size());
+	ASSERT_TRUE(cache.find("A", record));
+	ASSERT_FALSE(cache.find("B", record));
+	ASSERT_TRUE(cache.find("C", record));
+}
+
+TEST(UserCache, Expiry) {
+	ember::UserCache cache(2, std::chrono::seconds(60), std::chrono::seconds(0));
+	ember::UserCache::Record record;
+
+	cache.store("UNKNOWN", nullptr);
+	ASSERT_FALSE(cache.find("UNKNOWN", record));
+	ASSERT_EQ(0, cache.size());
+}
+
+TEST(UserCache, Invalidation) {
+	ember::UserCache cache(4, std::chrono::seconds(60), std::chrono::seconds(60));
+	ember::UserCache::Record record;
+
+	cache.store("A", make_user(1, "A"));
+	cache.store("B", make_user(2, "B"));
+
+	cache.invalidate(1);
+	ASSERT_FALSE(cache.find("A", record));
+
+	cache.invalidate("B");
+	ASSERT_FALSE(cache.find("B", record));
+	ASSERT_EQ(0, cache.size());
+}
\ No newline at end of file
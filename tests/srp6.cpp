@@ -10,10 +10,13 @@
 #include <srp6/Server.h>
 #include <srp6/Client.h>
 #include <srp6/Generator.h>
+#include <botan/auto_rng.h>
 #include <botan/bigint.h>
+#include <botan/numthry.h>
 #include <botan/secmem.h>
 #include <memory>
 #include <string>
+#include <vector>
 
 namespace srp = ember::srp6;
 
@@ -162,4 +165,113 @@ TEST_F(srp6SessionTest, ClientZeroEphemeral) {
 TEST_F(srp6SessionTest, ClientNegativeEphemeral) {
 	EXPECT_THROW(client_->session_key(Botan::BigInt("-10"), salt_), srp::exception)
 		<< "Public ephemeral key should never be negative!";
+}
+
+/*
+ * The precomputed fixed-base tables must produce exactly the same results as
+ * the generic exponentiation, including for exponents too wide for the table
+ */
+TEST(srp6, FixedBaseExponentiation) {
+	const srp::Generator::Group groups[] = {
+		srp::Generator::Group::_256_BIT, srp::Generator::Group::_1024_BIT,
+		srp::Generator::Group::_1536_BIT, srp::Generator::Group::_2048_BIT,
+		srp::Generator::Group::_3072_BIT, srp::Generator::Group::_4096_BIT,
+		srp::Generator::Group::_6144_BIT, srp::Generator::Group::_8192_BIT
+	};
+
+	Botan::AutoSeeded_RNG rng;
+
+	for(auto group : groups) {
+		srp::Generator gen(group);
+
+		std::vector<Botan::BigInt> exponents {
+			0, 1, 15, 16, Botan::BigInt::power_of_2(255),
+			Botan::BigInt::power_of_2(256) - 1,  // widest exponent covered by the table
+			Botan::BigInt::power_of_2(256),      // falls back to power_mod
+			Botan::BigInt::decode(rng.random_vec(64))
+		};
+
+		for(int i = 0; i < 8; ++i) {
+			exponents.emplace_back(Botan::BigInt::decode(rng.random_vec(32)));
+		}
+
+		for(auto& x : exponents) {
+			EXPECT_EQ(Botan::power_mod(gen.generator(), x, gen.prime()), gen(x))
+				<< "Fixed-base exponentiation mismatch for exponent " << x;
+		}
+	}
+}
+
+/*
+ * The server combines both of its session key exponentiations - make sure
+ * the result is bit-exact with the textbook (A * v^u)^b mod N
+ */
+TEST(srp6, ServerMultiExponentiation) {
+	const srp::Generator::Group groups[] = {
+		srp::Generator::Group::_256_BIT, srp::Generator::Group::_1024_BIT,
+		srp::Generator::Group::_2048_BIT, srp::Generator::Group::_4096_BIT
+	};
+
+	Botan::AutoSeeded_RNG rng;
+
+	for(auto group : groups) {
+		srp::Generator gen(group);
+		const auto& N = gen.prime();
+
+		for(int i = 0; i < 4; ++i) {
+			Botan::BigInt v = Botan::BigInt::decode(rng.random_vec(N.bytes())) % N;
+			Botan::BigInt b = Botan::BigInt::decode(rng.random_vec(32)) % N;
+			Botan::BigInt A = Botan::BigInt::decode(rng.random_vec(N.bytes())) % N;
+
+			srp::Server server(gen, v, b);
+			srp::SessionKey key = server.session_key(A, srp::Compliance::RFC5054);
+
+			Botan::BigInt u = srp::detail::scrambler(A, server.public_ephemeral(), N.bytes(),
+			                                         srp::Compliance::RFC5054);
+			Botan::BigInt S = Botan::power_mod(A * Botan::power_mod(v, u, N), b, N);
+
+			EXPECT_EQ(Botan::BigInt::encode(S), static_cast<std::vector<Botan::byte>>(key))
+				<< "Server session key did not match the reference calculation!";
+		}
+	}
+}
+
+/*
+ * Shortening v^(ub) by reducing the exponent mod N - 1 is only valid for a
+ * prime modulus, so a caller-supplied group must still get the textbook key
+ */
+TEST(srp6, ServerCompositeModulus) {
+	const srp::Generator group(srp::Generator::Group::_1024_BIT);
+	const Botan::BigInt N = group.prime() * 3;
+	const srp::Generator gen(group.generator(), N);
+
+	Botan::AutoSeeded_RNG rng;
+	Botan::BigInt v = Botan::BigInt::decode(rng.random_vec(N.bytes())) % N;
+	Botan::BigInt b = Botan::BigInt::decode(rng.random_vec(32));
+	Botan::BigInt A = Botan::BigInt::decode(rng.random_vec(N.bytes() - 1)) + 1;
+
+	srp::Server server(gen, v, b);
+	srp::SessionKey key = server.session_key(A, srp::Compliance::RFC5054);
+
+	Botan::BigInt u = srp::detail::scrambler(A, server.public_ephemeral(), N.bytes(),
+	                                         srp::Compliance::RFC5054);
+	Botan::BigInt S = Botan::power_mod(A * Botan::power_mod(v, u, N), b, N);
+
+	EXPECT_EQ(Botan::BigInt::encode(S), static_cast<std::vector<Botan::byte>>(key))
+		<< "Server session key did not match the reference calculation!";
+}
+
+TEST(srp6, PrecomputedEphemeral) {
+	srp::Generator gen(srp::Generator::Group::_256_BIT);
+	Botan::BigInt verifier("0x37A75AE5BCF38899C75D28688C78434CB690657B5D8D77463668B83D0062A186");
+	Botan::BigInt A("59852229564408135463856204462249479723343699701058170755060257585995770179058");
+
+	const auto ephemeral = srp::precompute_ephemeral(gen);
+	srp::Server precomputed(gen, verifier, ephemeral);
+	srp::Server server(gen, verifier, ephemeral.b);
+
+	EXPECT_EQ(server.public_ephemeral(), precomputed.public_ephemeral())
+		<< "Public ephemeral from the precomputed key pair did not match!";
+	EXPECT_EQ(server.session_key(A), precomputed.session_key(A))
+		<< "Session key from the precomputed key pair did not match!";
 }
\ No newline at end of file